@@ -104,7 +104,7 @@ int CellularHelperStringResponse::parse(int type, const char *buf, int len) {
 		logCellularDebug(type, buf, len);
 	}
 	if (type == TYPE_UNKNOWN) {
-		CellularHelperClass::appendBufferToString(string, buf, len, true);
+		CellularHelperClass::appendBufferToArray(string, sizeof(string), buf, len, true);
 	}
 	return WAIT;
 }
@@ -115,31 +115,18 @@ int CellularHelperPlusStringResponse::parse(int type, const char *buf, int len)
 		logCellularDebug(type, buf, len);
 	}
 	if (type == TYPE_PLUS) {
-		// Copy to temporary string to make processing easier
-		char *copy = (char *) malloc(len + 1);
-		if (copy) {
-			strncpy(copy, buf, len);
-			copy[len] = 0;
-
-			// We return the parts of the + response corresponding to the command we requested
-			char searchFor[32];
-			snprintf(searchFor, sizeof(searchFor), "\n+%s: ", command.c_str());
-
-			//Log.info("searching for: +%s:", command.c_str());
-
-			char *start = strstr(copy, searchFor);
-			if (start) {
-				start += strlen(searchFor);
-
-				char *end = strchr(start, '\r');
-				CellularHelperClass::appendBufferToString(string, start, end - start);
-				//Log.info("found %s", string.c_str());
-			}
-			else {
-				//Log.info("not found");
+		// We return the parts of the + response corresponding to the command we requested,
+		// searched for in place: the callback's buffer isn't null terminated
+		size_t commandLen = strlen(command);
+		const char *end = buf + len;
+		for(const char *cp = buf; cp + commandLen + 4 <= end; cp++) {
+			if (cp[0] == '\n' && cp[1] == '+' && strncmp(&cp[2], command, commandLen) == 0 &&
+				cp[commandLen + 2] == ':' && cp[commandLen + 3] == ' ') {
+				const char *start = cp + commandLen + 4;
+				const char *lineEnd = (const char *)memchr(start, '\r', end - start);
+				CellularHelperClass::appendBufferToArray(string, sizeof(string), start, (lineEnd ? lineEnd : end) - start);
+				break;
 			}
-
-			free(copy);
 		}
 	}
 	return WAIT;
@@ -148,11 +135,12 @@ int CellularHelperPlusStringResponse::parse(int type, const char *buf, int len)
 String CellularHelperPlusStringResponse::getDoubleQuotedPart(bool onlyFirst) const {
 	String result;
 	bool inQuoted = false;
+	size_t len = strlen(string);
 
-	result.reserve(string.length());
+	result.reserve(len);
 
-	for(size_t ii = 0; ii < string.length(); ii++) {
-		char ch = string.charAt(ii);
+	for(size_t ii = 0; ii < len; ii++) {
+		char ch = string[ii];
 		if (ch == '"') {
 			inQuoted = !inQuoted;
 			if (!inQuoted && onlyFirst) {
@@ -171,7 +159,7 @@ String CellularHelperPlusStringResponse::getDoubleQuotedPart(bool onlyFirst) con
 
 
 void CellularHelperRSSIQualResponse::postProcess() {
-	if (sscanf(string.c_str(), "%d,%d", &rssi, &qual) == 2) {
+	if (sscanf(string, "%d,%d", &rssi, &qual) == 2) {
 
 		// The range is the following:
 		// 0: -113 dBm or less
@@ -203,7 +191,7 @@ String CellularHelperRSSIQualResponse::toString() const {
 void CellularHelperExtendedQualResponse::postProcess() {
 	int values[6];
 
-	if (sscanf(string.c_str(), "%d,%d,%d,%d,%d,%d", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]) == 6) {
+	if (sscanf(string, "%d,%d,%d,%d,%d,%d", &values[0], &values[1], &values[2], &values[3], &values[4], &values[5]) == 6) {
 
 		rxlev = (uint8_t) values[0];
 		ber = (uint8_t) values[1];
@@ -243,82 +231,100 @@ int CellularHelperEnvironmentResponse::parse(int type, const char *buf, int len)
 
 	if (type == TYPE_UNKNOWN || type == TYPE_PLUS) {
 		// We get this for AT+CGED=5
-		// Copy to temporary string to make processing easier
-		char *copy = (char *) malloc(len + 1);
-		if (copy) {
-			strncpy(copy, buf, len);
-			copy[len] = 0;
-
-			// This is used for skipping over the +CGED: part of the response
-			char searchFor[32];
-			size_t searchForLen = snprintf(searchFor, sizeof(searchFor), "+%s: ", command.c_str());
-
-			char *endStr;
-
-			char *line = strtok_r(copy, "\r\n", &endStr);
-			while(line) {
-				if (line[0]) {
-					// Not an empty line
-
-					if (type == TYPE_PLUS && strncmp(line, searchFor, searchForLen) == 0) {
-						line += searchForLen;
-					}
-
-					if (strncmp(line, "MCC:", 4) == 0) {
-						// Line begins with MCC:
-						// This happens for 2G and 3G
-						if (curDataIndex < 0) {
-							service.parse(line);
-							curDataIndex++;
-						}
-						else
-						if (neighbors && (size_t)curDataIndex < numNeighbors) {
-							neighbors[curDataIndex++].parse(line);
-						}
-					}
-					else
-					if (strncmp(line, "RAT:", 4) == 0) {
-						// Line begins with RAT:
-						// This happens for 3G in the + response so you know whether
-						// the response is for a 2G or 3G tower
-						service.parse(line);
-					}
-				}
-				line = strtok_r(NULL, "\r\n", &endStr);
+		// Walk the lines in place; nothing is copied to the heap
+		const char *end = buf + len;
+		const char *line = buf;
+		while(line < end) {
+			const char *lineEnd = line;
+			while(lineEnd < end && *lineEnd != '\r' && *lineEnd != '\n') {
+				lineEnd++;
 			}
-
-			free(copy);
+			if (lineEnd > line) {
+				// Not an empty line
+				parseLine(type, line, lineEnd - line);
+			}
+			line = lineEnd + 1;
 		}
 	}
 	return WAIT;
 }
 
+void CellularHelperEnvironmentResponse::parseLine(int type, const char *line, size_t len) {
+	// Skip over the +CGED: part of the response
+	size_t commandLen = strlen(command);
+	if (type == TYPE_PLUS && len > commandLen + 3 && line[0] == '+' && strncmp(&line[1], command, commandLen) == 0 &&
+		line[commandLen + 1] == ':' && line[commandLen + 2] == ' ') {
+		line += commandLen + 3;
+		len -= commandLen + 3;
+	}
+
+	if (len >= 4 && strncmp(line, "MCC:", 4) == 0) {
+		// Line begins with MCC:
+		// This happens for 2G and 3G
+		if (curDataIndex < 0) {
+			service.parse(line, len);
+			curDataIndex++;
+		}
+		else
+		if (neighbors && (size_t)curDataIndex < numNeighbors) {
+			neighbors[curDataIndex++].parse(line, len);
+		}
+	}
+	else
+	if (len >= 4 && strncmp(line, "RAT:", 4) == 0) {
+		// Line begins with RAT:
+		// This happens for 3G in the + response so you know whether
+		// the response is for a 2G or 3G tower
+		service.parse(line, len);
+	}
+}
+
 void CellularHelperEnvironmentCellData::parse(const char *str) {
-	char *mutableCopy = strdup(str);
+	parse(str, strlen(str));
+}
 
-	char *endStr;
+void CellularHelperEnvironmentCellData::parse(const char *str, size_t len) {
+	// Each comma separated pair is copied into small stack buffers so the values can be
+	// null terminated for atoi/strtol
+	char key[16];
+	char value[24];
+
+	const char *end = str + len;
+	const char *pair = str;
+	while(pair < end) {
+		const char *pairEnd = pair;
+		while(pairEnd < end && *pairEnd != ',') {
+			pairEnd++;
+		}
 
-	char *pair = strtok_r(mutableCopy, ",", &endStr);
-	while(pair) {
 		// Remove leading spaces caused by ", " combination
-		while(*pair == ' ') {
+		while(pair < pairEnd && *pair == ' ') {
 			pair++;
 		}
 
-		char *colon = strchr(pair, ':');
-		if (colon != NULL) {
-			*colon = 0;
-			const char *key = pair;
-			const char *value = ++colon;
-
-			addKeyValue(key, value);
+		const char *colon = pair;
+		while(colon < pairEnd && *colon != ':') {
+			colon++;
 		}
 
-		pair = strtok_r(NULL, ",", &endStr);
-	}
+		if (colon < pairEnd) {
+			size_t keyLen = colon - pair;
+			size_t valueLen = pairEnd - (colon + 1);
+			if (keyLen < sizeof(key) && valueLen < sizeof(value)) {
+				memcpy(key, pair, keyLen);
+				key[keyLen] = 0;
+				memcpy(value, colon + 1, valueLen);
+				value[valueLen] = 0;
 
+				addKeyValue(key, value);
+			}
+			else {
+				Log.info("pair too long len=%u", (unsigned)(pairEnd - pair));
+			}
+		}
 
-	free(mutableCopy);
+		pair = pairEnd + 1;
+	}
 }
 
 bool CellularHelperEnvironmentCellData::isValid(bool ignoreCI) const {
@@ -737,45 +743,44 @@ size_t CellularHelperEnvironmentResponse::getNumNeighbors() const {
 // +UULOC: <date>,<time>,<lat>,<long>,<alt>,<uncertainty>
 
 void CellularHelperLocationResponse::postProcess() {
-	char *mutableCopy = strdup(string.c_str());
-	if (mutableCopy) {
-		char *part, *endStr;
+	// strtok_r writes into its input, so work on a stack copy and leave string as received
+	char mutableCopy[sizeof(string)];
+	strcpy(mutableCopy, string);
+
+	char *part, *endStr;
 
-		part = strtok_r(mutableCopy, ",", &endStr);
+	part = strtok_r(mutableCopy, ",", &endStr);
+	if (part) {
+		// part is date
+		part = strtok_r(NULL, ",", &endStr);
 		if (part) {
-			// part is date
+			// part is time
 			part = strtok_r(NULL, ",", &endStr);
 			if (part) {
-				// part is time
+				// part is lat
+				lat = atof(part);
+
 				part = strtok_r(NULL, ",", &endStr);
 				if (part) {
-					// part is lat
-					lat = atof(part);
+					// part is lon
+					lon = atof(part);
 
 					part = strtok_r(NULL, ",", &endStr);
 					if (part) {
-						// part is lon
-						lon = atof(part);
+						// part is alt
+						alt = atoi(part);
 
 						part = strtok_r(NULL, ",", &endStr);
 						if (part) {
-							// part is alt
-							alt = atoi(part);
-
-							part = strtok_r(NULL, ",", &endStr);
-							if (part) {
-								// part is uncertainty
-								uncertainty = atoi(part);
-								valid = true;
-								resp = RESP_OK;
-							}
+							// part is uncertainty
+							uncertainty = atoi(part);
+							valid = true;
+							resp = RESP_OK;
 						}
 					}
 				}
 			}
 		}
-
-		free(mutableCopy);
 	}
 }
 
@@ -792,12 +797,12 @@ void CellularHelperCREGResponse::postProcess() {
 	// "\r\n+CREG: 2,1,\"FFFE\",\"C45C010\",8\r\n"
 	int n;
 
-	if (sscanf(string.c_str(), "%d,%d,\"%x\",\"%x\",%d", &n, &stat, &lac, &ci, &rat) == 5) {
+	if (sscanf(string, "%d,%d,\"%x\",\"%x\",%d", &n, &stat, &lac, &ci, &rat) == 5) {
 		// SARA-R4 does include the n (5 parameters)
 		valid = true;
 	}
 	else
-	if (sscanf(string.c_str(), "%d,\"%x\",\"%x\",%d", &stat, &lac, &ci, &rat) == 4) {
+	if (sscanf(string, "%d,\"%x\",\"%x\",%d", &stat, &lac, &ci, &rat) == 4) {
 		// SARA-U and SARA-G don't include the n (4 parameters)
 		valid = true;
 	}
@@ -825,59 +830,56 @@ int CellularHelperUCGEDResponse::parse(int type, const char *buf, int len) {
 		logCellularDebug(type, buf, len);
 	}
 	if (type == TYPE_PLUS) {
-		// Copy to temporary string to make processing easier
-		char *copy = (char *) malloc(len + 1);
-		if (copy) {
-			strncpy(copy, buf, len);
-			copy[len] = 0;
-
-			// +RSRP: 162,5110,"-075.00",
-			// +RSRQ: 162,5110,"-14.20",
-			// OK
-
-			char *cp = copy;
-			while(*cp && *cp != '+') {
-				cp++;
-			}
-			if (*cp == '+') {
-				cp++;
-			}
+		// Copy to a null terminated stack buffer to make processing easier. The lines are short,
+		// anything past the buffer is only trailing fields
+		char copy[CELLULAR_HELPER_STRING_SIZE];
+		size_t copyLen = (size_t)len < sizeof(copy) - 1 ? (size_t)len : sizeof(copy) - 1;
+		memcpy(copy, buf, copyLen);
+		copy[copyLen] = 0;
+
+		// +RSRP: 162,5110,"-075.00",
+		// +RSRQ: 162,5110,"-14.20",
+		// OK
+
+		char *cp = copy;
+		while(*cp && *cp != '+') {
+			cp++;
+		}
+		if (*cp == '+') {
+			cp++;
+		}
 
-			// Skip over "RSRP: " or "RSRQ: "
-			char *resp = cp;
-			cp += 6;
+		// Skip over "RSRP: " or "RSRQ: "
+		char *resp = cp;
+		cp += 6;
 
-			cp = strtok(cp, ",");
+		cp = strtok(cp, ",");
+		if (cp) {
+			// pcid
+			cp = strtok(NULL, ",");
 			if (cp) {
-				// pcid
+				// earfcn
+				earfcn = atoi(cp);
+
 				cp = strtok(NULL, ",");
 				if (cp) {
-					// earfcn
-					earfcn = atoi(cp);
-
-					cp = strtok(NULL, ",");
-					if (cp) {
-						// value
-						if (*cp == '"') {
-							cp++;
-							char *end = strchr(cp, '"');
-							if (end) {
-								*end = 0;
-							}
-						}
-						if (strncmp(resp, "RSRP", 4) == 0) {
-							rsrp = cp;
-						}
-						else
-						if (strncmp(resp, "RSRQ", 4) == 0) {
-							rsrq = cp;
+					// value
+					if (*cp == '"') {
+						cp++;
+						char *end = strchr(cp, '"');
+						if (end) {
+							*end = 0;
 						}
 					}
+					if (strncmp(resp, "RSRP", 4) == 0) {
+						rsrp = cp;
+					}
+					else
+					if (strncmp(resp, "RSRQ", 4) == 0) {
+						rsrq = cp;
+					}
 				}
 			}
-
-
-			free(copy);
 		}
 	}
 	return WAIT;
@@ -900,24 +902,35 @@ CellularHelperQNWINFOResponse::~CellularHelperQNWINFOResponse() {
 }
 
 void CellularHelperQNWINFOResponse::postProcess() {
-	// Log.info("string: %s", string.c_str());
+	// Log.info("string: %s", string);
 
 	// "CAT-M1","310410","LTE BAND 12",5110
 
-	char *copy = (char *) malloc(string.length() + 1);
-	if (copy) {
-		strncpy(copy, string.c_str(), string.length());
-		copy[string.length()] = 0;
+	// strtok_r writes into its input, so work on a stack copy and leave string as received
+	char copy[sizeof(string)];
+	strcpy(copy, string);
+
+	char *endStr, *param, *cp;
 
-		char *endStr, *param, *cp;
+	param = strtok_r(copy, ",", &endStr);
+	if (param) {
+		cp = strchr(&param[1], '"');
+		if (*cp) {
+			*cp = 0;
+		}
+		act = &param[1];
 
-		param = strtok_r(copy, ",", &endStr);
+		param = strtok_r(NULL, ",", &endStr);
 		if (param) {
 			cp = strchr(&param[1], '"');
 			if (*cp) {
 				*cp = 0;
 			}
-			act = &param[1];
+			size_t len = strlen(&param[1]);
+			mnc = atoi(&param[1 + len - 3]);
+			param[1 + len - 3] = 0;
+			mcc = atoi(&param[1]);
+			// Log.info("mcc=%d mnc=%d", mcc, mnc);
 
 			param = strtok_r(NULL, ",", &endStr);
 			if (param) {
@@ -925,30 +938,15 @@ void CellularHelperQNWINFOResponse::postProcess() {
 				if (*cp) {
 					*cp = 0;
 				}
-				size_t len = strlen(&param[1]);
-				mnc = atoi(&param[1 + len - 3]);
-				param[1 + len - 3] = 0;
-				mcc = atoi(&param[1]);
-				// Log.info("mcc=%d mnc=%d", mcc, mnc);
+				band = &param[1];
 
 				param = strtok_r(NULL, ",", &endStr);
 				if (param) {
-					cp = strchr(&param[1], '"');
-					if (*cp) {
-						*cp = 0;
-					}
-					band = &param[1];
-
-					param = strtok_r(NULL, ",", &endStr);
-					if (param) {
-						channel = atoi(param);
-					}
-
+					channel = atoi(param);
 				}
+
 			}
 		}
-		
-		free(copy);
 	}
 }
 
@@ -960,7 +958,7 @@ String CellularHelperClass::getManufacturer() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "AT+CGMI\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 String CellularHelperClass::getModel() const {
@@ -968,7 +966,7 @@ String CellularHelperClass::getModel() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "AT+CGMM\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 String CellularHelperClass::getOrderingCode() const {
@@ -976,7 +974,7 @@ String CellularHelperClass::getOrderingCode() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "ATI0\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 String CellularHelperClass::getFirmwareVersion() const {
@@ -984,7 +982,7 @@ String CellularHelperClass::getFirmwareVersion() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "AT+CGMR\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 String CellularHelperClass::getIMEI() const {
@@ -992,7 +990,7 @@ String CellularHelperClass::getIMEI() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "AT+CGSN\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 String CellularHelperClass::getIMSI() const {
@@ -1000,7 +998,7 @@ String CellularHelperClass::getIMSI() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "AT+CGMI\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 String CellularHelperClass::getICCID() const {
@@ -1009,7 +1007,7 @@ String CellularHelperClass::getICCID() const {
 
 	Cellular.command(responseCallback, (void *)&resp, DEFAULT_TIMEOUT, "AT+CCID\r\n");
 
-	return resp.string;
+	return String(resp.string);
 }
 
 bool CellularHelperClass::isSARA_R4() const {
@@ -1435,6 +1433,20 @@ void CellularHelperClass::appendBufferToString(String &str, const char *buf, int
 	}
 }
 
+// [static]
+void CellularHelperClass::appendBufferToArray(char *str, size_t size, const char *buf, int len, bool noEOL) {
+	if (size == 0) {
+		return;
+	}
+	size_t n = strnlen(str, size - 1);
+	for(int ii = 0; ii < len && n + 1 < size; ii++) {
+		if (!noEOL || (buf[ii] != '\r' && buf[ii] != '\n')) {
+			str[n++] = buf[ii];
+		}
+	}
+	str[n] = 0;
+}
+
 // [static]
 int CellularHelperClass::rssiToBars(int rssi) {
 	int bars = 0;
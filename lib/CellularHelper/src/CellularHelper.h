@@ -6,6 +6,9 @@
 
 #if Wiring_Cellular
 
+#ifndef CELLULAR_HELPER_STRING_SIZE
+#define CELLULAR_HELPER_STRING_SIZE 128 // response text kept by the string responses, including the null
+#endif
 
 // Class to hold results from getting network information
 class CellularHelperNetworkInfo {
@@ -81,9 +84,12 @@ public:
 class CellularHelperStringResponse : public CellularHelperCommonResponse {
 public:
 	/**
-	 * @brief Returned string is stored here
+	 * @brief Returned string is stored here, null terminated
+	 *
+	 * A fixed buffer rather than a String so a response doesn't touch the heap. Anything past
+	 * CELLULAR_HELPER_STRING_SIZE - 1 characters is dropped.
 	 */
-	String string;
+	char string[CELLULAR_HELPER_STRING_SIZE] = {0};
 
 	/**
 	 * @brief Method to parse the output from the modem
@@ -114,14 +120,17 @@ public:
 	 * 
 	 * Say you're implementing an AT+CSQ response handler. You would set command to "CSQ". This
 	 * is because the modem will return +CSQ as the response so the parser needs to know what
-	 * to look for. 
+	 * to look for. Points at a string that outlives the command, normally a literal.
 	 */
-	String command;
+	const char *command = "";
 
 	/**
-	 * @brief Returned string is stored here
+	 * @brief Returned string is stored here, null terminated
+	 *
+	 * A fixed buffer rather than a String so a response doesn't touch the heap. Anything past
+	 * CELLULAR_HELPER_STRING_SIZE - 1 characters is dropped.
 	 */
-	String string;
+	char string[CELLULAR_HELPER_STRING_SIZE] = {0};
 
 	/**
 	 * @brief Method to parse the output from the modem
@@ -316,7 +325,7 @@ public:
 	 * 
 	 * - Range 0h-FFFFh (2 octets).
 	 */
-	int lac;
+	int lac = 0;
 
 	/**
 	 * @brief Cell Identity
@@ -324,14 +333,14 @@ public:
 	 * - 2G cell: range 0h-FFFFh (2 octets)
 	 * - 3G cell: range 0h-FFFFFFFh (28 bits)
 	 */
-	int ci; 
+	int ci = 0;
 
 	/**
 	 * @brief Base Station Identify Code
 	 * 
 	 * - Range 0h-3Fh (6 bits) [2G] 
 	 */
-	int bsic;
+	int bsic = 0;
 
 	/**
 	 * @brief Absolute Radio Frequency Channel Number
@@ -342,14 +351,14 @@ public:
 	 *   it corresponds to 0x82CD, in the most significant byte there is the band indicator bit, 
 	 *   so the `arfcn` is 0x2CD (717) and belongs to 1900 band).
 	 */
-	int arfcn; 
+	int arfcn = 0;
 
 	/**
 	 * @brief Received signal level on the cell
 	 * 
 	 * - Range 0 - 63; see the 3GPP TS 05.08 [2G]
 	 */
-	int rxlev;
+	int rxlev = 255;
 
 	/**
 	 * @brief RAT is GSM (false) or UMTS (true)
@@ -361,12 +370,12 @@ public:
 	 * 
 	 * - Range 0 - 16383 [3G only]
 	 */
-	int dlf;
+	int dlf = 0;
 
 	/**
 	 * @brief Uplink frequency. Range 0 - 16383 [3G only]
 	 */
-	int ulf;
+	int ulf = 0;
 
 	/**
 	 * @brief Received signal level [3G]
@@ -404,6 +413,17 @@ public:
 	 */
 	void parse(const char *str);
 
+	/**
+	 * @brief Parses a response that isn't null terminated (used internally)
+	 *
+	 * Works in place on the modem buffer, without allocating.
+	 *
+	 * @param str The comma separated response from the modem to parse
+	 *
+	 * @param len Number of characters in str
+	 */
+	void parse(const char *str, size_t len);
+
 	/**
 	 * @brief Add a key-value pair (used internally)
 	 * 
@@ -548,6 +568,17 @@ public:
 	 */
 	virtual int parse(int type, const char *buf, int len);
 
+	/**
+	 * @brief Parses one line of the response (used internally)
+	 *
+	 * @param type TYPE_PLUS or TYPE_UNKNOWN, from the modem response
+	 *
+	 * @param line Start of the line in the modem buffer, not null terminated
+	 *
+	 * @param len Number of characters in the line
+	 */
+	void parseLine(int type, const char *line, size_t len);
+
 	/**
 	 * @brief Clear the data so the object can be reused
 	 */
@@ -1067,6 +1098,24 @@ public:
 	 */
 	static void appendBufferToString(String &str, const char *buf, int len, bool noEOL = true);
 
+	/**
+	 * @brief Append a buffer (pointer and length) to a fixed, null terminated character array
+	 *
+	 * Same as appendBufferToString() without the heap. Whatever doesn't fit in size - 1 characters
+	 * is dropped.
+	 *
+	 * @param str The null terminated array to append to
+	 *
+	 * @param size The size of str, including room for the null
+	 *
+	 * @param buf The buffer to copy from. Does not need to be null terminated.
+	 *
+	 * @param len The number of bytes to copy.
+	 *
+	 * @param noEOL (default: true) If true, don't copy CR and LF characters to the output.
+	 */
+	static void appendBufferToArray(char *str, size_t size, const char *buf, int len, bool noEOL = true);
+
 	/**
 	 * @brief Default timeout in milliseconds. Passed to Cellular.command().
 	 * 
@@ -112,11 +112,12 @@ int TinyGPSPlus::fromHex(char a)
 
 // static
 // Parse a (potentially negative) number with up to 2 decimal digits -xxxx.yy
+// Out of range input wraps (unsigned arithmetic) rather than overflowing a signed int
 int32_t TinyGPSPlus::parseDecimal(const char *term)
 {
   bool negative = *term == '-';
   if (negative) ++term;
-  int32_t ret = 100 * (int32_t)atol(term);
+  uint32_t ret = 100UL * (uint32_t)atol(term);
   while (isdigit(*term)) ++term;
   if (*term == '.' && isdigit(term[1]))
   {
@@ -124,7 +125,7 @@ int32_t TinyGPSPlus::parseDecimal(const char *term)
     if (isdigit(term[2]))
       ret += term[2] - '0';
   }
-  return negative ? -ret : ret;
+  return (int32_t)(negative ? 0UL - ret : ret);
 }
 
 // static
@@ -286,7 +287,8 @@ double TinyGPSPlus::distanceBetween(double lat1, double long1, double lat2, doub
 {
   // returns distance in meters between two positions, both specified
   // as signed decimal-degrees latitude and longitude. Uses great-circle
-  // distance computation for hypothetical sphere of radius 6372795 meters.
+  // distance computation for hypothetical sphere of radius 6371000 meters
+  // (the mean Earth radius, matching the application's Geodesy module).
   // Because Earth is no exact sphere, rounding errors may be up to 0.5%.
   // Courtesy of Maarten Lamers
   double delta = radians(long1-long2);
@@ -304,7 +306,7 @@ double TinyGPSPlus::distanceBetween(double lat1, double long1, double lat2, doub
   delta = sqrt(delta);
   double denom = (slat1 * slat2) + (clat1 * clat2 * cdlong);
   delta = atan2(delta, denom);
-  return delta * 6372795;
+  return delta * 6371000;
 }
 
 double TinyGPSPlus::courseTo(double lat1, double long1, double lat2, double long2)
@@ -0,0 +1,133 @@
+#include "CellLocationCache.h"
+
+static const uint32_t CELL_CACHE_MAGIC = 0x43454c31; // "CEL1"
+
+CellLocationCache::CellLocationCache(int eepromAddr) : eepromAddr(eepromAddr), useCounter(0), hits(0), misses(0) {
+	memset(entries, 0, sizeof(entries));
+	memset(lastUsed, 0, sizeof(lastUsed));
+}
+
+void CellLocationCache::begin() {
+	useCounter = 0;
+
+	for (int ii = 0; ii < CELL_CACHE_SIZE; ii++) {
+		EEPROM.get(eepromAddr + ii * sizeof(CellLocationEntry), entries[ii]);
+
+		if (entries[ii].magic != CELL_CACHE_MAGIC || entries[ii].checksum != checksum(entries[ii])) {
+			// Blank or torn slot
+			memset(&entries[ii], 0, sizeof(CellLocationEntry));
+			lastUsed[ii] = 0;
+			continue;
+		}
+
+		// Recency restarts from insertion order at boot
+		lastUsed[ii] = entries[ii].sequence;
+		if (entries[ii].sequence > useCounter) {
+			useCounter = entries[ii].sequence;
+		}
+	}
+	Log.trace("cell cache: %u towers", size());
+}
+
+bool CellLocationCache::lookup(const CellKey &key, float &lat, float &lon, float &accuracy) {
+	int slot = find(key);
+	if (slot < 0) {
+		misses++;
+		return false;
+	}
+
+	hits++;
+	lastUsed[slot] = ++useCounter;
+	lat = entries[slot].lat;
+	lon = entries[slot].lon;
+	accuracy = entries[slot].accuracy;
+	return true;
+}
+
+void CellLocationCache::insert(const CellKey &key, float lat, float lon, float accuracy) {
+	if (!key.isValid()) {
+		return;
+	}
+
+	int slot = find(key);
+	if (slot >= 0 && entries[slot].lat == lat && entries[slot].lon == lon && entries[slot].accuracy == accuracy) {
+		// Nothing new, spare the flash
+		lastUsed[slot] = ++useCounter;
+		return;
+	}
+
+	if (slot < 0) {
+		// Take an empty slot, otherwise evict the least recently used tower
+		slot = 0;
+		for (int ii = 0; ii < CELL_CACHE_SIZE; ii++) {
+			if (entries[ii].magic != CELL_CACHE_MAGIC) {
+				slot = ii;
+				break;
+			}
+			if (lastUsed[ii] < lastUsed[slot]) {
+				slot = ii;
+			}
+		}
+	}
+
+	CellLocationEntry &entry = entries[slot];
+	memset(&entry, 0, sizeof(entry));
+	entry.magic = CELL_CACHE_MAGIC;
+	entry.key = key;
+	entry.lat = lat;
+	entry.lon = lon;
+	entry.accuracy = accuracy;
+	entry.sequence = ++useCounter;
+	entry.checksum = checksum(entry);
+	lastUsed[slot] = entry.sequence;
+	save(slot);
+}
+
+void CellLocationCache::clear() {
+	for (int ii = 0; ii < CELL_CACHE_SIZE; ii++) {
+		if (entries[ii].magic == CELL_CACHE_MAGIC) {
+			memset(&entries[ii], 0, sizeof(CellLocationEntry));
+			lastUsed[ii] = 0;
+			save(ii);
+		}
+	}
+	hits = misses = 0;
+}
+
+size_t CellLocationCache::size() const {
+	size_t count = 0;
+	for (int ii = 0; ii < CELL_CACHE_SIZE; ii++) {
+		if (entries[ii].magic == CELL_CACHE_MAGIC) {
+			count++;
+		}
+	}
+	return count;
+}
+
+float CellLocationCache::getHitRate() const {
+	uint32_t total = hits + misses;
+	return total ? (float)hits / total : 0.0f;
+}
+
+int CellLocationCache::find(const CellKey &key) const {
+	for (int ii = 0; ii < CELL_CACHE_SIZE; ii++) {
+		if (entries[ii].magic == CELL_CACHE_MAGIC && entries[ii].key == key) {
+			return ii;
+		}
+	}
+	return -1;
+}
+
+void CellLocationCache::save(int slot) {
+	EEPROM.put(eepromAddr + slot * sizeof(CellLocationEntry), entries[slot]);
+}
+
+// [static] FNV-1a over everything but the checksum itself
+uint32_t CellLocationCache::checksum(const CellLocationEntry &entry) {
+	const uint8_t *p = (const uint8_t *)&entry;
+	uint32_t hash = 2166136261UL;
+	for (size_t ii = 0; ii < offsetof(CellLocationEntry, checksum); ii++) {
+		hash = (hash ^ p[ii]) * 16777619UL;
+	}
+	return hash;
+}
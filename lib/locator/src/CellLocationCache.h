@@ -0,0 +1,63 @@
+#ifndef __CELLLOCATIONCACHE_H
+#define __CELLLOCATIONCACHE_H
+
+#include "Particle.h"
+
+#define CELL_CACHE_SIZE 32           // towers remembered, 36 bytes of EEPROM each
+#define CELL_CACHE_EEPROM_ADDR 512   // after the odometer slots
+
+// Serving cell identity, the cache key
+struct CellKey {
+	uint16_t mcc = 0;
+	uint16_t mnc = 0;
+	uint32_t lac = 0;
+	uint32_t ci = 0;
+
+	bool isValid() const { return mcc != 0 && mcc != 65535 && lac != 0 && lac != 65535; }
+	bool operator==(const CellKey &other) const { return mcc == other.mcc && mnc == other.mnc && lac == other.lac && ci == other.ci; }
+};
+
+// One persisted tower position, as returned by the geolocation webhook
+struct CellLocationEntry {
+	uint32_t magic;
+	CellKey key;
+	float lat;
+	float lon;
+	float accuracy;
+	uint32_t sequence;
+	uint32_t checksum;
+};
+
+/**
+ * Device-side LRU cache of tower positions, kept in EEPROM so it survives reboots.
+ * Lookups are served from a RAM copy; flash is only written when a new tower is learned.
+ */
+class CellLocationCache {
+public:
+	CellLocationCache(int eepromAddr = CELL_CACHE_EEPROM_ADDR);
+
+	void begin();
+
+	bool lookup(const CellKey &key, float &lat, float &lon, float &accuracy);
+	void insert(const CellKey &key, float lat, float lon, float accuracy);
+	void clear();
+
+	size_t size() const;
+	uint32_t getHits() const { return hits; }
+	uint32_t getMisses() const { return misses; }
+	float getHitRate() const;
+
+protected:
+	int find(const CellKey &key) const;
+	void save(int slot);
+	static uint32_t checksum(const CellLocationEntry &entry);
+
+	int eepromAddr;
+	CellLocationEntry entries[CELL_CACHE_SIZE];
+	uint32_t lastUsed[CELL_CACHE_SIZE];
+	uint32_t useCounter;
+	uint32_t hits;
+	uint32_t misses;
+};
+
+#endif /* __CELLLOCATIONCACHE_H */
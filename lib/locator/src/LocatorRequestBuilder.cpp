@@ -0,0 +1,220 @@
+#include "LocatorRequestBuilder.h"
+
+static const char JSON_CLOSE[] = "]}}";
+static const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+LocatorRequestBuilder::LocatorRequestBuilder(size_t capacity, int format) : capacity(0), format(format), buf(NULL), binary(NULL),
+	len(0), reserve(0), numAdded(0), numDropped(0), fingerprint(0) {
+	setCapacity(capacity);
+}
+
+LocatorRequestBuilder::~LocatorRequestBuilder() {
+	delete[] buf;
+	delete[] binary;
+}
+
+// Allocates once, at configuration time. Publishes are capped at 622 bytes by the cloud anyway
+void LocatorRequestBuilder::setCapacity(size_t capacity) {
+	if (capacity < 32) {
+		capacity = 32;
+	}
+	delete[] buf;
+	delete[] binary;
+	this->capacity = capacity;
+	buf = new char[capacity];
+	binary = new uint8_t[binaryCapacity()];
+	buf[0] = 0;
+	len = 0;
+}
+
+void LocatorRequestBuilder::beginCellular(const char *operatorName) {
+	len = 0;
+	numAdded = numDropped = 0;
+	fingerprint = 0;
+	servingCell = CellKey();
+	buf[0] = 0;
+
+	if (format == FORMAT_BINARY) {
+		uint8_t header[3] = { BINARY_VERSION, 'c', 0 };
+		appendBinary(header, sizeof(header));
+		return;
+	}
+
+	reserve = sizeof(JSON_CLOSE);
+	append("{\"c\":{\"o\":\"");
+	appendEscaped(operatorName ? operatorName : "");
+	append("\",\"a\":[");
+}
+
+void LocatorRequestBuilder::beginWiFi(bool considerIp) {
+	len = 0;
+	numAdded = numDropped = 0;
+	fingerprint = 0;
+	servingCell = CellKey();
+	buf[0] = 0;
+
+	if (format == FORMAT_BINARY) {
+		uint8_t header[3] = { BINARY_VERSION, 'w', 0 };
+		appendBinary(header, sizeof(header));
+		return;
+	}
+
+	reserve = sizeof(JSON_CLOSE);
+	append(considerIp ? "{\"w\":{\"i\":true,\"a\":[" : "{\"w\":{\"i\":false,\"a\":[");
+}
+
+// Returns false, and counts the tower as dropped, when it doesn't fit
+bool LocatorRequestBuilder::addTower(uint32_t ci, uint32_t lac, uint16_t mcc, uint16_t mnc) {
+	bool added;
+
+	if (format == FORMAT_BINARY) {
+		uint8_t entry[12] = {
+			(uint8_t)mcc, (uint8_t)(mcc >> 8), (uint8_t)mnc, (uint8_t)(mnc >> 8),
+			(uint8_t)lac, (uint8_t)(lac >> 8), (uint8_t)(lac >> 16), (uint8_t)(lac >> 24),
+			(uint8_t)ci, (uint8_t)(ci >> 8), (uint8_t)(ci >> 16), (uint8_t)(ci >> 24)
+		};
+		added = numAdded < 255 && appendBinary(entry, sizeof(entry));
+	}
+	else {
+		char entry[64];
+		snprintf(entry, sizeof(entry), "%s{\"i\":%lu,\"l\":%lu,\"c\":%u,\"n\":%u}", numAdded ? "," : "",
+				(unsigned long)ci, (unsigned long)lac, mcc, mnc);
+		added = append(entry);
+	}
+
+	if (!added) {
+		numDropped++;
+		return false;
+	}
+
+	if (numAdded++ == 0) {
+		servingCell.mcc = mcc;
+		servingCell.mnc = mnc;
+		servingCell.lac = lac;
+		servingCell.ci = ci;
+	}
+	uint32_t tower[4] = { ci, lac, mcc, mnc };
+	addFingerprint(tower, sizeof(tower));
+	return true;
+}
+
+bool LocatorRequestBuilder::addAccessPoint(const uint8_t *bssid, int rssi, int channel) {
+	bool added;
+
+	if (format == FORMAT_BINARY) {
+		uint8_t entry[8] = { bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], (uint8_t)(int8_t)rssi, (uint8_t)channel };
+		added = numAdded < 255 && appendBinary(entry, sizeof(entry));
+	}
+	else {
+		char entry[64];
+		snprintf(entry, sizeof(entry), "%s{\"m\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"s\":%d,\"c\":%d}", numAdded ? "," : "",
+				bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], rssi, channel);
+		added = append(entry);
+	}
+
+	if (!added) {
+		numDropped++;
+		return false;
+	}
+
+	numAdded++;
+	addFingerprint(bssid, 6);
+	return true;
+}
+
+// Closes the payload. Returns "" when nothing was added, so there's nothing to publish
+const char *LocatorRequestBuilder::finish() {
+	if (numDropped) {
+		Log.trace("request full, dropped %u of %u entries", numDropped, numAdded + numDropped);
+	}
+
+	if (numAdded == 0) {
+		buf[0] = 0;
+		return buf;
+	}
+
+	if (format == FORMAT_JSON) {
+		reserve = 0;
+		append(JSON_CLOSE);
+		return buf;
+	}
+
+	binary[2] = (uint8_t)numAdded;
+
+	char *out = buf;
+	*out++ = 'b';
+	size_t bits = 0;
+	uint32_t acc = 0;
+	for (size_t ii = 0; ii < len; ii++) {
+		acc = (acc << 8) | binary[ii];
+		bits += 8;
+		while (bits >= 6) {
+			bits -= 6;
+			*out++ = BASE64_CHARS[(acc >> bits) & 0x3f];
+		}
+	}
+	if (bits) {
+		*out++ = BASE64_CHARS[(acc << (6 - bits)) & 0x3f];
+	}
+	*out = 0;
+	return buf;
+}
+
+bool LocatorRequestBuilder::append(const char *str) {
+	size_t n = strlen(str);
+	if (len + n + (reserve ? reserve : 1) > capacity) {
+		return false;
+	}
+	memcpy(&buf[len], str, n + 1);
+	len += n;
+	return true;
+}
+
+// Operator names come from the network; quote them safely and truncate rather than overflow
+bool LocatorRequestBuilder::appendEscaped(const char *str) {
+	char ch[3] = { 0, 0, 0 };
+	for (; *str; str++) {
+		if ((uint8_t)*str < 0x20) {
+			continue;
+		}
+		if (*str == '"' || *str == '\\') {
+			ch[0] = '\\';
+			ch[1] = *str;
+		}
+		else {
+			ch[0] = *str;
+			ch[1] = 0;
+		}
+		if (len + strlen(ch) + reserve + 64 > capacity) {
+			// Leave room for at least one tower
+			return false;
+		}
+		append(ch);
+	}
+	return true;
+}
+
+bool LocatorRequestBuilder::appendBinary(const uint8_t *data, size_t n) {
+	if (len + n > binaryCapacity()) {
+		return false;
+	}
+	memcpy(&binary[len], data, n);
+	len += n;
+	return true;
+}
+
+// Raw bytes that still fit once base64 encoded behind the 'b' prefix, with the null
+size_t LocatorRequestBuilder::binaryCapacity() const {
+	return (capacity - 2) * 3 / 4;
+}
+
+// FNV-1a of one tower or access point. Entries are summed so the fingerprint doesn't depend
+// on the order the modem lists neighbors in.
+void LocatorRequestBuilder::addFingerprint(const void *data, size_t n) {
+	const uint8_t *p = (const uint8_t *)data;
+	uint32_t hash = 2166136261UL;
+	for (size_t ii = 0; ii < n; ii++) {
+		hash = (hash ^ p[ii]) * 16777619UL;
+	}
+	fingerprint += hash;
+}
@@ -5,12 +5,11 @@
 # include "CellularHelper.h"
 #endif
 
-static char requestBuf[256];
-static char *requestCur;
-static int numAdded = 0;
 
 Locator::Locator() : locatorMode(LOCATOR_MODE_MANUAL), periodMs(10000), eventName("deviceLocator"), publicEvent(false),
-	stateTime(0), state(CONNECT_WAIT_STATE), callback(NULL), waitAfterConnect(8000), wifiConsiderIp(true) {
+	stateTime(0), state(CONNECT_WAIT_STATE), callback(NULL), waitAfterConnect(8000), wifiConsiderIp(true),
+	stationary(false), scanCacheMaxAge(600000), scanTime(0), scanFingerprint(0), publishedFingerprint(0), scansSkipped(0), publishesSkipped(0),
+	scanThread(NULL), scanState(SCAN_IDLE), asyncFingerprint(0), asyncScanData(NULL), cache(NULL) {
 
 }
 
@@ -45,13 +44,14 @@ Locator &Locator::withPublicEvent() {
 Locator &Locator::withSubscribe(LocatorSubscriptionCallback callback, bool onlyThisDevice) {
 	this->callback = callback;
 
+	char eventFilter[128];
 	if (onlyThisDevice) {
-		snprintf(requestBuf, sizeof(requestBuf), "hook-response/%s/%s", eventName.c_str(), System.deviceID().c_str());
+		snprintf(eventFilter, sizeof(eventFilter), "hook-response/%s/%s", eventName.c_str(), System.deviceID().c_str());
 	}
 	else {
-		snprintf(requestBuf, sizeof(requestBuf), "hook-response/%s", eventName.c_str());
+		snprintf(eventFilter, sizeof(eventFilter), "hook-response/%s", eventName.c_str());
 	}
-	Particle.subscribe(requestBuf, &Locator::subscriptionHandler, this, MY_DEVICES);
+	Particle.subscribe(eventFilter, &Locator::subscriptionHandler, this, MY_DEVICES);
 
 	return *this;
 }
@@ -61,8 +61,48 @@ Locator &Locator::withWiFiConsiderIp(bool value) {
 	return *this;
 }
 
+Locator &Locator::withScanCacheMaxAge(unsigned long ms) {
+	scanCacheMaxAge = ms;
+	return *this;
+}
+
+Locator &Locator::withRequestCapacity(size_t capacity) {
+	request.setCapacity(capacity);
+	return *this;
+}
+
+Locator &Locator::withBinaryRequest() {
+	request.setFormat(LocatorRequestBuilder::FORMAT_BINARY);
+	return *this;
+}
+
+Locator &Locator::withCache(CellLocationCache *cache) {
+	this->cache = cache;
+	return *this;
+}
+
+Locator &Locator::withAsyncScan(size_t stackSize) {
+	if (!scanThread) {
+		scanThread = new Thread("locator", scanThreadFunction, this, OS_THREAD_PRIORITY_DEFAULT, stackSize);
+	}
+	return *this;
+}
+
+void Locator::setStationary(bool stationary) {
+	if (this->stationary && !stationary) {
+		// Moving again, the next publish always rescans
+		scanTime = 0;
+	}
+	this->stationary = stationary;
+}
 
 void Locator::loop() {
+	if (scanState.load(std::memory_order_acquire) == SCAN_READY) {
+		// The worker is done with the buffer, publish from the loop thread
+		publishScan(asyncScanData, asyncFingerprint, asyncServingCell);
+		scanState.store(SCAN_IDLE, std::memory_order_release);
+	}
+
 	switch(state) {
 	case CONNECT_WAIT_STATE:
 		if (Particle.connected()) {
@@ -123,12 +163,58 @@ const char *Locator::scan() {
 
 void Locator::publishLocation() {
 	Log.trace("publishLocation");
+
+	if (stationary && scanTime != 0 && scanFingerprint == publishedFingerprint && millis() - scanTime < scanCacheMaxAge) {
+		// Parked on the same towers; the last location still holds and the modem stays idle
+		scansSkipped++;
+		Log.trace("stationary, reusing scan %08lx", (unsigned long)scanFingerprint);
+		return;
+	}
+
+	if (scanThread) {
+		// Hand off to the worker; a scan already in flight covers this request too
+		int expected = SCAN_IDLE;
+		scanState.compare_exchange_strong(expected, SCAN_REQUESTED, std::memory_order_acq_rel);
+		return;
+	}
+
 	const char *scanData = scan();
+	publishScan(scanData, request.getFingerprint(), request.getServingCell());
+}
+
+void Locator::publishScan(const char *scanData, uint32_t scanFingerprint, const CellKey &serving) {
 	Log.trace("scanData=%s", scanData);
 
 	if (scanData[0]) {
+		scanTime = millis();
+		this->scanFingerprint = scanFingerprint;
+
+		if (stationary && scanFingerprint == publishedFingerprint) {
+			publishesSkipped++;
+			Log.trace("tower set unchanged, not publishing");
+			return;
+		}
+
+		float lat, lon, accuracy;
+		if (cache && serving.isValid() && cache->lookup(serving, lat, lon, accuracy)) {
+			// Known tower, resolve locally: no publish, no webhook, works offline
+			Log.trace("cell cache hit %u/%u/%lu/%lu", serving.mcc, serving.mnc, (unsigned long)serving.lac, (unsigned long)serving.ci);
+			publishedFingerprint = scanFingerprint;
+			if (callback) {
+				LocatorResult result;
+				result.lat = lat;
+				result.lon = lon;
+				result.accuracy = accuracy;
+				result.cell = serving;
+				result.fromCache = true;
+				(*callback)(result);
+			}
+			return;
+		}
 
 		if (Particle.connected()) {
+			publishedFingerprint = scanFingerprint;
+			pendingServingCell = serving;
 			if (publicEvent) {
 				Particle.publish(eventName, scanData);
 			}
@@ -136,6 +222,26 @@ void Locator::publishLocation() {
 				Particle.publish(eventName, scanData, PRIVATE);
 			}
 		}
+		else {
+			// Offline and not cached: nothing to resolve it with, try again next period
+			Log.trace("cell cache miss while offline");
+		}
+	}
+}
+
+// [static] Runs the blocking modem exchanges off the loop thread
+os_thread_return_t Locator::scanThreadFunction(void *param) {
+	Locator *locator = (Locator *)param;
+
+	while (true) {
+		int expected = SCAN_REQUESTED;
+		if (locator->scanState.compare_exchange_strong(expected, SCAN_BUSY, std::memory_order_acq_rel)) {
+			locator->asyncScanData = locator->scan();
+			locator->asyncFingerprint = locator->request.getFingerprint();
+			locator->asyncServingCell = locator->request.getServingCell();
+			locator->scanState.store(SCAN_READY, std::memory_order_release);
+		}
+		delay(50);
 	}
 }
 
@@ -143,99 +249,119 @@ void Locator::subscriptionHandler(const char *event, const char *data) {
 	// event: hook-response/deviceLocator/<deviceid>/0
 
 	if (callback) {
-		// float lat, float lon, float accuracy
-		char *mutableCopy = strdup(data);
-		char *part, *end;
-		float lat, lon, accuracy;
-
-		part = strtok_r(mutableCopy, ",", &end);
-		if (part) {
-			lat = atof(part);
-			part = strtok_r(NULL, ",", &end);
-			if (part) {
-				lon = atof(part);
-				part = strtok_r(NULL, ",", &end);
-				if (part) {
-					accuracy = atof(part);
-
-					(*callback)(lat, lon, accuracy);
-				}
-			}
+		LocatorResult result;
+		if (!parseResponse(data, result)) {
+			Log.trace("unparseable locator response");
+			return;
 		}
 
-		free(mutableCopy);
+		result.cell = pendingServingCell;
+		if (cache) {
+			// Remember where the tower from the published scan resolved to
+			cache->insert(pendingServingCell, result.lat, result.lon, result.accuracy);
+		}
+		(*callback)(result);
 	}
 }
 
+// [static] Parses "lat,lon,accuracy" in place. Reads at most maxLen characters and never allocates
+bool Locator::parseResponse(const char *data, LocatorResult &result, size_t maxLen) {
+	if (!data) {
+		return false;
+	}
 
+	const char *cur = data;
+	const char *end = data;
+	while (*end && (size_t)(end - data) < maxLen) {
+		end++;
+	}
 
-#if Wiring_WiFi
-
-static void wifiScanCallback(WiFiAccessPoint* wap, void* data) {
-	// The - 3 factor here to leave room for the closing JSON array ] object }} and the trailing null
-	size_t spaceLeft = &requestBuf[sizeof(requestBuf) - 3] - requestCur;
-
-	size_t sizeNeeded = snprintf(requestCur, spaceLeft,
-			"%s{\"m\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"s\":%d,\"c\":%d}",
-			(requestCur[-1] == '[' ? "" : ","),
-			wap->bssid[0], wap->bssid[1], wap->bssid[2], wap->bssid[3], wap->bssid[4], wap->bssid[5],
-			wap->rssi, wap->channel);
-	if (sizeNeeded <= spaceLeft) {
-		// There is enough space to store the whole entry, so save it
-		requestCur += sizeNeeded;
-		numAdded++;
+	if (!parseNumber(cur, end, result.lat) || cur >= end || *cur++ != ',') {
+		return false;
+	}
+	if (!parseNumber(cur, end, result.lon) || cur >= end || *cur++ != ',') {
+		return false;
 	}
+	double accuracy;
+	if (!parseNumber(cur, end, accuracy)) {
+		return false;
+	}
+	result.accuracy = (float)accuracy;
+	return result.lat >= -90 && result.lat <= 90 && result.lon >= -180 && result.lon <= 180;
 }
 
+// [static] Plain decimal, optional sign and fraction. Digits are accumulated as an integer and
+// scaled once in double, so the 7th decimal of a coordinate survives into LocatorResult
+bool Locator::parseNumber(const char *&cur, const char *end, double &value) {
+	bool negative = false;
+	if (cur < end && (*cur == '-' || *cur == '+')) {
+		negative = (*cur++ == '-');
+	}
 
-const char *Locator::wifiScan() {
+	int64_t mantissa = 0;
+	int digits = 0;
+	int fraction = -1;
+	for (; cur < end; cur++) {
+		if (*cur == '.' && fraction < 0) {
+			fraction = 0;
+		}
+		else
+		if (*cur >= '0' && *cur <= '9') {
+			if (digits < 18) {
+				mantissa = mantissa * 10 + (*cur - '0');
+				digits++;
+				if (fraction >= 0) {
+					fraction++;
+				}
+			}
+		}
+		else {
+			break;
+		}
+	}
 
-	requestCur = requestBuf;
-	numAdded = 0;
+	if (digits == 0) {
+		return false;
+	}
 
-	requestCur += sprintf(requestCur, "{\"w\":{\"i\":%s,\"a\":", wifiConsiderIp ? "true" : "false");
-	*requestCur++ = '[';
+	double result = (double)mantissa;
+	for (int ii = 0; ii < fraction; ii++) {
+		result /= 10;
+	}
+	value = negative ? -result : result;
+	return true;
+}
 
-	WiFi.scan(wifiScanCallback);
 
-	*requestCur++ = ']';
-	*requestCur++ = '}';
-	*requestCur++ = '}';
-	*requestCur++ = 0;
 
-	if (numAdded == 0) {
-		requestBuf[0] = 0;
-	}
+#if Wiring_WiFi
 
-	return requestBuf;
+static void wifiScanCallback(WiFiAccessPoint* wap, void* data) {
+	((LocatorRequestBuilder *)data)->addAccessPoint(wap->bssid, wap->rssi, wap->channel);
 }
 
-#endif /* Wiring_WiFi */
 
+const char *Locator::wifiScan() {
+	request.beginWiFi(wifiConsiderIp);
+	WiFi.scan(wifiScanCallback, &request);
+	return request.finish();
+}
 
-#if Wiring_Cellular
+#endif /* Wiring_WiFi */
 
-static void cellularAddTower(const CellularHelperEnvironmentCellData *cellData) {
-	// The - 4 factor here to leave room for the closing JSON array ], object }}, and the trailing null
-	size_t spaceLeft = &requestBuf[sizeof(requestBuf) - 4] - requestCur;
 
-	size_t sizeNeeded = snprintf(requestCur, spaceLeft,
-			"%s{\"i\":%d,\"l\":%u,\"c\":%d,\"n\":%d}",
-			(requestCur[-1] == '[' ? "" : ","),
-			cellData->ci, cellData->lac, cellData->mcc, cellData->mnc);
+#if Wiring_Cellular
 
-	if (sizeNeeded <= spaceLeft && cellData->lac != 0 && cellData->lac != 65535 && cellData->mcc != 65535 && cellData->mnc != 65535) {
-		// There is enough space to store the whole entry, so save it
-		requestCur += sizeNeeded;
-		numAdded++;
+static void cellularAddTower(LocatorRequestBuilder &request, const CellularHelperEnvironmentCellData *cellData) {
+	if (cellData->lac != 0 && cellData->lac != 65535 && cellData->mcc != 65535 && cellData->mnc != 65535) {
+		request.addTower(cellData->ci, cellData->lac, cellData->mcc, cellData->mnc);
 	}
-
 }
 
 const char *Locator::cellularScan() {
 
 	// First try to get info on neighboring cells. This doesn't work for me using the U260
-	CellularHelperEnvironmentResponseStatic<4> envResp;
+	CellularHelperEnvironmentResponseStatic<LOCATOR_MAX_NEIGHBORS> envResp;
 	Log.trace("cellularScan()");
 	CellularHelper.getEnvironment(5, envResp);
 	Log.trace("getEnvironment(5) %d", envResp.resp);
@@ -248,30 +374,13 @@ const char *Locator::cellularScan() {
 	// envResp.serialDebug();
 
 	if (envResp.resp == RESP_OK) {
-		requestCur = requestBuf;
-		numAdded = 0;
-
-		// We know these things fit, so just using sprintf instead of snprintf here
-		requestCur += sprintf(requestCur, "{\"c\":{\"o\":\"%s\",", CellularHelper.getOperatorName().c_str());
-		// Serial.println(CellularHelper.getOperatorName());
-		requestCur += sprintf(requestCur, "\"a\":[");
-		cellularAddTower(&envResp.service);
+		request.beginCellular(CellularHelper.getOperatorName().c_str());
+		cellularAddTower(request, &envResp.service);
 
 		for (size_t ii = 0; ii < envResp.getNumNeighbors(); ii++)
 		{
-			cellularAddTower(&envResp.neighbors[ii]);
-		}
-
-		*requestCur++ = ']';
-		*requestCur++ = '}';
-		*requestCur++ = '}';
-		*requestCur++ = 0;
-
-		if (numAdded == 0) {
-			requestBuf[0] = 0;
+			cellularAddTower(request, &envResp.neighbors[ii]);
 		}
-
-		Log.trace(requestCur);
 	} else {
 		Log.trace("trying CellularGlobalIdentity since CGED failed %d", envResp.resp);
 		String oper = CellularHelper.getOperatorName();
@@ -281,32 +390,21 @@ const char *Locator::cellularScan() {
 
 		cellular_result_t res = cellular_global_identity(&cgi, NULL);
 
+		request.beginCellular(oper.c_str());
 		if (res == SYSTEM_ERROR_NONE)
 		{
 			Log.trace("cellular_global_identity res: %d", res);
-			requestCur = requestBuf;
-			// We know these things fit, so just using sprintf instead of snprintf here
-			requestCur += sprintf(requestCur, "{\"c\":{\"o\":\"%s\",", oper.c_str());
-
-			requestCur += sprintf(requestCur, "\"a\":[");
-
-			requestCur += sprintf(requestCur, "{\"i\":%lu,\"l\":%u,\"c\":%u,\"n\":%u}",
-														cgi.cell_id, cgi.location_area_code, cgi.mobile_country_code, cgi.mobile_network_code);
-
-			numAdded++;
-			*requestCur++ = ']';
-			*requestCur++ = '}';
-			*requestCur++ = '}';
-			*requestCur++ = 0;
+			request.addTower(cgi.cell_id, cgi.location_area_code, cgi.mobile_country_code, cgi.mobile_network_code);
 		}
 		else
 		{
 			Log.trace("cellular_global_identity failed %d", res);
-			requestBuf[0] = 0;
 		}
 	}
 
-	return requestBuf;
+	const char *requestData = request.finish();
+	Log.trace(requestData);
+	return requestData;
 }
 
 // [static]
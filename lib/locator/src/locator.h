@@ -1,8 +1,29 @@
 #ifndef __LOCATOR_H
 #define __LOCATOR_H
 
+#include "Particle.h"
+#include "CellLocationCache.h"
+#include "LocatorRequestBuilder.h"
+#include <atomic>
+
+// One resolved position, from the geolocation webhook or the local tower cache
+struct LocatorResult {
+	double lat = 0;     // double: a float rounds a 7-decimal coordinate to ~1m. The cache still keeps floats
+	double lon = 0;
+	float accuracy = 0; // meters
+	CellKey cell;       // serving cell the position belongs to, invalid for WiFi scans
+	bool fromCache = false;
+};
+
+#ifndef LOCATOR_MAX_NEIGHBORS
+#define LOCATOR_MAX_NEIGHBORS 8 // neighbor cells requested from the modem per scan
+#endif
+
+#ifndef LOCATOR_RESPONSE_MAX
+#define LOCATOR_RESPONSE_MAX 64 // longest webhook response read, "lat,lon,accuracy" with room to spare
+#endif
 
-typedef void (*LocatorSubscriptionCallback)(float lat, float lon, float accuracy);
+typedef void (*LocatorSubscriptionCallback)(const LocatorResult &result);
 
 class Locator {
 public:
@@ -19,15 +40,45 @@ public:
 
 	Locator &withWiFiConsiderIp(bool value);
 
+	Locator &withScanCacheMaxAge(unsigned long ms);
+
+	Locator &withAsyncScan(size_t stackSize = 3072);
+
+	Locator &withCache(CellLocationCache *cache);
+
+	Locator &withRequestCapacity(size_t capacity);
+	Locator &withBinaryRequest();
+
+	void setStationary(bool stationary);
+
 	void loop();
 
 	const char *scan();
 
 	void publishLocation();
 
+	uint32_t getScanFingerprint() const { return scanFingerprint; }
+	uint32_t getScansSkipped() const { return scansSkipped; }
+
+	// True while the async worker has a scan requested or in flight. The worker owns the modem until then, so
+	// other AT commands (signal quality and the like) should wait. Only the loop thread can start a scan, so a
+	// false here stays false until the loop thread calls publishLocation() again
+	bool isScanning() const {
+		int state = scanState.load(std::memory_order_acquire);
+		return state == SCAN_REQUESTED || state == SCAN_BUSY;
+	}
+	uint32_t getPublishesSkipped() const { return publishesSkipped; }
+
 protected:
 	void subscriptionHandler(const char *event, const char *data);
 
+	void publishScan(const char *scanData, uint32_t scanFingerprint, const CellKey &serving);
+
+	static os_thread_return_t scanThreadFunction(void *param);
+
+	static bool parseResponse(const char *data, LocatorResult &result, size_t maxLen = LOCATOR_RESPONSE_MAX);
+	static bool parseNumber(const char *&cur, const char *end, double &value);
+
 #if Wiring_WiFi
 	const char *wifiScan();
 #endif
@@ -54,6 +105,33 @@ protected:
 	LocatorSubscriptionCallback callback;
 	unsigned long waitAfterConnect;
 	bool wifiConsiderIp;
+	LocatorRequestBuilder request;
+
+	// Scan cache: while stationary, a scan younger than scanCacheMaxAge is reused without
+	// touching the modem, and a fresh scan that sees the same towers isn't republished.
+	bool stationary;
+	unsigned long scanCacheMaxAge;
+	unsigned long scanTime;
+	uint32_t scanFingerprint;
+	uint32_t publishedFingerprint;
+	uint32_t scansSkipped;
+	uint32_t publishesSkipped;
+
+	// Async scan mailbox. The loop thread moves IDLE -> REQUESTED, the worker REQUESTED -> BUSY -> READY,
+	// and the loop picks up READY -> IDLE. Whoever's turn it is owns the scan buffer, so no lock is needed.
+	static const int SCAN_IDLE = 0;
+	static const int SCAN_REQUESTED = 1;
+	static const int SCAN_BUSY = 2;
+	static const int SCAN_READY = 3;
+
+	Thread *scanThread;
+	std::atomic<int> scanState;
+	uint32_t asyncFingerprint;
+	const char *asyncScanData;
+	CellKey asyncServingCell;
+
+	CellLocationCache *cache;
+	CellKey pendingServingCell; // serving cell of the scan awaiting a webhook response
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "CANManager.h"
+#include "TimeBase.h"
 #include <SPI.h>
 #include <Wire.h>
 #include <mcp_can.h>
@@ -35,6 +36,7 @@ void CANManager::update() {
         if (!digitalRead(iIntPin)) { // If iIntPin pin is low, read receive buffer
             Log.trace("Data available. Reading data...");
             CAN0->readMsgBuf(&rxId, &len, data); // Read data: len = data length, buf = data byte(s)
+            ullRxTime = timeBase.now();
             Log.trace("Raw ID:" + String(rxId));
 
             if (blnDebugOn) {
@@ -63,6 +65,8 @@ void CANManager::update() {
                 }
             }
 
+            decodeOBDReply();
+
             if (len > 0)
                 blnCANDataReady = true;
             else
@@ -103,6 +107,50 @@ void CANManager::setCANData(unsigned char *data) {
 unsigned char *CANManager::getCANData() { return data; }
 long unsigned int CANManager::getCANRxId() { return rxId; }
 
+uint64_t CANManager::getCANRxTime() { return ullRxTime; }
+
+uint32_t CANManager::getVehicleOdometer() { return ulVehicleOdometer; }
+
+bool CANManager::isEngineRPMUpdated() { return blnEngineRPMUpdated; }
+
+uint16_t CANManager::getEngineRPM() {
+    blnEngineRPMUpdated = false;
+    return iEngineRPM;
+}
+
+bool CANManager::isVehicleSpeedUpdated() { return blnVehicleSpeedUpdated; }
+
+uint8_t CANManager::getVehicleSpeed() {
+    blnVehicleSpeedUpdated = false;
+    return iVehicleSpeed;
+}
+
+void CANManager::decodeOBDReply() {
+    if (rxId < OBD_REPLY_ID_MIN || rxId > OBD_REPLY_ID_MAX || len < 3 || data[1] != OBD_SERVICE_CURRENT_DATA_REPLY) {
+        return;
+    }
+
+    switch (data[2]) {
+    case OBD_PID_ENGINE_RPM: // (256A + B) / 4 rpm
+        if (len >= 5) {
+            iEngineRPM = (((uint16_t)data[3] << 8) | data[4]) / 4;
+            blnEngineRPMUpdated = true;
+        }
+        break;
+    case OBD_PID_VEHICLE_SPEED: // A km/h
+        if (len >= 4) {
+            iVehicleSpeed = data[3];
+            blnVehicleSpeedUpdated = true;
+        }
+        break;
+    case OBD_PID_ODOMETER: // (A<<24 | B<<16 | C<<8 | D) / 10 km
+        if (len >= 7) {
+            ulVehicleOdometer = ((uint32_t)data[3] << 24) | ((uint32_t)data[4] << 16) | ((uint32_t)data[5] << 8) | data[6];
+        }
+        break;
+    }
+}
+
 byte CANManager::sendData(unsigned long id, byte ext, byte len, byte *buf) {
     byte ret = CAN_FAIL;
 
@@ -8,6 +8,14 @@
 #define CAN0_DEFAULT_CS A2  // Set CS to pin A2
 #define CAN_DATA_BUFFER_SIZE 8
 
+// CWD-- OBD-II mode 1 replies come back from 0x7E8-0x7EF as [len, 0x41, pid, A, B, C, D]
+#define OBD_REPLY_ID_MIN 0x7E8
+#define OBD_REPLY_ID_MAX 0x7EF
+#define OBD_SERVICE_CURRENT_DATA_REPLY 0x41
+#define OBD_PID_ENGINE_RPM 0x0C
+#define OBD_PID_VEHICLE_SPEED 0x0D
+#define OBD_PID_ODOMETER 0xA6
+
 class CANManager {
   public:
     CANManager(int IntPin, int CSPin, bool debugOn = false);
@@ -25,17 +33,33 @@ class CANManager {
     void setCANData(unsigned char *data);
     unsigned char *getCANData();
     long unsigned int getCANRxId();
+    uint64_t getCANRxTime(); // CWD-- TimeBase monotonic micros
     byte sendData(unsigned long id, byte ext, byte len, byte *buf);
 
+    // CWD-- decoded OBD values, 0 until the ECU has answered
+    uint32_t getVehicleOdometer(); // 100m units
+    bool isEngineRPMUpdated();
+    uint16_t getEngineRPM(); // clears the updated flag
+    bool isVehicleSpeedUpdated();
+    uint8_t getVehicleSpeed(); // km/h, clears the updated flag
+
   private:
+    void decodeOBDReply();
+
     int iIntPin = CAN0_DEFAULT_INT;
     int iCSPin = CAN0_DEFAULT_CS;
     bool blnDebugOn = false;
     bool blnCANDataReady = false;
     bool blnCANInitialized = false;
     long unsigned int rxId;
+    uint64_t ullRxTime = 0;
     unsigned char len = 0;
     unsigned char data[CAN_DATA_BUFFER_SIZE];
+    uint32_t ulVehicleOdometer = 0;
+    uint16_t iEngineRPM = 0;
+    bool blnEngineRPMUpdated = false;
+    uint8_t iVehicleSpeed = 0;
+    bool blnVehicleSpeedUpdated = false;
 
     MCP_CAN *CAN0;
 };
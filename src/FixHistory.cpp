@@ -0,0 +1,119 @@
+#include "FixHistory.h"
+#include "Geodesy.h"
+
+#include <math.h>
+
+void FixHistory::push(const FixRecord &fix) {
+    times[head] = fix.time;
+    lats[head] = fix.point.lat;
+    lons[head] = fix.point.lon;
+    speeds[head] = fix.speed <= 0 ? 0 : fix.speed >= 655.0f ? 65500 : (uint16_t)(fix.speed * 100.0f + 0.5f);
+    courses[head] = fix.course < 0 ? FIX_HISTORY_NO_COURSE : (uint16_t)(fix.course * 100.0f + 0.5f) % 36000;
+    altitudes[head] = fix.altitude <= -32767.0f ? -32767 : fix.altitude >= 32767.0f ? 32767 : (int16_t)lroundf(fix.altitude);
+    hdops[head] = fix.hdop;
+    satellites[head] = fix.satellites;
+
+    head = (head + 1) % FIX_HISTORY_SIZE;
+    if (count < FIX_HISTORY_SIZE)
+        count++;
+}
+
+void FixHistory::clear() {
+    head = 0;
+    count = 0;
+}
+
+size_t FixHistory::size() { return count; }
+
+size_t FixHistory::capacity() { return FIX_HISTORY_SIZE; }
+
+bool FixHistory::isEmpty() { return count == 0; }
+
+size_t FixHistory::slot(size_t age) { return (head + FIX_HISTORY_SIZE - 1 - age) % FIX_HISTORY_SIZE; }
+
+// CWD-- milliseconds between the newest fix and the one at this age; immune to the millis() wrap
+unsigned long FixHistory::ageOf(size_t age) { return times[slot(0)] - times[slot(age)]; }
+
+// CWD-- signed 32-bit differences so a window straddling the millis() wrap still matches
+bool FixHistory::inRange(unsigned long time, unsigned long from, unsigned long to) {
+    return (int32_t)(uint32_t)(time - from) >= 0 && (int32_t)(uint32_t)(to - time) >= 0;
+}
+
+bool FixHistory::get(size_t age, FixRecord &fix) {
+    if (age >= count)
+        return false;
+
+    size_t i = slot(age);
+    fix.point.lat = lats[i];
+    fix.point.lon = lons[i];
+    fix.time = times[i];
+    fix.speed = speeds[i] / 100.0f;
+    fix.course = courses[i] == FIX_HISTORY_NO_COURSE ? -1.0f : courses[i] / 100.0f;
+    fix.altitude = altitudes[i];
+    fix.hdop = hdops[i];
+    fix.satellites = satellites[i];
+    return true;
+}
+
+bool FixHistory::latest(FixRecord &fix) { return get(0, fix); }
+
+// CWD-- age of the fix closest to the given time, -1 when empty. Ages grow monotonically, so binary search
+int FixHistory::nearest(unsigned long time) {
+    if (count == 0)
+        return -1;
+
+    uint32_t target = times[slot(0)] - (uint32_t)time;
+    if ((int32_t)target <= 0)
+        return 0;
+
+    if (target >= ageOf(count - 1))
+        return count - 1;
+
+    size_t lo = 0, hi = count - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (ageOf(mid) < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo > 0 && target - ageOf(lo - 1) < ageOf(lo) - target)
+        return lo - 1;
+    return lo;
+}
+
+// CWD-- copies fixes with from <= time <= to into out, oldest first. Returns how many were copied
+size_t FixHistory::range(unsigned long from, unsigned long to, FixRecord *out, size_t max) {
+    size_t n = 0;
+
+    for (size_t age = count; age-- > 0 && n < max;) {
+        if (inRange(times[slot(age)], from, to))
+            get(age, out[n++]);
+    }
+
+    return n;
+}
+
+// CWD-- distance covered between two times, summed over the recorded hops
+float FixHistory::pathLength(unsigned long from, unsigned long to) {
+    float total = 0;
+    bool blnHavePrev = false;
+    GeoPoint prev;
+
+    for (size_t age = count; age-- > 0;) {
+        size_t i = slot(age);
+        if (!inRange(times[i], from, to))
+            continue;
+
+        GeoPoint point;
+        point.lat = lats[i];
+        point.lon = lons[i];
+        if (blnHavePrev)
+            total += Geodesy::haversine(prev, point);
+        prev = point;
+        blnHavePrev = true;
+    }
+
+    return total;
+}
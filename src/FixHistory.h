@@ -0,0 +1,55 @@
+#pragma once
+#ifndef __FixHistory_h
+#define __FixHistory_h
+
+#include "GeoPoint.h"
+
+#define FIX_HISTORY_SIZE 64          // ~1 minute of 1 Hz fixes, 21 bytes each
+#define FIX_HISTORY_NO_COURSE 0xFFFF // course sentinel while crawling or before the first valid heading
+
+struct FixRecord {
+    GeoPoint point;
+    unsigned long time = 0; // millis()
+    float speed = 0;        // m/s
+    float course = -1;      // degrees, negative when unknown
+    float altitude = 0;     // meters
+    uint16_t hdop = 0;      // 100ths
+    uint8_t satellites = 0;
+};
+
+// CWD-- fixed ring of recent GPS fixes, stored struct-of-arrays so a scan over one field (times for a lookup,
+// positions for a distance) stays in contiguous memory. Ages count back from the newest fix: 0 is the latest
+class FixHistory {
+  public:
+    void push(const FixRecord &fix);
+    void clear();
+
+    size_t size();
+    size_t capacity();
+    bool isEmpty();
+
+    bool get(size_t age, FixRecord &fix);
+    bool latest(FixRecord &fix);
+    int nearest(unsigned long time);
+    size_t range(unsigned long from, unsigned long to, FixRecord *out, size_t max);
+    float pathLength(unsigned long from, unsigned long to);
+
+  private:
+    size_t slot(size_t age);
+    unsigned long ageOf(size_t age);
+    static bool inRange(unsigned long time, unsigned long from, unsigned long to);
+
+    size_t head = 0; // next slot to write
+    size_t count = 0;
+
+    uint32_t times[FIX_HISTORY_SIZE];
+    int32_t lats[FIX_HISTORY_SIZE];
+    int32_t lons[FIX_HISTORY_SIZE];
+    uint16_t speeds[FIX_HISTORY_SIZE];   // cm/s
+    uint16_t courses[FIX_HISTORY_SIZE];  // 100ths of a degree
+    int16_t altitudes[FIX_HISTORY_SIZE]; // meters
+    uint16_t hdops[FIX_HISTORY_SIZE];
+    uint8_t satellites[FIX_HISTORY_SIZE];
+};
+
+#endif // def(__FixHistory_h)
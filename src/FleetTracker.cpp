@@ -2,6 +2,14 @@
 #include "CANManager.h"
 #include "DisplayManager.h"
 #include "GPSManager.h"
+#include "Geofences.h"
+#include "JsonWriter.h"
+#include "MotionManager.h"
+#include "PublishScheduler.h"
+#include "SamplingPolicy.h"
+#include "TelemetryCodec.h"
+#include "TimeBase.h"
+#include "TrackCodec.h"
 
 #define FULL_DISPLAY_TEST_ON false
 // TODO: CWD-- normalize these to either millis() or micros() across the board
@@ -9,22 +17,38 @@
 #define CELL_GPS_REFRESH_RATE 15000000
 #define GPS_REFRESH_RATE 5000000
 #define GPS_DRIFT_WINDOW 45000000
+#define GPS_PPS_ENABLED false // CWD-- set when the receiver's 1PPS line is wired up
+#define GPS_PPS_PIN D2
 
-#define PUBLISHING_INTERVAL 5000 // 5 seconds
-#define CAN_SEND_INTERVAL 5000   // 5 second
+#define PUBLISHING_INTERVAL 5000      // 5 seconds, CAN only. GPS publishes are paced by SamplingPolicy
+#define PUBLISH_BINARY true           // CWD-- CAN and GPS records as TelemetryCodec text instead of JSON
+#define CAN_SEND_INTERVAL 5000        // 5 second
+#define ECU_SILENT_IGNITION_OFF 30000 // CWD-- the ECU stops answering OBD requests with the key off
+#define CAN_BATCH_MAX_AGE 30000       // CWD-- longest a buffered CAN frame waits for the batch to fill
 
 #define PUB_LABEL_CAN "can_data_raw"
 #define PUB_LABEL_GPS "gps_data"
+#define PUB_LABEL_TRACK "gps_track"
+#define PUB_LABEL_GEOFENCE "geofence"
+#define PUB_LABEL_MOTION "motion"
 
 bool DEBUG_ON = true;
 
 unsigned long lastGPSPublishTime = 0;
 unsigned long lastCANPublishTime = 0;
 unsigned long lastOBDRequestTime = 0;
+unsigned long lastECUReplyTime = 0;
 
 GPSManager *gpsManager = nullptr;
 DisplayManager *displayManager = nullptr;
 CANManager *canManager = nullptr;
+MotionManager *motionManager = nullptr;
+SamplingPolicy *samplingPolicy = nullptr;
+PublishScheduler *publishScheduler = nullptr;
+
+TelemetryCANRecord canBatch[TELEMETRY_CAN_BATCH_MAX]; // CWD-- binary CAN frames waiting for a full batch
+size_t canBatchCount = 0;
+unsigned long canBatchStartTime = 0; // CWD-- millis() when the oldest buffered frame came in
 
 /* CAN SEND TESTING CONSTS */
 const uint8_t SERVICE_CURRENT_DATA = 0x01; // also known as mode 1
@@ -35,12 +59,13 @@ const uint32_t OBD_CAN_REQUEST_ID = 0x7DF;
 const uint32_t OBD_CAN_REPLY_ID = 0x7E8;
 
 // Note: SAE PID codes are 8 bits. Proprietary ones are 16 bits.
-const uint8_t PID_ENGINE_RPM = 0x0C;
+const uint8_t PID_ENGINE_RPM = OBD_PID_ENGINE_RPM;
 const uint8_t PID_ENGINE_COOLANT_TEMP = 0x05;
 const uint8_t PID_FUEL_LEVEL = 0x2F;
 const uint8_t PID_FUEL_TYPE = 0x51;
 const uint8_t PID_FUEL_RATE = 0x5E;
-const uint8_t PID_VEHICLE_SPEED = 0x0D;
+const uint8_t PID_VEHICLE_SPEED = OBD_PID_VEHICLE_SPEED;
+const uint8_t PID_ODOMETER = OBD_PID_ODOMETER;
 
 byte canSendData[8] = {0x02, SERVICE_CURRENT_DATA, 0, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc};
 /* END CAN SEND TESTING CONSTS */
@@ -49,22 +74,42 @@ SYSTEM_THREAD(ENABLED);
 SerialLogHandler logHandler(LOG_LEVEL_TRACE);
 
 // CWD-- cellular geocoding callback
-void geocodedlocationCallback(float lat, float lon, float accuracy) {
-    gpsManager->log("Cell Geocoded:" + String(lat) + "," + String(lon));
-
-    if (((gpsManager->getLongitude() == 0) && (gpsManager->getLatitude() == 0)) ||
-        (micros() - gpsManager->getLastGPSUpdate()) > gpsManager->getGPSDriftWindow()) { // CWD-- been too long since we
-                                                                                         // updated off GPS. Update off the
-                                                                                         // cellular position instead
-        int s = (micros() - gpsManager->getLastGPSUpdate()) / 1000000;
-        Log.trace("Current: %d. Last GPS update: %d. Drift window: %d", micros(), gpsManager->getLastGPSUpdate(), gpsManager->getGPSDriftWindow());
-        Log.trace("GPS hasn't been updated in " + String(s) + " seconds. Updating from cellular positioning");
-        gpsManager->setAreCoordsFromGPS(false);
-        gpsManager->setLongitude(lon);
-        gpsManager->setLatitude(lat);
-        gpsManager->setIsGPSDataReady(true);
-        // gpsManager->setLastGPSUpdate(micros());
+void geocodedlocationCallback(const LocatorResult &result) {
+    Log.trace("Cell geocoded: %.6f,%.6f +/-%.0f cell %lu%s", result.lat, result.lon, result.accuracy, (unsigned long)result.cell.ci,
+              result.fromCache ? " (cached)" : "");
+    gpsManager->updateFromCell(result);
+}
+
+// CWD-- geofence enter/exit, published right away
+void geofenceCallback(uint16_t id, bool entered, const GeoPoint &point, unsigned long time) {
+    char strData[128];
+    JsonWriter json(strData, sizeof(strData));
+    json.beginObject().key("id").number(id).key("event").string(entered ? "enter" : "exit");
+    json.key("latitude").fixed(point.lat, 7).key("longitude").fixed(point.lon, 7).endObject();
+    Log.trace("Geofence event: %s", strData);
+
+    publishScheduler->send(PUB_LABEL_GEOFENCE, strData, PUBLISH_URGENT);
+}
+
+// CWD-- motion state transitions, published right away. Parking ends the trip: its distance goes out with the
+// event and the trip odometer starts over
+void motionCallback(MotionState from, MotionState to, unsigned long time) {
+    char strData[128];
+    bool blnTripEnded = to == MOTION_PARKED && from != MOTION_UNKNOWN;
+    JsonWriter json(strData, sizeof(strData));
+    json.beginObject().key("from").string(MotionManager::getStateName(from)).key("to").string(MotionManager::getStateName(to));
+    json.key("time").number(Time.isValid() ? Time.now() - (millis() - time) / 1000 : 0);
+    if (blnTripEnded) {
+        json.key("trip").number(lround(gpsManager->getOdometer().getTripMeters()));
+        gpsManager->getOdometer().resetTrip();
     }
+    json.endObject();
+    Log.trace("Motion event: %s", strData);
+    samplingPolicy->setMotionState(to);
+    gpsManager->setCellRefreshInterveral(samplingPolicy->getCellRefreshInterval());
+    gpsManager->setStationary(to == MOTION_PARKED || to == MOTION_IDLING);
+
+    publishScheduler->send(PUB_LABEL_MOTION, strData, PUBLISH_URGENT);
 }
 
 // CWD-- particle accessors
@@ -80,23 +125,58 @@ double getAlt() { return gpsManager->getAltitude(); }
 
 double getSpeed() { return gpsManager->getSpeed(); }
 
-String getDate() { return gpsManager->getDate(); }
+String getDate() {
+    char strDate[12];
+    gpsManager->formatDate(strDate, sizeof(strDate));
+    return String(strDate);
+}
 
-String getTime() { return gpsManager->getTime(); }
+String getTime() {
+    char strTime[12];
+    gpsManager->formatTime(strTime, sizeof(strTime));
+    return String(strTime);
+}
 
 int getSatellitesCount() { return gpsManager->getSatellitesCount(); }
 
+double getTripDistance() { return gpsManager->getDistanceMoved(); }
+
+int getOdometer() { return gpsManager->getOdometer().getLifetimeMeters(); }
+
 unsigned long lastGPSUpdate() { return gpsManager->getLastGPSUpdate(); }
 
 bool areCoordsFromGPS() { return gpsManager->areCoordsFromGPS(); }
 
+String getMotionState() { return MotionManager::getStateName(motionManager->getState()); }
+
+String getPolicy() { return samplingPolicy->describe(); }
+
+String getLinkStats() { return publishScheduler->describe(); }
+
+String getNMEAStats() { return gpsManager->describeNMEA(); }
+
+String getCellCacheStats() {
+    CellLocationCache &cache = gpsManager->getCellCache();
+    return String::format("towers=%u,hits=%lu,misses=%lu,rate=%.2f", cache.size(), (unsigned long)cache.getHits(),
+                          (unsigned long)cache.getMisses(), cache.getHitRate());
+}
+
+String getOdometerStats() { return gpsManager->getOdometer().describe(); }
+
+int setPolicy(String params) { return samplingPolicy->configure(params.c_str()); }
+
+int resetTrip(String params) {
+    gpsManager->getOdometer().resetTrip();
+    return 0;
+}
+
 // CWD-- processing
 String formatDecimal(double f) { return String(f, 3); }
 
 void updateDisplay() {
     time_t time = Time.now();
     String str = Time.format(time, TIME_FORMAT_ISO8601_FULL) + "\n";
-    str += formatDecimal(gpsManager->getLatitude()) + "," + formatDecimal(gpsManager->getLongitude()) + (gpsManager->areCoordsFromGPS() ? "(g)" : "(c)") + "\n";
+    str += formatDecimal(gpsManager->getLatitude()) + "," + formatDecimal(gpsManager->getLongitude()) + "(" + gpsManager->getLocationSourceTag() + ")\n";
     str += "Alt:" + formatDecimal(gpsManager->getAltitude()) + "\n";
     str += "Sat Count:" + String(gpsManager->getSatellitesCount()) + "\n";
     displayManager->update(str);
@@ -119,19 +199,113 @@ void setup() {
     Particle.variable("satellitesCount", getSatellitesCount);
     Particle.variable("lastGPSUpdate", lastGPSUpdate);
     Particle.variable("coordsFromGPS", areCoordsFromGPS);
+    Particle.variable("tripDistance", getTripDistance);
+    Particle.variable("odometer", getOdometer);
+    Particle.variable("odometerStats", getOdometerStats);
+    Particle.variable("motionState", getMotionState);
+    Particle.variable("policy", getPolicy);
+    Particle.variable("nmea", getNMEAStats);
+    Particle.variable("link", getLinkStats);
+    Particle.variable("cellCache", getCellCacheStats);
+    Particle.function("setPolicy", setPolicy);
+    Particle.function("resetTrip", resetTrip);
 
     Log.info("Display setup...");
     displayManager = new DisplayManager(SCREEN_REFRESH_RATE, FULL_DISPLAY_TEST_ON);
     Log.info("done.\nGPS setup...");
     gpsManager = new GPSManager(geocodedlocationCallback, GPS_REFRESH_RATE, CELL_GPS_REFRESH_RATE, GPS_DRIFT_WINDOW, false);
+    gpsManager->getGeofences().begin(GEOFENCES, sizeof(GEOFENCES) / sizeof(GEOFENCES[0]), GEOFENCE_VERTICES,
+                                     sizeof(GEOFENCE_VERTICES) / sizeof(GEOFENCE_VERTICES[0]));
+    gpsManager->getGeofences().withCallback(geofenceCallback);
+    if (GPS_PPS_ENABLED)
+        timeBase.attachPPS(GPS_PPS_PIN);
     Log.info("done.\nCAN setup...");
     canManager = new CANManager(CAN0_DEFAULT_INT, CAN0_DEFAULT_CS, DEBUG_ON);
+    samplingPolicy = new SamplingPolicy(CELL_GPS_REFRESH_RATE);
+    publishScheduler = new PublishScheduler();
+    publishScheduler->begin();
+    motionManager = new MotionManager();
+    motionManager->subscribe(motionCallback);
     Log.info("done.");
     Log.info("System ready!");
     lastGPSPublishTime = millis();
     lastCANPublishTime = millis();
 }
 
+// CWD-- batched upload of the simplified track, a TrackCodec delta stream or {"t0":unix ms,"p":[[lat,lon,dt_ms],...]}
+bool publishTrack() {
+    static char strTrack[1024];
+    TrackSimplifier &track = gpsManager->getTrack();
+    const TrackPoint *points = track.getTrack();
+    size_t count = track.getTrackSize();
+
+    if (count == 0) {
+        return false;
+    }
+
+    size_t maxLen = min(sizeof(strTrack), (size_t)Particle.maxEventDataSize());
+    size_t len;
+    size_t sent = 0;
+
+    if (PUBLISH_BINARY) {
+        static uint8_t encoded[sizeof(strTrack) * 4 / 5];
+        TrackEncoder encoder;
+        encoder.begin(encoded, (maxLen - 4) * 4 / 5); // CWD-- what still fits as quoted "z<base85>" with the null
+        while (sent < count && encoder.add(points[sent].point.lat, points[sent].point.lon, timeBase.unixMillis(points[sent].time))) {
+            sent++;
+        }
+        len = TelemetryCodec::toText(encoded, encoder.getLength(), strTrack, maxLen);
+    } else {
+        JsonWriter json(strTrack, maxLen);
+        json.beginObject().key("t0").number(timeBase.unixMillis(points[0].time)).key("p").beginArray();
+
+        for (; sent < count; sent++) {
+            JsonWriter before = json; // CWD-- roll back a point that doesn't fit, the writer keeps room for "]}"
+            json.beginArray().fixed(points[sent].point.lat, 7).fixed(points[sent].point.lon, 7).number(points[sent].time - points[0].time).endArray();
+            if (json.isOverflowed()) {
+                json = before;
+                break;
+            }
+        }
+
+        json.endArray().endObject();
+        len = json.length();
+    }
+
+    Log.info("Track: %lu in, %lu out, ratio %.1f, max error %.1f m, %u points in %u bytes", track.getPointsIn(), track.getPointsOut(),
+             track.getCompressionRatio(), track.getMaxError(), (unsigned)sent, (unsigned)len);
+
+    if (!publishScheduler->send(PUB_LABEL_TRACK, strTrack, PUBLISH_BULK)) {
+        Log.error("Failed to publish or queue GPS track");
+        return false;
+    }
+
+    track.consumeTrack(sent);
+    return true;
+}
+
+// CWD-- the buffered CAN frames as one TelemetryCodec batch record
+bool publishCANBatch() {
+    static uint8_t encoded[TELEMETRY_CAN_BATCH_BYTES];
+    static char strData[TELEMETRY_CAN_BATCH_BYTES * 5 / 4 + 8];
+    size_t frames = canBatchCount;
+    canBatchCount = 0;
+
+    size_t len = TelemetryCodec::encodeCANBatch(canBatch, frames, encoded, sizeof(encoded));
+    if (len == 0 || TelemetryCodec::toText(encoded, len, strData, sizeof(strData)) == 0) {
+        Log.error("Failed to encode %u CAN frames", (unsigned)frames); // CWD-- rather than publish an empty "z" record
+        return false;
+    }
+
+    Log.trace("Publishing %u CAN frames: %s", (unsigned)frames, strData);
+    if (!publishScheduler->send(PUB_LABEL_CAN, strData, PUBLISH_BULK)) { // CWD-- queued in flash while offline or on weak signal
+        Log.error("Failed to publish or queue CAN data");
+        return false;
+    }
+    Log.trace("Published CAN data");
+    return true;
+}
+
 byte requestCAN(uint8_t pid) {
     canSendData[2] = pid;
     byte sndStat = canManager->sendData(OBD_CAN_REQUEST_ID, 0, 8, canSendData);
@@ -143,63 +317,138 @@ byte requestCAN(uint8_t pid) {
 void loop() {
     gpsManager->update();
     canManager->update();
+    publishScheduler->update(millis(), gpsManager->isModemBusy());
 
     if ((millis() - lastOBDRequestTime) > CAN_SEND_INTERVAL) {
-        byte sndStat = requestCAN(PID_FUEL_RATE);
+        byte sndStat = requestCAN(PID_ENGINE_RPM);
+        Log.trace("CAN send status for Engine RPM request: %d", sndStat);
+        sndStat = requestCAN(PID_FUEL_RATE);
         Log.trace("CAN send status for Fuel Rate request: %d", sndStat);
         sndStat = requestCAN(PID_FUEL_LEVEL);
         Log.trace("CAN send status for Fuel Level request: %d", sndStat);
+        sndStat = requestCAN(PID_VEHICLE_SPEED);
+        Log.trace("CAN send status for Vehicle Speed request: %d", sndStat);
+        sndStat = requestCAN(PID_ODOMETER);
+        Log.trace("CAN send status for Odometer request: %d", sndStat);
         lastOBDRequestTime = millis();
     }
 
-    if (Particle.connected() && canManager->isCANDataReady()) {
-        char strTemp[64];
-        String str = "{\"id\":";
-        sprintf(strTemp, "\"0x%.2X\"", canManager->getCANRxId());
-        str += String(strTemp) + ", \"data\": [";
+    if (canManager->isVehicleSpeedUpdated()) {
+        gpsManager->updateVehicleSpeed(canManager->getVehicleSpeed());
+    }
+
+    if (canManager->getVehicleOdometer() != 0) {
+        gpsManager->getOdometer().setVehicleOdometer(canManager->getVehicleOdometer());
+    }
 
-        unsigned char *canData = canManager->getCANData();
-        int len = CAN_DATA_BUFFER_SIZE;
+    // CWD-- ignition is inferred from whether the ECU answers at all, and only once it has answered since boot:
+    // a tracker that isn't on a CAN bus knows nothing about the engine, rather than that it's always off
+    if (canManager->isEngineRPMUpdated()) {
+        motionManager->updateEngine(canManager->getEngineRPM(), millis());
+        motionManager->setIgnition(true, millis());
+        lastECUReplyTime = millis();
+    } else if (lastECUReplyTime != 0 && (millis() - lastECUReplyTime) > ECU_SILENT_IGNITION_OFF) {
+        motionManager->setIgnition(false, millis());
+        if (canBatchCount > 0) {
+            publishCANBatch(); // CWD-- nothing more is coming to fill it
+        }
+    }
 
-        for (byte i = 0; i < len; i++) {
-            sprintf(strTemp, "\"0x%.2X\",", canData[i]);
-            str += strTemp;
+    motionManager->update(gpsManager->getSpeed() * 0.44704, gpsManager->getLocation(), millis());
+
+    if (canManager->isCANDataReady() && (millis() - lastCANPublishTime) <= PUBLISHING_INTERVAL) {
+        Log.trace("Not publishing CAN data yet. Waiting...");
+    } else if (canManager->isCANDataReady()) {
+        if (PUBLISH_BINARY) {
+            // CWD-- buffered and sent a batch at a time, so the frames share one base time
+            if (canBatchCount == 0) {
+                canBatchStartTime = millis();
+            }
+            TelemetryCANRecord &record = canBatch[canBatchCount++];
+            record.time = timeBase.toUnixMicros(canManager->getCANRxTime()) / 1000;
+            record.id = canManager->getCANRxId();
+            record.length = CAN_DATA_BUFFER_SIZE;
+            memcpy(record.data, canManager->getCANData(), CAN_DATA_BUFFER_SIZE);
+            if (canBatchCount == TELEMETRY_CAN_BATCH_MAX) {
+                publishCANBatch();
+            }
+        } else {
+            char strData[160];
+            JsonWriter json(strData, sizeof(strData));
+            json.beginObject().key("id").hex(canManager->getCANRxId()).key("data").beginArray();
+
+            unsigned char *canData = canManager->getCANData();
+            for (byte i = 0; i < CAN_DATA_BUFFER_SIZE; i++) {
+                json.hex(canData[i]);
+            }
+
+            json.endArray().key("ts").number(timeBase.toUnixMicros(canManager->getCANRxTime()) / 1000).endObject();
+
+            Log.trace("Publishing CAN data: %s", strData);
+            if (publishScheduler->send(PUB_LABEL_CAN, strData, PUBLISH_BULK)) { // CWD-- queued in flash while offline or on weak signal
+                Log.trace("Published CAN data");
+            } else {
+                Log.error("Failed to publish or queue CAN data");
+            }
         }
 
-        str.remove(str.length() - 1);
+        canManager->setCANDataReady(false); // CWD-- may not really be necessary
+        lastCANPublishTime = millis();
+    }
 
-        str += "]}";
+    if (canBatchCount > 0 && (millis() - canBatchStartTime) >= CAN_BATCH_MAX_AGE) {
+        publishCANBatch(); // CWD-- a slow bus shouldn't hold frames back indefinitely
+    }
 
-        if ((millis() - lastCANPublishTime) > PUBLISHING_INTERVAL) {
-            Log.trace("Publishing CAN data");
-            Log.trace(str);
-            Particle.publish(PUB_LABEL_CAN, str);
-            Log.trace("Published CAN data");
-            canManager->setCANDataReady(false); // CWD-- may not really be necessary
-            // CWD-- call for data from the ECU
-            lastCANPublishTime = millis();
+    if (samplingPolicy->shouldPublish(gpsManager->getLocation(), gpsManager->getCourse(), gpsManager->getSpeed() * 0.44704, millis())) {
+        GeoPoint location = gpsManager->getLocation();
+        char strData[256];
+        size_t dataLen = 0;
+        if (PUBLISH_BINARY) {
+            TelemetryGPSRecord record;
+            record.time = timeBase.toUnixMicros(gpsManager->getLastGPSFixTime()) / 1000;
+            record.lat = location.lat;
+            record.lon = location.lon;
+            record.altitude = lround(gpsManager->getAltitude() * 3.048); // CWD-- feet to decimeters
+            record.speed = lround(gpsManager->getSpeed() * 44.704);      // CWD-- mph to cm/s
+            record.satellites = gpsManager->getSatellitesCount();
+            record.source = gpsManager->getLocationSource();
+            uint8_t encoded[TELEMETRY_RECORD_MAX];
+            size_t len = TelemetryCodec::encodeGPS(record, encoded, sizeof(encoded));
+            dataLen = len > 0 ? TelemetryCodec::toText(encoded, len, strData, sizeof(strData)) : 0;
+        } else {
+            char strDate[12];
+            char strTime[12];
+            gpsManager->formatDate(strDate, sizeof(strDate));
+            gpsManager->formatTime(strTime, sizeof(strTime));
+            JsonWriter json(strData, sizeof(strData));
+            json.beginObject().key("longitude").fixed(location.lon, 7).key("latitude").fixed(location.lat, 7);
+            json.key("altitude").fixed(lround(gpsManager->getAltitude() * 100), 2).key("speed").fixed(lround(gpsManager->getSpeed() * 100), 2);
+            json.key("satellites").number(gpsManager->getSatellitesCount()).key("date").string(strDate).key("time").string(strTime);
+            json.key("source").string(gpsManager->getLocationSourceTag());
+            json.key("ts").number(timeBase.toUnixMicros(gpsManager->getLastGPSFixTime()) / 1000).endObject();
+            dataLen = json.isOverflowed() ? 0 : json.length();
+        }
+        if (dataLen == 0) {
+            Log.error("Failed to encode GPS data"); // CWD-- rather than publish an empty "z" record
         } else {
-            // TODO-- buffer the data and publish it later in bulk
-            Log.trace("Not publishing CAN data yet. Waiting...");
+            Log.trace("Publishing GPS data: %s", strData);
+            // CWD-- routine points ride the bulk queue; urgent is for geofence and motion events
+            bool success = publishScheduler->send(PUB_LABEL_GPS, strData, PUBLISH_BULK);
+
+            // CWD-- only a record that went out or was queued moves the policy's anchors
+            if (success) {
+                Log.trace("Published GPS data");
+                samplingPolicy->published(location, gpsManager->getCourse(), millis(), dataLen);
+                lastGPSPublishTime = millis();
+            } else {
+                Log.error("Failed to publish or queue GPS data");
+            }
         }
     }
 
-    if (Particle.connected() && ((millis() - lastGPSPublishTime) > PUBLISHING_INTERVAL)) {
-        String strData = String::format("{ \"longitude\": %f, \"latitude\": %f, \"altitude\": %f, \"speed\": "
-                                        "%f, \"satellites\": %d, \"date\": \"%s\", \"time\": \"%s\" }",
-                                        gpsManager->getLongitude(), gpsManager->getLatitude(), gpsManager->getAltitude(), gpsManager->getSpeed(),
-                                        gpsManager->getSatellitesCount(), gpsManager->getDate().c_str(), gpsManager->getTime().c_str());
-        Log.trace(strData);
-        Log.trace("Publishing GPS data: %s", strData.c_str());
-        bool success;
-        success = Particle.publish(PUB_LABEL_GPS, strData.c_str());
-
-        if (success)
-            Log.trace("Published GPS data");
-        else
-            Log.error("Failed to publish GPS data");
-
-        lastGPSPublishTime = millis();
+    if (gpsManager->getTrack().isTrackFull()) {
+        publishTrack();
     }
 
     updateDisplay();
@@ -1,4 +1,5 @@
 #include "GPSManager.h"
+#include "Geodesy.h"
 #include <TinyGPS++.h>
 #include <locator.h>
 #include <math.h>
@@ -9,12 +10,16 @@ GPSManager::GPSManager(LocatorSubscriptionCallback locatorCallback, unsigned lon
     ulGPSRefreshInterveral = gpsRefreshInterveral;
     ulCellRefreshInterveral = cellRefreshInterveral;
     ulGPSDriftWindow = gpsDriftWindow;
+    odometer.begin();
+    cellCache.begin();
     // CWD-- start serial for GPS
     ss.begin(9600);
 
     // CWD-- config Particle Google Integration to be on demand
     log("Setting cell gps event name to: " + PUB_PREFIX + "cell");
     locator.withEventName(PUB_PREFIX + "cell");
+    locator.withAsyncScan(); // CWD-- AT exchanges run on a worker thread, results are published from update()
+    locator.withCache(&cellCache); // CWD-- towers we've already resolved don't need the webhook
     locator.publishLocation();
     // auto locatorCallback = [this](float lat, float lon, float accuracy) { this->geocodedlocationCallback(lat, lon, accuracy); };
     locator.withSubscribe(locatorCallback); //.withLocatePeriodic(CELL_GPS_PERIODIC_PUBLISH_INTERVAL);
@@ -27,17 +32,16 @@ void GPSManager::update() {
     // CWD-- Particle Google Maps Integration call
     locator.loop();
     checkGPS(); // CWD-- run through the serial buffer and ingest the data
-
-    if ((micros() - ulLastCellGPSUpdate) > ulCellRefreshInterveral) { // CWD-- update the location via cell geocoding
-        if (Particle.connected()) {
-            log("Connected to particle...");
-            log("Publishing Celluar GPS Locator...");
-            locator.publishLocation();
-            ulLastCellGPSUpdate = micros();
-            log("Published Celluar GPS Locator event");
-        } else {
-            log("Can't connect to particle"); // CWD-- need to buffer data
-        }
+    deadReckon();
+    checkNMEAHealth();
+
+    // CWD-- update the location via cell geocoding. Not gated on the cloud connection: a tower already in the
+    // cache resolves locally, offline too. The locator only needs the cloud on a cache miss and checks for it there
+    if ((timeBase.now() - ullLastCellGPSUpdate) > ulCellRefreshInterveral) {
+        log("Publishing Celluar GPS Locator...");
+        locator.publishLocation();
+        ullLastCellGPSUpdate = timeBase.now();
+        log(Particle.connected() ? "Published Celluar GPS Locator event" : "Not connected, cell location from the cache only");
     }
 }
 
@@ -52,53 +56,36 @@ void GPSManager::log(String str, bool blnWithNewLine) {
 }
 
 void GPSManager::processData() { // Update GPS data
+    bool blnLocationUpdated = false;
+
     if (gps.location.isValid() && gps.location.isUpdated()) {
         if (blnDebugOn) {
             log("Previous Latitude= ");
-            log(String(dblLatitude, 6));
+            log(String(location.latitude(), 6));
             log("Previous  Longitude= ");
-            log(String(dblPrevLongitude, 6));
+            log(String(location.longitude(), 6));
         }
-        // Latitude in degrees (double)
-        blnCoordsFromGPS = true;
-        dblPrevLongitude = dblLongitude;
-        dblPrevLatitude = dblLatitude;
-        dblLongitude = gps.location.lng();
-        dblLatitude = gps.location.lat();
-        ulLastGPSUpdate = micros();
+        // CWD-- carry the raw degrees straight into fixed-point, no double conversion on the hot path
+        locationSource = LOCATION_SOURCE_GPS;
+        gpsFix = GeoPoint::fromRaw(gps.location.rawLat(), gps.location.rawLng());
+        ullLastGPSUpdate = timeBase.now();
         blnGPSDataReady = true;
+        blnLocationUpdated = true;
 
         if (blnDebugOn) {
+            char strLat[GEO_E7_STR_LEN];
+            char strLng[GEO_E7_STR_LEN];
+            GeoPoint::formatE7(gpsFix.lat, strLat, sizeof(strLat));
+            GeoPoint::formatE7(gpsFix.lon, strLng, sizeof(strLng));
             log("Latitude= ", false);
-            log(String(dblLatitude, 6), false);
-            // Longitude in degrees (double)
+            log(strLat, false);
             log(" Longitude= ", false);
-            log(String(dblLongitude, 6));
-
-            // Raw latitude in whole degrees
-            log("Raw latitude = ", false);
-            log(gps.location.rawLat().negative ? "-" : "+", false);
-            log(String(gps.location.rawLat().deg));
-            // ... and billionths (u16/u32)
-            log(String(gps.location.rawLat().billionths));
-
-            // Raw longitude in whole degrees
-            log("Raw longitude = ", false);
-            log(gps.location.rawLng().negative ? "-" : "+", false);
-            log(String(gps.location.rawLng().deg));
-            // ... and billionths (u16/u32)
-            log(String(gps.location.rawLng().billionths));
+            log(strLng);
         }
     }
 
     if (gps.date.isValid() && gps.date.isUpdated()) {
         // Raw date in DDMMYY format (u32)
-        strDate = gps.date.year();
-        strDate += "/";
-        strDate += gps.date.month();
-        strDate += "/";
-        strDate += gps.date.day();
-
         if (blnDebugOn) {
             log("Raw date DDMMYY = ", false);
             log(String(gps.date.value()), false);
@@ -116,11 +103,11 @@ void GPSManager::processData() { // Update GPS data
 
     if (gps.time.isValid() && gps.time.isUpdated()) {
         // Raw time in HHMMSSCC format (u32)
-        strTime = gps.time.hour();
-        strTime += ":";
-        strTime += gps.time.minute();
-        strTime += ":";
-        strTime += gps.time.second();
+        if (gps.date.isValid()) { // CWD-- pack the epoch and discipline the shared timebase off GPS UTC
+            ulEpoch = TimeBase::unixTime(gps.date.year(), gps.date.month(), gps.date.day(), gps.time.hour(), gps.time.minute(), gps.time.second());
+            iEpochCentis = gps.time.centisecond();
+            timeBase.discipline(ulEpoch, iEpochCentis);
+        }
 
         if (blnDebugOn) {
             log("Raw time in HHMMSSCC = ", false);
@@ -163,10 +150,17 @@ void GPSManager::processData() { // Update GPS data
     }
 
     if (gps.course.isValid() && gps.course.isUpdated()) {
+        int32_t course = gps.course.value();
+
+        if (dblSpeed > 2.0) { // CWD-- course is noise when crawling, keep the last good heading for dead reckoning
+            fCourse = course / 100.0f;
+            blnCourseValid = true;
+        }
+
         if (blnDebugOn) {
             // Raw course in 100ths of a degree (i32)
             log("Raw course in degrees = ", false);
-            log(String(gps.course.value()), false);
+            log(String(course), false);
             // Course in degrees (double)
             log("\tCourse in degrees = ", false);
             log(String(gps.course.deg()));
@@ -214,22 +208,112 @@ void GPSManager::processData() { // Update GPS data
     }
 
     if (gps.hdop.isValid() && gps.hdop.isUpdated()) {
+        iHDOP = gps.hdop.value();
+
         if (blnDebugOn) {
             // Horizontal Dim. of Precision (100ths-i32)
             log("HDOP = ", false);
-            log(String(gps.hdop.value()));
+            log(String(iHDOP));
+        }
+    }
+
+    // CWD-- TinyGPS++ commits the location on both RMC and GGA, so every fix shows up twice. Only a new UTC
+    // time is a new measurement; feeding the repeat would double-count it in the filter, history, odometer
+    // and track, and satisfy the geofence confirmation count from a single epoch
+    if (blnLocationUpdated && gps.time.isValid()) {
+        if (gps.time.value() == ulLastFixTime) {
+            blnLocationUpdated = false;
+        }
+        ulLastFixTime = gps.time.value();
+    }
+
+    if (blnLocationUpdated) { // CWD-- speed/HDOP above are from the same sentence batch
+        // CWD-- the history is the one record of this epoch; everything downstream reads the same fix
+        FixRecord fix;
+        fix.point = gpsFix;
+        fix.time = millis();
+        fix.speed = dblSpeed * 0.44704;
+        fix.course = blnCourseValid ? fCourse : -1.0f;
+        fix.altitude = dblAltitude * 0.3048;
+        fix.hdop = iHDOP;
+        fix.satellites = iSatellitesCount;
+        history.push(fix);
+
+        filter.updatePosition(fix.point, PositionFilter::gpsSigma(fix.hdop), fix.time);
+        location = filter.getPosition();
+        odometer.addFix(fix);
+        track.add(location, fix.time);
+        geofences.update(location, fix.time);
+    }
+}
+
+// CWD-- cell geolocation always goes through the filter, weighted by its reported accuracy. It only takes
+// over as the coordinate source once GPS has been quiet for longer than the drift window. The same tower
+// resolving to the same spot again isn't an independent measurement, so it isn't fed to the filter twice
+void GPSManager::updateFromCell(const LocatorResult &result) {
+    bool blnRepeat = result.cell.isValid() && result.cell == lastCellResult.cell && result.lat == lastCellResult.lat &&
+                     result.lon == lastCellResult.lon;
+    lastCellResult = result;
+
+    if (!blnRepeat) {
+        filter.updatePosition(GeoPoint::fromDegrees(result.lat, result.lon), PositionFilter::cellSigma(result.accuracy), millis());
+    }
+
+    if (!location.isSet() || (timeBase.now() - ullLastGPSUpdate) > ulGPSDriftWindow) {
+        int s = (timeBase.now() - ullLastGPSUpdate) / 1000000;
+        Log.trace("GPS hasn't been updated in %d seconds. Updating from cellular positioning", s);
+
+        if (locationSource != LOCATION_SOURCE_DEAD_RECKONING) { // CWD-- a live dead reckoning track beats a coarse cell fix
+            locationSource = LOCATION_SOURCE_CELL;
         }
+
+        blnGPSDataReady = true;
+    }
+
+    location = filter.getPosition();
+}
+
+void GPSManager::updateVehicleSpeed(float kmh) {
+    fVehicleSpeed = kmh / 3.6f;
+    ulLastVehicleSpeed = millis();
+
+    if ((timeBase.now() - ullLastGPSUpdate) > DEAD_RECKONING_GPS_TIMEOUT && blnCourseValid) {
+        filter.updateVelocity(fVehicleSpeed, fCourse, fmaxf(0.5f, fVehicleSpeed * DEAD_RECKONING_HEADING_ERROR), ulLastVehicleSpeed);
+    } else {
+        filter.updateSpeed(fVehicleSpeed, 0.5f, ulLastVehicleSpeed);
     }
 }
 
+// CWD-- GPS dropped out (tunnel, parking garage): carry the position forward along the last GPS course at the
+// CAN reported speed. The filter's covariance keeps growing, so accuracy degrades honestly until a fix returns
+void GPSManager::deadReckon() {
+    unsigned long now = millis();
+
+    if ((timeBase.now() - ullLastGPSUpdate) < DEAD_RECKONING_GPS_TIMEOUT || !filter.isInitialized() || !blnCourseValid ||
+        ulLastVehicleSpeed == 0 || (now - ulLastVehicleSpeed) > DEAD_RECKONING_SPEED_MAX_AGE || (now - ulLastDeadReckon) < DEAD_RECKONING_INTERVAL) {
+        return;
+    }
+
+    if (locationSource != LOCATION_SOURCE_DEAD_RECKONING) {
+        Log.trace("GPS lost, dead reckoning at %.1f m/s, course %.0f", fVehicleSpeed, fCourse);
+        filter.updateVelocity(fVehicleSpeed, fCourse, fmaxf(0.5f, fVehicleSpeed * DEAD_RECKONING_HEADING_ERROR), now);
+    }
+
+    filter.predict(now);
+    location = filter.getPosition();
+    locationSource = LOCATION_SOURCE_DEAD_RECKONING;
+    blnGPSDataReady = true;
+    ulLastDeadReckon = now;
+}
+
 void GPSManager::checkGPS() { // Check GPS
     //   Serial.print("Waiting for GPS Data: ");
     //   Serial.println(ss.available());
     while (ss.available() > 0) { // CWD-- we have data on the serial
         // get the byte data from the GPS
         byte gpsData = ss.read();
-        gps.encode(gpsData);
-        processData();
+        if (gps.encode(gpsData)) // CWD-- fields only change when a sentence passes its checksum, skip the rest
+            processData();
         // delay(100);
         // if(blnDebugOn) {
         // Serial.write(gpsData);
@@ -237,14 +321,69 @@ void GPSManager::checkGPS() { // Check GPS
     }
 }
 
-bool GPSManager::areCoordsFromGPS() { return blnCoordsFromGPS; }
+// CWD-- parked on the same towers there's nothing new for the cell locator to find, let it reuse its last scan
+void GPSManager::setStationary(bool stationary) { locator.setStationary(stationary); }
+
+bool GPSManager::isModemBusy() { return locator.isScanning(); }
+
+// CWD-- watch the TinyGPS++ counters in the field: a silent receiver or a noisy serial line shows up here first
+void GPSManager::checkNMEAHealth() {
+    unsigned long now = millis();
+    if ((now - ulLastNMEACheck) < NMEA_HEALTH_INTERVAL)
+        return;
+    ulLastNMEACheck = now;
+
+    uint32_t chars = gps.charsProcessed() - ulLastCharsProcessed;
+    uint32_t passed = gps.passedChecksum() - ulLastPassedChecksums;
+    uint32_t failed = gps.failedChecksum() - ulLastFailedChecksums;
+    ulLastCharsProcessed = gps.charsProcessed();
+    ulLastPassedChecksums = gps.passedChecksum();
+    ulLastFailedChecksums = gps.failedChecksum();
+
+    if (chars == 0)
+        Log.warn("No NMEA data from the GPS in the last %lu ms", (unsigned long)NMEA_HEALTH_INTERVAL);
+    else if (failed > (passed + failed) * NMEA_CHECKSUM_WARN_RATIO)
+        Log.warn("NMEA checksum failures: %lu of %lu sentences", (unsigned long)failed, (unsigned long)(passed + failed));
+}
+
+uint32_t GPSManager::getCharsProcessed() { return gps.charsProcessed(); }
+
+uint32_t GPSManager::getPassedChecksums() { return gps.passedChecksum(); }
+
+uint32_t GPSManager::getFailedChecksums() { return gps.failedChecksum(); }
+
+uint32_t GPSManager::getSentencesWithFix() { return gps.sentencesWithFix(); }
+
+String GPSManager::describeNMEA() {
+    return String::format("chars=%lu,ok=%lu,bad=%lu,fix=%lu", (unsigned long)gps.charsProcessed(), (unsigned long)gps.passedChecksum(),
+                          (unsigned long)gps.failedChecksum(), (unsigned long)gps.sentencesWithFix());
+}
+
+CellLocationCache &GPSManager::getCellCache() { return cellCache; }
+
+bool GPSManager::areCoordsFromGPS() { return locationSource == LOCATION_SOURCE_GPS; }
 
 bool GPSManager::setAreCoordsFromGPS(bool areCoordsFromGPS) {
-    bool t = blnCoordsFromGPS;
-    this->blnCoordsFromGPS = areCoordsFromGPS;
+    bool t = this->areCoordsFromGPS();
+    this->locationSource = areCoordsFromGPS ? LOCATION_SOURCE_GPS : LOCATION_SOURCE_CELL;
     return t;
 }
 
+LocationSource GPSManager::getLocationSource() { return locationSource; }
+
+const char *GPSManager::getLocationSourceTag() {
+    switch (locationSource) {
+    case LOCATION_SOURCE_GPS:
+        return "g";
+    case LOCATION_SOURCE_CELL:
+        return "c";
+    case LOCATION_SOURCE_DEAD_RECKONING:
+        return "d";
+    default:
+        return "-";
+    }
+}
+
 bool GPSManager::isGPSDataReady() { return blnGPSDataReady; }
 
 bool GPSManager::setIsGPSDataReady(bool isReady) {
@@ -253,37 +392,57 @@ bool GPSManager::setIsGPSDataReady(bool isReady) {
     return t;
 }
 
-double GPSManager::getLongitude() { return dblLongitude; }
+double GPSManager::getLongitude() { return location.longitude(); }
 
 double GPSManager::setLongitude(double longitude) {
-    dblPrevLongitude = dblLongitude;
-    this->dblLongitude = longitude;
-    return dblPrevLongitude;
+    double t = location.longitude();
+    location.lon = GeoPoint::fromDegrees(0, longitude).lon;
+    return t;
 }
 
-double GPSManager::getPrevLongitude() { return dblPrevLongitude; }
+double GPSManager::getPrevLongitude() { return getPrevLocation().longitude(); }
 
 double GPSManager::setLatitude(double latitude) {
-    dblPrevLatitude = dblLatitude;
-    this->dblLatitude = latitude;
-    return dblPrevLatitude;
+    double t = location.latitude();
+    location.lat = GeoPoint::fromDegrees(latitude, 0).lat;
+    return t;
 }
 
-double GPSManager::getLatitude() { return dblLatitude; }
+double GPSManager::getLatitude() { return location.latitude(); }
+
+double GPSManager::getPrevLatitude() { return getPrevLocation().latitude(); }
 
-double GPSManager::getPrevLatitude() { return dblPrevLatitude; }
+GeoPoint GPSManager::getLocation() { return location; }
+
+GeoPoint GPSManager::setLocation(GeoPoint location) {
+    GeoPoint t = this->location;
+    this->location = location;
+    return t;
+}
+
+// CWD-- the GPS fix before the latest one, from the history
+GeoPoint GPSManager::getPrevLocation() {
+    FixRecord fix;
+    return history.get(1, fix) ? fix.point : GeoPoint();
+}
 
 double GPSManager::getAltitude() { return dblAltitude; }
 
 double GPSManager::getSpeed() { return dblSpeed; }
 
+float GPSManager::getCourse() { return fCourse; }
+
+float GPSManager::getAccuracy() { return filter.getAccuracy(); }
+
 int GPSManager::getSatellitesCount() { return iSatellitesCount; }
 
-unsigned long GPSManager::getLastGPSUpdate() { return ulLastGPSUpdate; }
+unsigned long GPSManager::getLastGPSUpdate() { return (unsigned long)ullLastGPSUpdate; }
+
+uint64_t GPSManager::getLastGPSFixTime() { return ullLastGPSUpdate; }
 
 unsigned long GPSManager::setLastGPSUpdate(unsigned long lastGPSUpdate) {
     unsigned long t = lastGPSUpdate;
-    this->ulLastGPSUpdate = lastGPSUpdate;
+    this->ullLastGPSUpdate = lastGPSUpdate;
     return t;
 }
 
@@ -291,13 +450,49 @@ unsigned long GPSManager::getGPSRefreshInterveral() { return ulGPSRefreshInterve
 
 unsigned long GPSManager::getCellRefreshInterveral() { return ulCellRefreshInterveral; }
 
+unsigned long GPSManager::setCellRefreshInterveral(unsigned long cellRefreshInterveral) {
+    unsigned long t = ulCellRefreshInterveral;
+    this->ulCellRefreshInterveral = cellRefreshInterveral;
+    return t;
+}
+
 unsigned long GPSManager::getGPSDriftWindow() { return ulGPSDriftWindow; }
 
-double GPSManager::getDistanceMoved() { return dblDistanceMoved; }
+double GPSManager::getDistanceMoved() { return odometer.getTripMeters(); }
+
+Odometer &GPSManager::getOdometer() { return odometer; }
+
+TrackSimplifier &GPSManager::getTrack() { return track; }
+
+FixHistory &GPSManager::getHistory() { return history; }
+
+GeofenceManager &GPSManager::getGeofences() { return geofences; }
 
-String GPSManager::getDate() { return strDate; }
+uint32_t GPSManager::getEpoch() { return ulEpoch; }
 
-String GPSManager::getTime() { return strTime; }
+uint8_t GPSManager::getEpochCentis() { return iEpochCentis; }
+
+// CWD-- YYYY/MM/DD of the last GPS epoch, empty until the receiver has reported a date
+int GPSManager::formatDate(char *buf, size_t len) {
+    if (ulEpoch == 0) {
+        if (len > 0)
+            buf[0] = '\0';
+        return 0;
+    }
+
+    return TimeBase::formatDate(ulEpoch, buf, len);
+}
+
+// CWD-- HH:MM:SS of the last GPS epoch
+int GPSManager::formatTime(char *buf, size_t len) {
+    if (ulEpoch == 0) {
+        if (len > 0)
+            buf[0] = '\0';
+        return 0;
+    }
+
+    return TimeBase::formatTime(ulEpoch, buf, len);
+}
 
 void GPSManager::setDebug(bool blnDebug) { blnDebugOn = blnDebug; }
 
@@ -318,15 +513,8 @@ void GPSManager::setDebug(bool blnDebug) { blnDebugOn = blnDebug; }
 // }
 // CWD--
 //  Returns the great-circle distance (in meters) between two points on a sphere
-//  lat1, lat2, lon1, lon2 must be provided in Degrees.  (Radians = Degrees * PI / 180, Degrees = Radians / PI * 180)
-double GPSManager::haversine(double lat1, double lon1, double lat2, double lon2) {
-    const double rEarth = 6371000.0; // in meters
-    double x = pow(sin(((lat2 - lat1) * M_PI / 180.0) / 2.0), 2.0);
-    double y = cos(lat1 * M_PI / 180.0) * cos(lat2 * M_PI / 180.0);
-    double z = pow(sin(((lon2 - lon1) * M_PI / 180.0) / 2.0), 2.0);
-    double a = x + y * z;
-    double c = 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
-    double d = rEarth * c;
-    // log(f("%12.9f, %12.9f, %12.9f, %12.9f, %12.9f, %12.9f", x, y, z, a, c, d);
-    return d; // in meters
-}
\ No newline at end of file
+//  lat1, lat2, lon1, lon2 must be provided in Degrees. See Geodesy for the flat-earth and batch kernels
+double GPSManager::haversine(double lat1, double lon1, double lat2, double lon2) { return Geodesy::haversine(lat1, lon1, lat2, lon2); }
+
+// CWD-- fixed-point flavor of the above, single-precision only
+float GPSManager::haversine(const GeoPoint &from, const GeoPoint &to) { return Geodesy::haversine(from, to); }
@@ -3,13 +3,29 @@
 #ifndef __GPSManager_h
 #define __GPSManager_h
 
+#include "FixHistory.h"
+#include "GeoPoint.h"
+#include "GeofenceManager.h"
+#include "Odometer.h"
+#include "PositionFilter.h"
+#include "TimeBase.h"
+#include "TrackSimplifier.h"
 #include <TinyGPS++.h>
 #include <locator.h>
 
 #define ss Serial1
 #define CELL_GPS_PERIODIC_PUBLISH_INTERVAL 120
+#define DEAD_RECKONING_GPS_TIMEOUT 3000000   // start dead reckoning once GPS has been quiet this long (us)
+#define DEAD_RECKONING_SPEED_MAX_AGE 10000   // CAN speed older than this can't be trusted (ms)
+#define DEAD_RECKONING_INTERVAL 1000         // how often the dead reckoned position is advanced (ms)
+#define DEAD_RECKONING_HEADING_ERROR 0.09f   // ~5 degrees of course error, as a fraction of speed
+#define NMEA_HEALTH_INTERVAL 60000           // how often the parser counters are checked (ms)
+#define NMEA_CHECKSUM_WARN_RATIO 0.05f       // warn when more than this share of sentences fail their checksum
 const String PUB_PREFIX = "deviceLocation_";
 
+// CWD-- where the current coordinates came from. Tags are shown on the display and sent in publishes
+enum LocationSource { LOCATION_SOURCE_NONE, LOCATION_SOURCE_GPS, LOCATION_SOURCE_CELL, LOCATION_SOURCE_DEAD_RECKONING };
+
 class GPSManager {
   public:
     explicit GPSManager(LocatorSubscriptionCallback googleCallback, unsigned long gpsRefreshInterveral, unsigned long cellRefreshInterveral,
@@ -19,10 +35,18 @@ class GPSManager {
     void update();
     void processData();
     void checkGPS();
+    void updateFromCell(const LocatorResult &result);
+    void updateVehicleSpeed(float kmh);
+    void deadReckon();
+    void checkNMEAHealth();
+    void setStationary(bool stationary);
+    bool isModemBusy(); // CWD-- the locator's worker thread is talking to the modem
 
     // CWD-- getters
     bool areCoordsFromGPS();
     bool setAreCoordsFromGPS(bool areCoordsFromGPS);
+    LocationSource getLocationSource();
+    const char *getLocationSourceTag();
     bool isGPSDataReady();
     bool setIsGPSDataReady(bool isReady);
     double getLongitude();
@@ -31,52 +55,87 @@ class GPSManager {
     double getLatitude();
     double setLatitude(double latitude);
     double getPrevLatitude();
+    GeoPoint getLocation();
+    GeoPoint setLocation(GeoPoint location);
+    GeoPoint getPrevLocation();
     double getAltitude();
     double getSpeed();
+    float getCourse();
+    float getAccuracy();
     int getSatellitesCount();
     unsigned long getLastGPSUpdate();
+    uint64_t getLastGPSFixTime(); // CWD-- TimeBase monotonic micros
     unsigned long setLastGPSUpdate(unsigned long lastGPSUpdate);
     unsigned long getGPSRefreshInterveral();
     unsigned long getCellRefreshInterveral();
+    unsigned long setCellRefreshInterveral(unsigned long cellRefreshInterveral);
     unsigned long getGPSDriftWindow();
     double getDistanceMoved();
-    String getDate();
-    String getTime();
+    Odometer &getOdometer();
+    TrackSimplifier &getTrack();
+    FixHistory &getHistory();
+    uint32_t getCharsProcessed();
+    uint32_t getPassedChecksums();
+    uint32_t getFailedChecksums();
+    uint32_t getSentencesWithFix();
+    String describeNMEA();
+    CellLocationCache &getCellCache();
+    GeofenceManager &getGeofences();
+    uint32_t getEpoch();
+    uint8_t getEpochCentis();
+    int formatDate(char *buf, size_t len);
+    int formatTime(char *buf, size_t len);
     void setDebug(bool blnDebug);
     void log(String str, bool blnWithNewLine = false);
 
     static double haversine(double lat1, double lon1, double lat2, double lon2);
+    static float haversine(const GeoPoint &from, const GeoPoint &to);
 
   private: // Private members
     bool blnDebugOn = false;
-    bool blnCoordsFromGPS = false;
+    LocationSource locationSource = LOCATION_SOURCE_NONE;
     bool blnGPSDataReady = false;
-    double dblLongitude = 0;
-    double dblLatitude = 0;
-    double dblPrevLongitude = 0;
-    double dblPrevLatitude = 0;
-    double dblDistanceMoved = 0;
+    GeoPoint location; // CWD-- fused position, fixed-point 1e-7 degrees, converted to double only by the getters
+    GeoPoint gpsFix;   // CWD-- last raw GPS fix, before fusion
 
     double dblAltitude = 0;
     double dblSpeed = 0;
+    uint16_t iHDOP = 0;
+    float fCourse = 0;
+    bool blnCourseValid = false;
+    float fVehicleSpeed = 0; // m/s, from CAN
+    unsigned long ulLastVehicleSpeed = 0;
+    unsigned long ulLastDeadReckon = 0;
+    unsigned long ulLastNMEACheck = 0;
+    uint32_t ulLastCharsProcessed = 0;
+    uint32_t ulLastPassedChecksums = 0;
+    uint32_t ulLastFailedChecksums = 0;
 
     int iSatellitesCount = 0;
     unsigned long ulLastScreenUpdate;
-    unsigned long ulLastCellGPSUpdate = 0;
-    unsigned long ulLastGPSUpdate = 0;
+    uint64_t ullLastCellGPSUpdate = 0;
+    uint64_t ullLastGPSUpdate = 0;
 
     unsigned long ulGPSRefreshInterveral = 0;
     unsigned long ulCellRefreshInterveral = 0;
     unsigned long ulGPSDriftWindow = 0;
 
-    String strDate;
-    String strTime;
+    uint32_t ulLastFixTime = UINT32_MAX; // CWD-- HHMMSSCC of the last fix handed downstream
+    uint32_t ulEpoch = 0; // CWD-- GPS UTC, unix seconds; formatted only when serialized
+    uint8_t iEpochCentis = 0;
 
     // LocatorSubscriptionCallback googleCallback;
 
     // GPS objects
     TinyGPSPlus gps;
     Locator locator;
+    CellLocationCache cellCache;
+    LocatorResult lastCellResult;
+    Odometer odometer;
+    PositionFilter filter;
+    TrackSimplifier track;
+    FixHistory history;
+    GeofenceManager geofences;
     // void GPSManager::geocodedlocationCallback(float lat, float lon, float accuracy);
 };
 
@@ -0,0 +1,24 @@
+#include "GeoPoint.h"
+#include "Geodesy.h"
+#include <math.h>
+
+// CWD-- RawDegrees is whole degrees plus billionths, so the conversion is pure integer math
+int32_t GeoPoint::rawToE7(const RawDegrees &raw) {
+    int32_t value = (int32_t)raw.deg * GEO_E7_PER_DEGREE + (int32_t)((raw.billionths + 50) / 100);
+    return raw.negative ? -value : value;
+}
+
+GeoPoint GeoPoint::fromRaw(const RawDegrees &rawLat, const RawDegrees &rawLng) { return GeoPoint(rawToE7(rawLat), rawToE7(rawLng)); }
+
+GeoPoint GeoPoint::fromDegrees(double latitude, double longitude) {
+    return GeoPoint((int32_t)lround(latitude * GEO_E7_PER_DEGREE), (int32_t)lround(longitude * GEO_E7_PER_DEGREE));
+}
+
+// CWD-- writes "-DDD.DDDDDDD" without going through a floating point printf
+int GeoPoint::formatE7(int32_t value, char *buf, size_t len) {
+    uint32_t magnitude = value < 0 ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+    return snprintf(buf, len, "%s%lu.%07lu", value < 0 ? "-" : "", (unsigned long)(magnitude / GEO_E7_PER_DEGREE),
+                    (unsigned long)(magnitude % GEO_E7_PER_DEGREE));
+}
+
+float GeoPoint::distanceTo(const GeoPoint &other) const { return Geodesy::haversine(*this, other); }
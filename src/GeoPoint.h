@@ -0,0 +1,33 @@
+#pragma once
+#ifndef __GeoPoint_h
+#define __GeoPoint_h
+
+#include <TinyGPS++.h>
+
+#define GEO_E7_PER_DEGREE 10000000L // fixed-point scale: 1e-7 degree, same as UBX NAV-PVT
+#define GEO_E7_STR_LEN 13           // "-180.0000000" plus the trailing null
+
+// CWD-- fixed-point coordinate. Latitude and longitude are signed 1e-7 degrees (~1.1cm at the equator),
+// which keeps positions exact from the NMEA parser through to the publish without double-precision math
+struct GeoPoint {
+    int32_t lat = 0;
+    int32_t lon = 0;
+
+    constexpr GeoPoint() {}
+    constexpr GeoPoint(int32_t latE7, int32_t lonE7) : lat(latE7), lon(lonE7) {}
+
+    static GeoPoint fromRaw(const RawDegrees &rawLat, const RawDegrees &rawLng);
+    static GeoPoint fromDegrees(double latitude, double longitude);
+    static int32_t rawToE7(const RawDegrees &raw);
+    static int formatE7(int32_t value, char *buf, size_t len);
+
+    double latitude() const { return lat / (double)GEO_E7_PER_DEGREE; }
+    double longitude() const { return lon / (double)GEO_E7_PER_DEGREE; }
+    bool isSet() const { return lat != 0 || lon != 0; }
+    float distanceTo(const GeoPoint &other) const;
+
+    bool operator==(const GeoPoint &other) const { return lat == other.lat && lon == other.lon; }
+    bool operator!=(const GeoPoint &other) const { return !(*this == other); }
+};
+
+#endif // def(__GeoPoint_h)
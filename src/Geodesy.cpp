@@ -0,0 +1,98 @@
+#include "Geodesy.h"
+#include <math.h>
+#include <stdlib.h>
+
+LocalProjection::LocalProjection(const GeoPoint &origin) { setOrigin(origin); }
+
+void LocalProjection::setOrigin(const GeoPoint &origin) {
+    this->origin = origin;
+    float metersPerE7 = (float)(GEO_EARTH_RADIUS_M * GEO_RAD_PER_DEG / GEO_E7_PER_DEGREE);
+    fMetersPerE7Lat = metersPerE7;
+    fMetersPerE7Lon = metersPerE7 * cosf((float)(origin.lat * GEO_RAD_PER_DEG / GEO_E7_PER_DEGREE));
+}
+
+bool LocalProjection::needsRecenter(const GeoPoint &point) const { return labs((long)point.lat - (long)origin.lat) > GEO_FAST_RECENTER_E7; }
+
+float LocalProjection::distance(const GeoPoint &from, const GeoPoint &to) const {
+    float north = (float)((int64_t)to.lat - from.lat) * fMetersPerE7Lat;
+    float east = (float)Geodesy::deltaLonE7(from.lon, to.lon) * fMetersPerE7Lon;
+    return sqrtf(north * north + east * east);
+}
+
+void LocalProjection::toLocal(const GeoPoint &point, float &east, float &north) const {
+    north = (float)((int64_t)point.lat - origin.lat) * fMetersPerE7Lat;
+    east = (float)Geodesy::deltaLonE7(origin.lon, point.lon) * fMetersPerE7Lon;
+}
+
+GeoPoint LocalProjection::fromLocal(float east, float north) const {
+    int32_t lat = origin.lat + (int32_t)lroundf(north / fMetersPerE7Lat);
+    int64_t lon = (int64_t)origin.lon + (fMetersPerE7Lon > 0 ? lroundf(east / fMetersPerE7Lon) : 0);
+
+    if (lon > 180 * GEO_E7_PER_DEGREE) {
+        lon -= 360 * GEO_E7_PER_DEGREE;
+    } else if (lon < -180 * GEO_E7_PER_DEGREE) {
+        lon += 360 * GEO_E7_PER_DEGREE;
+    }
+
+    return GeoPoint(lat, (int32_t)lon);
+}
+
+int64_t Geodesy::deltaLonE7(int32_t fromLon, int32_t toLon) {
+    int64_t delta = (int64_t)toLon - fromLon;
+
+    if (delta > 180 * GEO_E7_PER_DEGREE) {
+        delta -= 360 * GEO_E7_PER_DEGREE;
+    } else if (delta < -180 * GEO_E7_PER_DEGREE) {
+        delta += 360 * GEO_E7_PER_DEGREE;
+    }
+
+    return delta;
+}
+
+// CWD-- lat/lon in degrees. asin form of haversine; one sqrt and no pow()
+double Geodesy::haversine(double lat1, double lon1, double lat2, double lon2) {
+    double sLat = sin((lat2 - lat1) * GEO_RAD_PER_DEG / 2.0);
+    double sLon = sin((lon2 - lon1) * GEO_RAD_PER_DEG / 2.0);
+    double a = sLat * sLat + cos(lat1 * GEO_RAD_PER_DEG) * cos(lat2 * GEO_RAD_PER_DEG) * sLon * sLon;
+    return 2.0 * GEO_EARTH_RADIUS_M * asin(sqrt(fmin(a, 1.0)));
+}
+
+// CWD-- the deltas are taken in integer space so single-precision float keeps centimeter resolution for
+// short hops (the Cortex-M4F FPU has no double support)
+float Geodesy::haversine(const GeoPoint &from, const GeoPoint &to) {
+    const float radPerE7 = (float)(GEO_RAD_PER_DEG / GEO_E7_PER_DEGREE);
+    float sLat = sinf((float)((int64_t)to.lat - from.lat) * radPerE7 / 2.0f);
+    float sLon = sinf((float)deltaLonE7(from.lon, to.lon) * radPerE7 / 2.0f);
+    float a = sLat * sLat + cosf((float)from.lat * radPerE7) * cosf((float)to.lat * radPerE7) * sLon * sLon;
+    return 2.0f * (float)GEO_EARTH_RADIUS_M * asinf(sqrtf(fminf(a, 1.0f)));
+}
+
+float Geodesy::hopDistances(const GeoPoint *points, size_t count, float *out) {
+    float total = 0;
+
+    if (count < 2) {
+        return total;
+    }
+
+    LocalProjection projection(points[0]);
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        if (projection.needsRecenter(points[i])) {
+            projection.setOrigin(points[i]);
+        }
+
+        float d = projection.distance(points[i], points[i + 1]);
+
+        if (d > GEO_FAST_MAX_HOP_M) {
+            d = haversine(points[i], points[i + 1]);
+        }
+
+        if (out) {
+            out[i] = d;
+        }
+
+        total += d;
+    }
+
+    return total;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef __Geodesy_h
+#define __Geodesy_h
+
+#include "GeoPoint.h"
+
+#define GEO_EARTH_RADIUS_M 6371000.0       // mean Earth radius (IUGG), used by every distance routine
+#define GEO_RAD_PER_DEG (M_PI / 180.0)
+#define GEO_FAST_MAX_HOP_M 10000.0f        // flat-earth kernel is only used below this hop length
+#define GEO_FAST_RECENTER_E7 100000L       // re-cache cos(lat) once the track drifts 0.01 deg (~1.1km) in latitude
+
+// CWD-- equirectangular (flat-earth) projection around an origin. cos(lat) is computed once per origin so a
+// distance costs two multiplies and a sqrt. For hops under 10km the error against haversine stays below 0.1%
+class LocalProjection {
+  public:
+    LocalProjection() {}
+    explicit LocalProjection(const GeoPoint &origin);
+
+    void setOrigin(const GeoPoint &origin);
+    const GeoPoint &getOrigin() const { return origin; }
+    bool needsRecenter(const GeoPoint &point) const;
+
+    float distance(const GeoPoint &from, const GeoPoint &to) const;
+    void toLocal(const GeoPoint &point, float &east, float &north) const;
+    GeoPoint fromLocal(float east, float north) const;
+
+  private:
+    GeoPoint origin;
+    float fMetersPerE7Lat = 0;
+    float fMetersPerE7Lon = 0;
+};
+
+class Geodesy {
+  public:
+    // CWD-- exact great-circle distances (in meters)
+    static double haversine(double lat1, double lon1, double lat2, double lon2);
+    static float haversine(const GeoPoint &from, const GeoPoint &to);
+
+    // CWD-- longitude delta in 1e-7 degrees, wrapped across the antimeridian
+    static int64_t deltaLonE7(int32_t fromLon, int32_t toLon);
+
+    // CWD-- batch API. out[i] = distance(points[i], points[i + 1]) when out is non-null; returns the total length.
+    // Short hops go through the flat-earth kernel, longer ones fall back to haversine
+    static float hopDistances(const GeoPoint *points, size_t count, float *out = nullptr);
+    static float pathLength(const GeoPoint *points, size_t count) { return hopDistances(points, count, nullptr); }
+};
+
+#endif // def(__Geodesy_h)
@@ -0,0 +1,295 @@
+#include "GeofenceManager.h"
+#include "Particle.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define GEOFENCE_STATE_INSIDE 0x80
+#define GEOFENCE_STATE_PENDING 0x7f
+
+GeofenceManager::GeofenceManager() { memset(state, 0, sizeof(state)); }
+
+// CWD-- builds the grid index: every fence is listed under each 0.01 degree cell its bounding box touches,
+// sorted by cell so a fix only has to binary search its own cell. Returns false if anything didn't fit
+bool GeofenceManager::begin(const GeofenceDef *fences, size_t fenceCount, const GeoPoint *vertices, size_t vertexCount) {
+    bool blnComplete = true;
+    this->fences = fences;
+    this->fenceCount = min(fenceCount, (size_t)GEOFENCE_MAX_FENCES);
+    this->vertices = vertices;
+    this->vertexCount = vertexCount;
+    indexSize = 0;
+    largeCount = 0;
+    insideCount = 0;
+    pendingCount = 0;
+    memset(state, 0, sizeof(state));
+
+    for (size_t i = 0; i < this->fenceCount; i++) {
+        GeoPoint lo, hi;
+
+        if (!bounds(i, lo, hi)) {
+            Log.warn("Geofence %u has a bad definition, skipping", fences[i].id);
+            blnComplete = false;
+            continue;
+        }
+
+        int32_t latLo = cellIndex(lo.lat), latHi = cellIndex(hi.lat);
+        int32_t lonLo = cellIndex(lo.lon), lonHi = cellIndex(hi.lon);
+        int32_t cells = (latHi - latLo + 1) * (lonHi - lonLo + 1);
+
+        if (cells > GEOFENCE_MAX_CELLS_PER_FENCE || cells < 0 || indexSize + cells > GEOFENCE_MAX_INDEX_ENTRIES) {
+            if (largeCount < GEOFENCE_MAX_LARGE_FENCES) {
+                largeFences[largeCount++] = i;
+            } else {
+                blnComplete = false;
+            }
+
+            continue;
+        }
+
+        for (int32_t lat = latLo; lat <= latHi; lat++) {
+            for (int32_t lon = lonLo; lon <= lonHi; lon++) {
+                index[indexSize].cell = cellKey(lat, lon);
+                index[indexSize].fence = i;
+                indexSize++;
+            }
+        }
+    }
+
+    qsort(index, indexSize, sizeof(IndexEntry), compareEntries);
+    Log.info("Geofences loaded: %u fences, %u index entries, %u large", (unsigned)this->fenceCount, (unsigned)indexSize, (unsigned)largeCount);
+
+    if (fenceCount > GEOFENCE_MAX_FENCES) {
+        blnComplete = false;
+    }
+
+    return blnComplete;
+}
+
+void GeofenceManager::withCallback(GeofenceCallback callback) { this->callback = callback; }
+
+// CWD-- tests only the fences indexed under this fix's cell, the large ones, and the ones we're inside of
+void GeofenceManager::update(const GeoPoint &point, unsigned long time) {
+    if (fenceCount == 0) {
+        return;
+    }
+
+    memcpy(lastPending, pending, pendingCount * sizeof(pending[0]));
+    lastPendingCount = pendingCount;
+    pendingCount = 0;
+
+    projection.setOrigin(point);
+    uint32_t key = cellKey(cellIndex(point.lat), cellIndex(point.lon));
+    size_t lo = 0, hi = indexSize;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (index[mid].cell < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // CWD-- exits first: fences we're inside of that this cell doesn't list would never be looked at otherwise.
+    // test() can drop entries from the inside list, so walk it backwards
+    for (size_t i = insideCount; i > 0; i--) {
+        if (!isCandidate(inside[i - 1], lo, key)) {
+            test(inside[i - 1], point, time);
+        }
+    }
+
+    for (size_t i = lo; i < indexSize && index[i].cell == key; i++) {
+        test(index[i].fence, point, time);
+    }
+
+    for (size_t i = 0; i < largeCount; i++) {
+        test(largeFences[i], point, time);
+    }
+
+    // CWD-- a fence that dropped out of the candidate set isn't seeing fixes in a row any more: forget its count
+    for (size_t i = 0; i < lastPendingCount; i++) {
+        bool blnStillPending = false;
+
+        for (size_t j = 0; j < pendingCount && !blnStillPending; j++) {
+            blnStillPending = pending[j] == lastPending[i];
+        }
+
+        if (!blnStillPending) {
+            state[lastPending[i]] &= GEOFENCE_STATE_INSIDE;
+        }
+    }
+}
+
+bool GeofenceManager::isInside(uint16_t id) {
+    for (size_t i = 0; i < insideCount; i++) {
+        if (fences[inside[i]].id == id) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t GeofenceManager::getFenceCount() { return fenceCount; }
+
+uint32_t GeofenceManager::getCandidatesTested() { return ulCandidatesTested; }
+
+bool GeofenceManager::isCandidate(uint16_t fence, size_t first, uint32_t key) {
+    for (size_t i = first; i < indexSize && index[i].cell == key; i++) {
+        if (index[i].fence == fence) {
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < largeCount; i++) {
+        if (largeFences[i] == fence) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// CWD-- hysteresis: a transition needs GEOFENCE_CONFIRM_SAMPLES disagreeing fixes in a row, and an exit also
+// needs to clear the fence by GEOFENCE_EXIT_MARGIN_M, so a vehicle parked on the boundary doesn't chatter
+void GeofenceManager::test(uint16_t fence, const GeoPoint &point, unsigned long time) {
+    ulCandidatesTested++;
+    float outside = distanceOutside(fence, point);
+    bool blnInside = state[fence] & GEOFENCE_STATE_INSIDE;
+    bool blnDisagrees = blnInside ? outside > GEOFENCE_EXIT_MARGIN_M : outside <= 0;
+
+    if (!blnDisagrees) {
+        state[fence] &= GEOFENCE_STATE_INSIDE;
+        return;
+    }
+
+    uint8_t pending = (state[fence] & GEOFENCE_STATE_PENDING) + 1;
+
+    if (pending < GEOFENCE_CONFIRM_SAMPLES) {
+        if (addPending(fence)) {
+            state[fence] = (state[fence] & GEOFENCE_STATE_INSIDE) | pending;
+        }
+        return;
+    }
+
+    if (blnInside) {
+        state[fence] = 0;
+        removeInside(fence);
+    } else if (addInside(fence)) {
+        state[fence] = GEOFENCE_STATE_INSIDE;
+    } else {
+        Log.warn("Geofence %u entered but too many fences are active", fences[fence].id);
+        return;
+    }
+
+    Log.info("Geofence %u %s", fences[fence].id, blnInside ? "exit" : "enter");
+
+    if (callback) {
+        (*callback)(fences[fence].id, !blnInside, point, time);
+    }
+}
+
+// CWD-- meters outside the fence, negative when inside. Polygons are worked in a flat-earth frame centered on
+// the fix: even-odd ray cast for containment, nearest edge for the distance
+float GeofenceManager::distanceOutside(uint16_t fence, const GeoPoint &point) {
+    const GeofenceDef &def = fences[fence];
+
+    if (def.type == GEOFENCE_CIRCLE) {
+        return projection.distance(point, def.center) - def.radiusOrVertexStart;
+    }
+
+    const GeoPoint *poly = vertices + def.radiusOrVertexStart;
+    bool blnInside = false;
+    float nearest = INFINITY;
+    float ax, ay;
+    projection.toLocal(poly[def.vertexCount - 1], ax, ay);
+
+    for (size_t i = 0; i < def.vertexCount; i++) {
+        float bx, by;
+        projection.toLocal(poly[i], bx, by);
+
+        if ((ay > 0) != (by > 0) && 0 < ax + (0 - ay) * (bx - ax) / (by - ay)) {
+            blnInside = !blnInside;
+        }
+
+        float ex = bx - ax, ey = by - ay;
+        float len2 = ex * ex + ey * ey;
+        float t = len2 > 0 ? fminf(1.0f, fmaxf(0.0f, -(ax * ex + ay * ey) / len2)) : 0;
+        float dx = ax + t * ex, dy = ay + t * ey;
+        nearest = fminf(nearest, sqrtf(dx * dx + dy * dy));
+        ax = bx;
+        ay = by;
+    }
+
+    return blnInside ? -nearest : nearest;
+}
+
+bool GeofenceManager::bounds(size_t fence, GeoPoint &lo, GeoPoint &hi) {
+    const GeofenceDef &def = fences[fence];
+
+    if (def.type == GEOFENCE_CIRCLE) {
+        if (def.radiusOrVertexStart == 0) {
+            return false;
+        }
+
+        LocalProjection local(def.center);
+        lo = local.fromLocal(-(float)def.radiusOrVertexStart, -(float)def.radiusOrVertexStart);
+        hi = local.fromLocal((float)def.radiusOrVertexStart, (float)def.radiusOrVertexStart);
+        return true;
+    }
+
+    if (def.type != GEOFENCE_POLYGON || def.vertexCount < 3 || def.radiusOrVertexStart + def.vertexCount > vertexCount) {
+        return false;
+    }
+
+    const GeoPoint *poly = vertices + def.radiusOrVertexStart;
+    lo = hi = poly[0];
+
+    for (size_t i = 1; i < def.vertexCount; i++) {
+        lo.lat = min(lo.lat, poly[i].lat);
+        lo.lon = min(lo.lon, poly[i].lon);
+        hi.lat = max(hi.lat, poly[i].lat);
+        hi.lon = max(hi.lon, poly[i].lon);
+    }
+
+    return true;
+}
+
+bool GeofenceManager::addInside(uint16_t fence) {
+    if (insideCount == GEOFENCE_MAX_INSIDE) {
+        return false;
+    }
+
+    inside[insideCount++] = fence;
+    return true;
+}
+
+// CWD-- with the list full the count just doesn't start; the next fix gets another try
+bool GeofenceManager::addPending(uint16_t fence) {
+    if (pendingCount == GEOFENCE_MAX_PENDING) {
+        return false;
+    }
+
+    pending[pendingCount++] = fence;
+    return true;
+}
+
+void GeofenceManager::removeInside(uint16_t fence) {
+    for (size_t i = 0; i < insideCount; i++) {
+        if (inside[i] == fence) {
+            inside[i] = inside[--insideCount];
+            return;
+        }
+    }
+}
+
+uint32_t GeofenceManager::cellKey(int32_t latIndex, int32_t lonIndex) { return ((uint32_t)(latIndex & 0xffff) << 16) | (uint32_t)(lonIndex & 0xffff); }
+
+// CWD-- floor division so cells don't double up around the equator/prime meridian
+int32_t GeofenceManager::cellIndex(int32_t e7) { return e7 >= 0 ? e7 / GEOFENCE_CELL_E7 : -((-e7 + GEOFENCE_CELL_E7 - 1) / GEOFENCE_CELL_E7); }
+
+int GeofenceManager::compareEntries(const void *a, const void *b) {
+    uint32_t ka = ((const IndexEntry *)a)->cell;
+    uint32_t kb = ((const IndexEntry *)b)->cell;
+    return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
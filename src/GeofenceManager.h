@@ -0,0 +1,88 @@
+#pragma once
+#ifndef __GeofenceManager_h
+#define __GeofenceManager_h
+
+#include "GeoPoint.h"
+#include "Geodesy.h"
+
+#define GEOFENCE_CIRCLE 0
+#define GEOFENCE_POLYGON 1
+
+#ifndef GEOFENCE_MAX_FENCES
+#define GEOFENCE_MAX_FENCES 512           // one byte of RAM each; the host benchmark builds with 10k
+#endif
+#ifndef GEOFENCE_MAX_INDEX_ENTRIES
+#define GEOFENCE_MAX_INDEX_ENTRIES 1024   // (grid cell, fence) pairs
+#endif
+#define GEOFENCE_MAX_CELLS_PER_FENCE 16   // bigger fences skip the grid and are tested on every fix
+#define GEOFENCE_MAX_LARGE_FENCES 32
+#define GEOFENCE_MAX_INSIDE 16            // fences we can be inside of at once
+#define GEOFENCE_MAX_PENDING 16           // fences part way through confirming a transition
+#define GEOFENCE_CELL_E7 100000L          // grid cell size, 0.01 degree (~1.1km of latitude)
+#define GEOFENCE_EXIT_MARGIN_M 25.0f      // must be this far outside before an exit counts...
+#define GEOFENCE_CONFIRM_SAMPLES 2        // ...for this many fixes in a row (entries too)
+
+// CWD-- compact fence record, 16 bytes. Tables are const so they stay in flash. For a circle, center/radius;
+// for a polygon, vertexCount vertices starting at vertexStart in the shared vertex table (center unused)
+struct GeofenceDef {
+    GeoPoint center;
+    uint32_t radiusOrVertexStart;
+    uint16_t id;
+    uint8_t type;
+    uint8_t vertexCount;
+};
+
+typedef void (*GeofenceCallback)(uint16_t id, bool entered, const GeoPoint &point, unsigned long time);
+
+class GeofenceManager {
+  public:
+    GeofenceManager();
+
+    bool begin(const GeofenceDef *fences, size_t fenceCount, const GeoPoint *vertices, size_t vertexCount);
+    void withCallback(GeofenceCallback callback);
+    void update(const GeoPoint &point, unsigned long time);
+
+    bool isInside(uint16_t id);
+    size_t getFenceCount();
+    uint32_t getCandidatesTested(); // CWD-- running total, to keep an eye on index effectiveness
+
+  private:
+    struct IndexEntry {
+        uint32_t cell;
+        uint16_t fence;
+    };
+
+    bool bounds(size_t fence, GeoPoint &lo, GeoPoint &hi);
+    bool isCandidate(uint16_t fence, size_t first, uint32_t key);
+    void test(uint16_t fence, const GeoPoint &point, unsigned long time);
+    float distanceOutside(uint16_t fence, const GeoPoint &point); // <= 0 when inside
+    bool addInside(uint16_t fence);
+    void removeInside(uint16_t fence);
+    bool addPending(uint16_t fence);
+    static uint32_t cellKey(int32_t latIndex, int32_t lonIndex);
+    static int32_t cellIndex(int32_t e7);
+    static int compareEntries(const void *a, const void *b);
+
+    const GeofenceDef *fences = nullptr;
+    size_t fenceCount = 0;
+    const GeoPoint *vertices = nullptr;
+    size_t vertexCount = 0;
+    GeofenceCallback callback = nullptr;
+    LocalProjection projection; // centered on the fix being tested
+
+    IndexEntry index[GEOFENCE_MAX_INDEX_ENTRIES];
+    size_t indexSize = 0;
+    uint16_t largeFences[GEOFENCE_MAX_LARGE_FENCES];
+    size_t largeCount = 0;
+
+    uint8_t state[GEOFENCE_MAX_FENCES]; // bit 7 inside, low bits count fixes disagreeing with it
+    uint16_t inside[GEOFENCE_MAX_INSIDE];
+    size_t insideCount = 0;
+    uint16_t pending[GEOFENCE_MAX_PENDING]; // CWD-- fences with a pending count after this fix...
+    size_t pendingCount = 0;
+    uint16_t lastPending[GEOFENCE_MAX_PENDING]; // ...and after the previous one
+    size_t lastPendingCount = 0;
+    uint32_t ulCandidatesTested = 0;
+};
+
+#endif // def(__GeofenceManager_h)
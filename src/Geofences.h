@@ -0,0 +1,23 @@
+#pragma once
+#ifndef __Geofences_h
+#define __Geofences_h
+
+#include "GeofenceManager.h"
+
+// CWD-- depot and customer site fences. constexpr so the compiler has to build the tables at compile time and
+// they live in flash, not RAM.
+// Circles: { center, radius (m), id, GEOFENCE_CIRCLE, 0 }
+// Polygons: { unused, first vertex in GEOFENCE_VERTICES, id, GEOFENCE_POLYGON, vertex count }
+constexpr GeofenceDef GEOFENCES[] = {
+    {GeoPoint(377749000, -1224194000), 150, 1, GEOFENCE_CIRCLE, 0}, // example depot
+    {GeoPoint(), 0, 2, GEOFENCE_POLYGON, 4},                        // example yard
+};
+
+constexpr GeoPoint GEOFENCE_VERTICES[] = {
+    GeoPoint(377790000, -1224010000),
+    GeoPoint(377790000, -1223980000),
+    GeoPoint(377770000, -1223980000),
+    GeoPoint(377770000, -1224010000),
+};
+
+#endif // def(__Geofences_h)
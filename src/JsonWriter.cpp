@@ -0,0 +1,236 @@
+#include "JsonWriter.h"
+
+#include <string.h>
+
+JsonWriter::JsonWriter(char *buf, size_t capacity) : buf(buf), capacity(capacity) {
+    if (capacity > 0) {
+        buf[0] = 0;
+    } else {
+        blnOverflow = true;
+    }
+}
+
+JsonWriter &JsonWriter::beginObject() {
+    open('{');
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+    close('}');
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+    open('[');
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+    close(']');
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(const char *name) {
+    if (separate() && put("\"", 1) && put(name, strlen(name)) && put("\":", 2)) {
+        blnAfterKey = true;
+    }
+    return *this;
+}
+
+// CWD-- escapes quotes, backslashes and control characters; everything else passes through as UTF-8
+JsonWriter &JsonWriter::string(const char *str) {
+    if (!separate() || !put("\"", 1)) {
+        return *this;
+    }
+
+    const char *run = str;
+    for (; *str; str++) {
+        unsigned char c = *str;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        if (!put(run, str - run)) {
+            return *this;
+        }
+        char escape[7] = {'\\', (char)c, 0};
+        size_t n = 2;
+        if (c == '\n') {
+            escape[1] = 'n';
+        } else if (c == '\r') {
+            escape[1] = 'r';
+        } else if (c == '\t') {
+            escape[1] = 't';
+        } else if (c < 0x20) {
+            static const char HEX[] = "0123456789abcdef";
+            memcpy(escape + 1, "u00", 3);
+            escape[4] = HEX[c >> 4];
+            escape[5] = HEX[c & 0x0F];
+            n = 6;
+        }
+        if (!put(escape, n)) {
+            return *this;
+        }
+        run = str + 1;
+    }
+    put(run, str - run) && put("\"", 1);
+    return *this;
+}
+
+JsonWriter &JsonWriter::boolean(bool value) {
+    if (separate()) {
+        value ? put("true", 4) : put("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::number(int64_t value) {
+    char digits[21];
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    size_t n = formatUnsigned(magnitude, digits + 1);
+    if (value < 0) {
+        digits[0] = '-';
+        n++;
+    }
+    if (separate()) {
+        put(value < 0 ? digits : digits + 1, n);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::fixed(int64_t value, uint8_t decimals) {
+    char digits[24];
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    size_t n = formatUnsigned(magnitude, digits);
+
+    // CWD-- left pad with zeros so there's at least one digit before the point, then open up a gap for it
+    if (decimals > 19) {
+        decimals = 19;
+    }
+    if (n <= decimals) {
+        size_t pad = decimals + 1 - n;
+        memmove(digits + pad, digits, n);
+        memset(digits, '0', pad);
+        n += pad;
+    }
+    if (decimals > 0) {
+        memmove(digits + n - decimals + 1, digits + n - decimals, decimals);
+        digits[n - decimals] = '.';
+        n++;
+    }
+
+    if (separate() && (value >= 0 || put("-", 1))) {
+        put(digits, n);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::hex(uint32_t value, uint8_t digits) {
+    static const char HEX[] = "0123456789ABCDEF";
+    char str[13] = {'"', '0', 'x'};
+    char nibbles[8];
+    size_t n = 0;
+    do {
+        nibbles[n++] = HEX[value & 0x0F];
+        value >>= 4;
+    } while (value || (n < digits && n < sizeof(nibbles)));
+
+    size_t len = 3;
+    while (n) {
+        str[len++] = nibbles[--n];
+    }
+    str[len++] = '"';
+    if (separate()) {
+        put(str, len);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::raw(const char *json) {
+    if (separate()) {
+        put(json, strlen(json));
+    }
+    return *this;
+}
+
+size_t JsonWriter::reserve(size_t bytes) {
+    size_t previous = ulReserved;
+    ulReserved = bytes;
+    return previous;
+}
+
+const char *JsonWriter::c_str() { return buf; }
+
+size_t JsonWriter::length() { return len; }
+
+bool JsonWriter::isOverflowed() { return blnOverflow; }
+
+// CWD-- the comma before an element, unless it's the value half of a key/value pair
+bool JsonWriter::separate() {
+    if (blnOverflow) {
+        return false;
+    }
+    if (blnAfterKey) {
+        blnAfterKey = false;
+        return true;
+    }
+
+    uint16_t bit = 1 << depth;
+    if ((hasItems & bit) && !put(",", 1)) {
+        return false;
+    }
+    hasItems |= bit;
+    return true;
+}
+
+// CWD-- append, leaving room for the null, the open closers and any reserve
+bool JsonWriter::put(const char *str, size_t n) {
+    if (blnOverflow || len + n + depth + ulReserved + 1 > capacity) {
+        blnOverflow = true;
+        return false;
+    }
+    memcpy(buf + len, str, n);
+    len += n;
+    buf[len] = 0;
+    return true;
+}
+
+bool JsonWriter::open(char c) {
+    if (depth + 1 >= JSON_MAX_DEPTH) {
+        blnOverflow = true;
+        return false;
+    }
+    if (!separate()) {
+        return false;
+    }
+    depth++; // CWD-- before the put(), so there has to be room for this container's closer too
+    if (!put(&c, 1)) {
+        depth--;
+        return false;
+    }
+    hasItems &= ~(1 << depth);
+    return true;
+}
+
+bool JsonWriter::close(char c) {
+    if (depth == 0) {
+        blnOverflow = true;
+        return false;
+    }
+    depth--;
+    blnAfterKey = false;
+    return put(&c, 1);
+}
+
+size_t JsonWriter::formatUnsigned(uint64_t value, char *digits) {
+    char reversed[20];
+    size_t n = 0;
+    do {
+        reversed[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    for (size_t i = 0; i < n; i++) {
+        digits[i] = reversed[n - 1 - i];
+    }
+    return n;
+}
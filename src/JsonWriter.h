@@ -0,0 +1,54 @@
+#pragma once
+#ifndef __JsonWriter_h
+#define __JsonWriter_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_MAX_DEPTH 8
+
+// CWD-- streaming JSON into a caller's fixed buffer: no heap, no printf. Commas are placed automatically and
+// every open object/array keeps a byte back for its closer, so whatever has been written can always be closed.
+// Once something doesn't fit the writer stops and isOverflowed() is set; copy the writer beforehand to roll an
+// element back instead (the buffer is only ever appended to)
+class JsonWriter {
+  public:
+    JsonWriter(char *buf, size_t capacity);
+
+    JsonWriter &beginObject();
+    JsonWriter &endObject();
+    JsonWriter &beginArray();
+    JsonWriter &endArray();
+    JsonWriter &key(const char *name);
+
+    JsonWriter &string(const char *str);
+    JsonWriter &boolean(bool value);
+    JsonWriter &number(int64_t value);
+    JsonWriter &fixed(int64_t value, uint8_t decimals); // value / 10^decimals, e.g. E7 coordinates
+    JsonWriter &hex(uint32_t value, uint8_t digits = 2); // quoted "0xNN", at least this many digits
+    JsonWriter &raw(const char *json);                   // an already encoded value
+
+    size_t reserve(size_t bytes); // extra bytes held back from values, for a trailer. Returns the previous value
+
+    const char *c_str();
+    size_t length();
+    bool isOverflowed();
+
+  private:
+    bool separate();
+    bool put(const char *str, size_t n);
+    bool open(char c);
+    bool close(char c);
+    static size_t formatUnsigned(uint64_t value, char *digits);
+
+    char *buf;
+    size_t capacity;
+    size_t len = 0;
+    size_t ulReserved = 0;
+    uint8_t depth = 0;
+    uint16_t hasItems = 0; // bit per depth: a comma goes before the next element
+    bool blnAfterKey = false;
+    bool blnOverflow = false;
+};
+
+#endif // def(__JsonWriter_h)
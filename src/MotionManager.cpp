@@ -0,0 +1,94 @@
+#include "MotionManager.h"
+#include "Geodesy.h"
+#include "Particle.h"
+
+MotionManager::MotionManager() {}
+
+void MotionManager::update(float speedMps, const GeoPoint &location, unsigned long time) {
+    MotionState next = classify(speedMps, location, time);
+
+    if (next != candidate) {
+        candidate = next;
+        ulCandidateSince = time;
+    }
+
+    // CWD-- the anchor follows the vehicle while it's confirmed and still rolling, so it pins where the latest
+    // stop began. Once at rest it stays there: a slow creep accumulates across parked/idling flips instead of
+    // restarting at each one
+    bool blnRolling = next == MOTION_MOVING || next == MOTION_TOWING;
+    if (!anchor.isSet() || (blnRolling && !isStationary())) {
+        anchor = location;
+    }
+
+    unsigned long dwell = candidate == MOTION_PARKED ? MOTION_PARKED_DWELL : MOTION_DWELL;
+
+    if (candidate != state && (state == MOTION_UNKNOWN || (time - ulCandidateSince) >= dwell)) {
+        transition(candidate, time);
+    }
+}
+
+void MotionManager::updateEngine(uint16_t rpm, unsigned long time) {
+    iRPM = rpm;
+    ulRPMTime = time;
+}
+
+void MotionManager::setIgnition(bool ignitionOn, unsigned long time) {
+    blnIgnitionKnown = true;
+    blnIgnitionOn = ignitionOn;
+}
+
+bool MotionManager::subscribe(MotionStateCallback callback) {
+    if (listenerCount == MOTION_MAX_LISTENERS) {
+        return false;
+    }
+
+    listeners[listenerCount++] = callback;
+    return true;
+}
+
+MotionState MotionManager::getState() { return state; }
+
+unsigned long MotionManager::getStateSince() { return ulStateSince; }
+
+bool MotionManager::isStationary() { return state == MOTION_PARKED || state == MOTION_IDLING; }
+
+const char *MotionManager::getStateName(MotionState state) {
+    switch (state) {
+    case MOTION_PARKED:
+        return "parked";
+    case MOTION_IDLING:
+        return "idling";
+    case MOTION_MOVING:
+        return "moving";
+    case MOTION_TOWING:
+        return "towing";
+    default:
+        return "unknown";
+    }
+}
+
+// CWD-- rolling with the engine known to be off is a tow. Without any engine data we can't tell, so it's moving
+MotionState MotionManager::classify(float speedMps, const GeoPoint &location, unsigned long time) {
+    bool blnRPMFresh = ulRPMTime != 0 && (time - ulRPMTime) < MOTION_ENGINE_MAX_AGE;
+    bool blnEngineKnown = blnRPMFresh || blnIgnitionKnown;
+    bool blnEngineOn = (blnRPMFresh && iRPM >= MOTION_ENGINE_ON_RPM) || (blnIgnitionKnown && blnIgnitionOn);
+    bool blnRolling = speedMps >= MOTION_MOVING_SPEED_MPS ||
+                      (location.isSet() && anchor.isSet() && Geodesy::haversine(anchor, location) > MOTION_MOVING_DISPLACEMENT_M);
+
+    if (blnRolling) {
+        return (blnEngineKnown && !blnEngineOn) ? MOTION_TOWING : MOTION_MOVING;
+    }
+
+    return blnEngineOn ? MOTION_IDLING : MOTION_PARKED;
+}
+
+void MotionManager::transition(MotionState to, unsigned long time) {
+    MotionState from = state;
+    state = to;
+    ulStateSince = time;
+    Log.info("Motion state: %s -> %s", getStateName(from), getStateName(to));
+
+    for (size_t i = 0; i < listenerCount; i++) {
+        (*listeners[i])(from, to, time);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef __MotionManager_h
+#define __MotionManager_h
+
+#include "GeoPoint.h"
+
+#define MOTION_MOVING_SPEED_MPS 2.0f    // ~4.5mph, GPS speed at or above this counts as rolling
+#define MOTION_MOVING_DISPLACEMENT_M 50 // or this far from where the vehicle last came to rest
+#define MOTION_ENGINE_ON_RPM 300
+#define MOTION_ENGINE_MAX_AGE 15000     // RPM older than this (ms) says nothing about the engine
+#define MOTION_DWELL 10000              // a new state must hold this long (ms) before it's reported...
+#define MOTION_PARKED_DWELL 60000       // ...except parked, which has to survive stop-and-go traffic
+#define MOTION_MAX_LISTENERS 8
+
+enum MotionState { MOTION_UNKNOWN, MOTION_PARKED, MOTION_IDLING, MOTION_MOVING, MOTION_TOWING };
+
+typedef void (*MotionStateCallback)(MotionState from, MotionState to, unsigned long time);
+
+// CWD-- classifies the vehicle from GPS speed/displacement plus engine RPM and ignition when the CAN side
+// has them. Other subsystems subscribe to transitions to scale their sampling and publish rates
+class MotionManager {
+  public:
+    MotionManager();
+
+    void update(float speedMps, const GeoPoint &location, unsigned long time);
+    void updateEngine(uint16_t rpm, unsigned long time);
+    void setIgnition(bool ignitionOn, unsigned long time);
+
+    bool subscribe(MotionStateCallback callback);
+
+    MotionState getState();
+    unsigned long getStateSince();
+    bool isStationary();
+    static const char *getStateName(MotionState state);
+
+  private:
+    MotionState classify(float speedMps, const GeoPoint &location, unsigned long time);
+    void transition(MotionState to, unsigned long time);
+
+    MotionState state = MOTION_UNKNOWN;
+    unsigned long ulStateSince = 0;
+
+    MotionState candidate = MOTION_UNKNOWN;
+    unsigned long ulCandidateSince = 0;
+    GeoPoint anchor; // CWD-- where the latest stop began, see update()
+
+    uint16_t iRPM = 0;
+    unsigned long ulRPMTime = 0;
+    bool blnIgnitionKnown = false;
+    bool blnIgnitionOn = false;
+
+    MotionStateCallback listeners[MOTION_MAX_LISTENERS];
+    size_t listenerCount = 0;
+};
+
+#endif // def(__MotionManager_h)
@@ -0,0 +1,153 @@
+#include "Odometer.h"
+#include "Geodesy.h"
+#include "Particle.h"
+
+#define ODOMETER_MAGIC 0x4f444f31 // "ODO1"
+
+Odometer::Odometer() {}
+
+// CWD-- restore the newest valid record from the EEPROM slots
+void Odometer::begin() {
+    OdometerRecord record;
+
+    for (int i = 0; i < ODOMETER_EEPROM_SLOTS; i++) {
+        EEPROM.get(ODOMETER_EEPROM_ADDR + i * sizeof(OdometerRecord), record);
+
+        if (record.magic != ODOMETER_MAGIC || record.checksum != checksum(record) || record.sequence < ulSequence) {
+            continue;
+        }
+
+        ulSequence = record.sequence;
+        ullLifetimeMm = record.lifetimeMm;
+        ullTripMm = record.tripMm;
+        ulVehicleBaseHm = record.vehicleBaseHm;
+        ullVehicleBaseMm = record.vehicleBaseMm;
+    }
+
+    ullLastSavedMm = ullLifetimeMm;
+    Log.info("Odometer restored: %lu m lifetime, seq %lu", (unsigned long)getLifetimeMeters(), (unsigned long)ulSequence);
+}
+
+// CWD-- returns true when the fix moved the odometer
+bool Odometer::addFix(const FixRecord &fix) {
+    const GeoPoint &point = fix.point;
+    unsigned long timeMs = fix.time;
+
+    if (fix.hdop > ODOMETER_MAX_HDOP || !point.isSet()) {
+        ulRejectedFixes++;
+        return false;
+    }
+
+    if (!blnAnchorSet) {
+        anchor = point;
+        ulAnchorTime = timeMs;
+        blnAnchorSet = true;
+        return false;
+    }
+
+    float d = Geodesy::haversine(anchor, point);
+
+    if (fix.speed < ODOMETER_STATIONARY_SPEED_MPS && d < ODOMETER_STATIONARY_RADIUS_M) { // parked, this is just jitter
+        ulRejectedFixes++;
+        return false;
+    }
+
+    if (d < ODOMETER_MIN_DISPLACEMENT_M) { // keep the anchor so short hops add up
+        return false;
+    }
+
+    float seconds = (timeMs - ulAnchorTime) / 1000.0f;
+
+    if (seconds > 0 && d / seconds > ODOMETER_MAX_SPEED_MPS) { // teleport, re-anchor without counting it
+        ulRejectedFixes++;
+        anchor = point;
+        ulAnchorTime = timeMs;
+        return false;
+    }
+
+    uint64_t mm = (uint64_t)(d * 1000.0f);
+    ullLifetimeMm += mm;
+    ullTripMm += mm;
+    anchor = point;
+    ulAnchorTime = timeMs;
+
+    if ((ullLifetimeMm - ullLastSavedMm) >= (uint64_t)ODOMETER_SAVE_DISTANCE_M * 1000 && (timeMs - ulLastSaveTime) >= ODOMETER_SAVE_MIN_INTERVAL) {
+        save();
+    }
+
+    return true;
+}
+
+void Odometer::resetTrip() {
+    ullTripMm = 0;
+    save();
+}
+
+// CWD-- each save goes to the next slot so no single EEPROM page takes every write
+void Odometer::save() {
+    OdometerRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = ODOMETER_MAGIC;
+    record.sequence = ++ulSequence;
+    record.lifetimeMm = ullLifetimeMm;
+    record.tripMm = ullTripMm;
+    record.vehicleBaseHm = ulVehicleBaseHm;
+    record.vehicleBaseMm = ullVehicleBaseMm;
+    record.checksum = checksum(record);
+
+    EEPROM.put(ODOMETER_EEPROM_ADDR + (ulSequence % ODOMETER_EEPROM_SLOTS) * sizeof(OdometerRecord), record);
+    ullLastSavedMm = ullLifetimeMm;
+    ulLastSaveTime = millis();
+}
+
+float Odometer::getTripMeters() { return ullTripMm / 1000.0f; }
+
+uint32_t Odometer::getLifetimeMeters() { return (uint32_t)(ullLifetimeMm / 1000); }
+
+uint32_t Odometer::getRejectedFixes() { return ulRejectedFixes; }
+
+void Odometer::setVehicleOdometer(uint32_t hectometers) {
+    if (hectometers == 0) {
+        return;
+    }
+
+    ulVehicleHm = hectometers;
+
+    if (ulVehicleBaseHm == 0 || hectometers < ulVehicleBaseHm) { // first reading, or a different vehicle/cluster swap
+        ulVehicleBaseHm = hectometers;
+        ullVehicleBaseMm = ullLifetimeMm;
+        save();
+    }
+}
+
+bool Odometer::hasVehicleOdometer() { return ulVehicleHm != 0; }
+
+uint32_t Odometer::getVehicleOdometerMeters() { return ulVehicleHm * 100; }
+
+// CWD-- GPS distance minus vehicle distance since reconciliation started. Positive means GPS reads long
+int32_t Odometer::getVehicleDriftMeters() {
+    if (!hasVehicleOdometer()) {
+        return 0;
+    }
+
+    int64_t gpsMeters = (int64_t)((ullLifetimeMm - ullVehicleBaseMm) / 1000);
+    int64_t vehicleMeters = (int64_t)(ulVehicleHm - ulVehicleBaseHm) * 100;
+    return (int32_t)(gpsMeters - vehicleMeters);
+}
+
+String Odometer::describe() {
+    return String::format("trip=%.0f,lifetime=%lu,rejected=%lu,vehicle=%lu,drift=%ld", getTripMeters(), (unsigned long)getLifetimeMeters(),
+                          (unsigned long)ulRejectedFixes, (unsigned long)getVehicleOdometerMeters(), (long)getVehicleDriftMeters());
+}
+
+// CWD-- FNV-1a over everything but the checksum field
+uint32_t Odometer::checksum(const OdometerRecord &record) {
+    const uint8_t *bytes = (const uint8_t *)&record;
+    uint32_t hash = 2166136261UL;
+
+    for (size_t i = 0; i < offsetof(OdometerRecord, checksum); i++) {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+
+    return hash;
+}
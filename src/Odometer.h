@@ -0,0 +1,70 @@
+#pragma once
+#ifndef __Odometer_h
+#define __Odometer_h
+
+#include "FixHistory.h"
+#include "GeoPoint.h"
+#include "Particle.h"
+
+#define ODOMETER_MAX_HDOP 250                // 100ths, fixes worse than HDOP 2.5 are ignored
+#define ODOMETER_STATIONARY_SPEED_MPS 0.8f   // below this the receiver is considered parked...
+#define ODOMETER_STATIONARY_RADIUS_M 25.0f   // ...and wander inside this radius is jitter
+#define ODOMETER_MIN_DISPLACEMENT_M 5.0f     // hops shorter than this are held until they add up
+#define ODOMETER_MAX_SPEED_MPS 70.0f         // anything faster than ~155mph between fixes is a bad fix
+#define ODOMETER_SAVE_DISTANCE_M 500         // persist at most once per 500m...
+#define ODOMETER_SAVE_MIN_INTERVAL 60000     // ...and once a minute (ms)
+#define ODOMETER_EEPROM_ADDR 0
+#define ODOMETER_EEPROM_SLOTS 8 // records rotate across slots to spread the flash writes
+
+// CWD-- one persisted odometer snapshot. The highest valid sequence number wins at boot
+struct OdometerRecord {
+    uint32_t magic;
+    uint32_t sequence;
+    uint64_t lifetimeMm;
+    uint64_t tripMm;
+    uint64_t vehicleBaseMm; // our lifetime total when reconciliation started...
+    uint32_t vehicleBaseHm; // ...and the vehicle odometer (100m units) at that moment, 0 if never seen
+    uint32_t checksum;
+};
+
+class Odometer {
+  public:
+    Odometer();
+
+    void begin();
+    bool addFix(const FixRecord &fix);
+    void resetTrip();
+    void save();
+
+    float getTripMeters();
+    uint32_t getLifetimeMeters();
+    uint32_t getRejectedFixes();
+
+    // CWD-- CAN reconciliation. hectometers is the OBD PID 0xA6 reading (0.1km units)
+    void setVehicleOdometer(uint32_t hectometers);
+    bool hasVehicleOdometer();
+    uint32_t getVehicleOdometerMeters();
+    int32_t getVehicleDriftMeters();
+
+    String describe();
+
+  private:
+    bool blnAnchorSet = false;
+    GeoPoint anchor;
+    unsigned long ulAnchorTime = 0;
+
+    uint64_t ullLifetimeMm = 0;
+    uint64_t ullTripMm = 0;
+    uint64_t ullLastSavedMm = 0;
+    unsigned long ulLastSaveTime = 0;
+    uint32_t ulSequence = 0;
+    uint32_t ulRejectedFixes = 0;
+
+    uint32_t ulVehicleHm = 0;
+    uint32_t ulVehicleBaseHm = 0;
+    uint64_t ullVehicleBaseMm = 0;
+
+    static uint32_t checksum(const OdometerRecord &record);
+};
+
+#endif // def(__Odometer_h)
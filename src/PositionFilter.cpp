@@ -0,0 +1,156 @@
+#include "PositionFilter.h"
+#include <math.h>
+
+// CWD-- x' = F x, P' = F P F^T + Q with F = [1 dt; 0 1] and white-acceleration Q
+void FilterAxis::predict(float dt, float q) {
+    float dt2 = dt * dt;
+    p += v * dt;
+    P00 += dt * (2.0f * P01 + dt * P11) + q * dt2 * dt / 3.0f;
+    P01 += dt * P11 + q * dt2 / 2.0f;
+    P11 += q * dt;
+}
+
+void FilterAxis::updatePosition(float z, float r) {
+    float s = P00 + r;
+    float k0 = P00 / s;
+    float k1 = P01 / s;
+    float y = z - p;
+    p += k0 * y;
+    v += k1 * y;
+    P11 -= k1 * P01;
+    P01 -= k1 * P00;
+    P00 -= k0 * P00;
+}
+
+void FilterAxis::updateVelocity(float z, float r) {
+    float s = P11 + r;
+    float k0 = P01 / s;
+    float k1 = P11 / s;
+    float y = z - v;
+    p += k0 * y;
+    v += k1 * y;
+    P00 -= k0 * P01;
+    P01 -= k0 * P11;
+    P11 -= k1 * P11;
+}
+
+void PositionFilter::reset() {
+    blnInitialized = false;
+    iRejects = 0;
+}
+
+void PositionFilter::seed(const GeoPoint &point, float sigmaM, unsigned long timeMs) {
+    projection.setOrigin(point);
+    east = FilterAxis();
+    north = FilterAxis();
+    east.P00 = north.P00 = sigmaM * sigmaM;
+    east.P11 = north.P11 = 100.0f; // unknown velocity, 10 m/s sigma
+    ulLastTime = timeMs;
+    iRejects = 0;
+    blnInitialized = true;
+}
+
+void PositionFilter::predictTo(unsigned long timeMs) {
+    float dt = fminf((timeMs - ulLastTime) / 1000.0f, FILTER_MAX_PREDICT_S);
+
+    if (dt > 0) {
+        east.predict(dt, FILTER_ACCEL_NOISE * FILTER_ACCEL_NOISE);
+        north.predict(dt, FILTER_ACCEL_NOISE * FILTER_ACCEL_NOISE);
+    }
+
+    ulLastTime = timeMs;
+}
+
+// CWD-- keep the flat-earth frame close to the vehicle so the cached cos(lat) stays accurate
+void PositionFilter::recenter(const GeoPoint &origin) {
+    float e, n;
+    projection.toLocal(origin, e, n);
+    projection.setOrigin(origin);
+    east.p -= e;
+    north.p -= n;
+}
+
+// CWD-- returns false when the fix was gated out as an outlier
+bool PositionFilter::updatePosition(const GeoPoint &point, float sigmaM, unsigned long timeMs) {
+    if (!blnInitialized) {
+        seed(point, sigmaM, timeMs);
+        return true;
+    }
+
+    predictTo(timeMs);
+
+    if (projection.needsRecenter(point)) {
+        recenter(getPosition());
+    }
+
+    float e, n;
+    projection.toLocal(point, e, n);
+    float r = sigmaM * sigmaM;
+    float de = e - east.p;
+    float dn = n - north.p;
+    float gate = FILTER_GATE_SIGMAS * FILTER_GATE_SIGMAS;
+
+    if (de * de > gate * east.innovationVariance(r) || dn * dn > gate * north.innovationVariance(r)) {
+        if (++iRejects < FILTER_MAX_REJECTS || sigmaM > getAccuracy()) {
+            return false;
+        }
+
+        seed(point, sigmaM, timeMs); // a sharper sensor keeps disagreeing, we were the ones who were wrong
+        return true;
+    }
+
+    iRejects = 0;
+    east.updatePosition(e, r);
+    north.updatePosition(n, r);
+    return true;
+}
+
+// CWD-- speed has no direction, so project it onto the current heading. A stopped vehicle pins velocity to zero
+void PositionFilter::updateSpeed(float speedMps, float sigmaMps, unsigned long timeMs) {
+    if (!blnInitialized) {
+        return;
+    }
+
+    predictTo(timeMs);
+    float r = sigmaMps * sigmaMps;
+    float current = getSpeed();
+
+    if (speedMps < FILTER_STOPPED_MPS) {
+        east.updateVelocity(0, r);
+        north.updateVelocity(0, r);
+    } else if (current >= FILTER_STOPPED_MPS) {
+        east.updateVelocity(speedMps * east.v / current, r);
+        north.updateVelocity(speedMps * north.v / current, r);
+    }
+}
+
+// CWD-- full velocity from an external speed and course, used while dead reckoning without GPS
+void PositionFilter::updateVelocity(float speedMps, float courseDeg, float sigmaMps, unsigned long timeMs) {
+    if (!blnInitialized) {
+        return;
+    }
+
+    predictTo(timeMs);
+    float course = courseDeg * (float)(M_PI / 180.0);
+    float r = sigmaMps * sigmaMps;
+    east.updateVelocity(speedMps * sinf(course), r);
+    north.updateVelocity(speedMps * cosf(course), r);
+}
+
+// CWD-- advance the state without a measurement. Position uncertainty grows with the process noise
+void PositionFilter::predict(unsigned long timeMs) {
+    if (blnInitialized) {
+        predictTo(timeMs);
+    }
+}
+
+GeoPoint PositionFilter::getPosition() { return projection.fromLocal(east.p, north.p); }
+
+float PositionFilter::getSpeed() { return sqrtf(east.v * east.v + north.v * north.v); }
+
+float PositionFilter::getCourse() {
+    float course = atan2f(east.v, north.v) * (float)(180.0 / M_PI);
+    return course < 0 ? course + 360.0f : course;
+}
+
+float PositionFilter::getAccuracy() { return sqrtf(east.P00 + north.P00); }
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef __PositionFilter_h
+#define __PositionFilter_h
+
+#include "GeoPoint.h"
+#include "Geodesy.h"
+
+#define FILTER_GPS_UERE_M 5.0f          // user-equivalent range error, GPS sigma = HDOP * UERE
+#define FILTER_GPS_MIN_SIGMA_M 3.0f
+#define FILTER_CELL_MIN_SIGMA_M 100.0f
+#define FILTER_ACCEL_NOISE 2.0f         // m/s^2, how hard we expect a vehicle to maneuver
+#define FILTER_MAX_PREDICT_S 60.0f      // clamp dt so a long gap can't blow up the covariance math
+#define FILTER_GATE_SIGMAS 5.0f         // GPS innovations beyond this are treated as outliers...
+#define FILTER_MAX_REJECTS 3            // ...until this many in a row, then the filter re-seeds
+#define FILTER_STOPPED_MPS 0.5f
+
+// CWD-- one axis of the constant-velocity model: position/velocity with a 2x2 covariance
+struct FilterAxis {
+    float p = 0;
+    float v = 0;
+    float P00 = 0;
+    float P01 = 0;
+    float P11 = 0;
+
+    void predict(float dt, float q);
+    float innovationVariance(float r) const { return P00 + r; }
+    void updatePosition(float z, float r);
+    void updateVelocity(float z, float r);
+};
+
+// CWD-- constant-velocity Kalman filter in a local east/north frame. Axes are filtered independently so every
+// update is a handful of float ops with fixed-size state and no heap use
+class PositionFilter {
+  public:
+    PositionFilter() {}
+
+    void reset();
+    bool isInitialized() { return blnInitialized; }
+
+    bool updatePosition(const GeoPoint &point, float sigmaM, unsigned long timeMs);
+    void updateSpeed(float speedMps, float sigmaMps, unsigned long timeMs);
+    void updateVelocity(float speedMps, float courseDeg, float sigmaMps, unsigned long timeMs);
+    void predict(unsigned long timeMs);
+
+    GeoPoint getPosition();
+    float getSpeed();
+    float getCourse(); // degrees, North=0
+    float getAccuracy();
+
+    static float gpsSigma(uint16_t hdop) { return fmaxf(FILTER_GPS_MIN_SIGMA_M, hdop / 100.0f * FILTER_GPS_UERE_M); }
+    static float cellSigma(float accuracy) { return fmaxf(FILTER_CELL_MIN_SIGMA_M, accuracy); }
+
+  private:
+    void seed(const GeoPoint &point, float sigmaM, unsigned long timeMs);
+    void predictTo(unsigned long timeMs);
+    void recenter(const GeoPoint &origin);
+
+    bool blnInitialized = false;
+    unsigned long ulLastTime = 0;
+    int iRejects = 0;
+    LocalProjection projection;
+    FilterAxis east;
+    FilterAxis north;
+};
+
+#endif // def(__PositionFilter_h)
@@ -0,0 +1,177 @@
+#include "PublishScheduler.h"
+
+#if Wiring_Cellular
+#include "CellularHelper.h"
+#endif
+
+void PublishScheduler::begin() {
+    urgentQueue.begin();
+    bulkQueue.begin();
+}
+
+void PublishScheduler::update(unsigned long time, bool blnModemBusy) {
+    // CWD-- sample link quality on a slow cadence; AT+CSQ is cheap but still a modem round trip. While the
+    // locator's worker is scanning it owns the modem: a second AT stream would interleave with its CGED/QENG and
+    // block loop() on the modem lock for the whole scan, so the sample waits until the scan is done
+    if (!blnModemBusy && (!blnSampled || (time - ulLastSample) >= SCHED_SIGNAL_SAMPLE_INTERVAL)) {
+        sampleSignal(time);
+    }
+
+    drain(time);
+}
+
+void PublishScheduler::sampleSignal(unsigned long time) {
+    ulLastSample = time;
+    blnSampled = true;
+
+#if Wiring_Cellular
+    CellularHelperRSSIQualResponse rssiQual = CellularHelper.getRSSIQual();
+    if (rssiQual.resp != RESP_OK || rssiQual.rssi == 99) {
+        iRSSI = 0;
+    } else {
+        iRSSI = -113 + 2 * rssiQual.rssi; // 0 = -113 dBm, 2 dBm steps
+    }
+#else
+    iRSSI = WiFi.RSSI();
+#endif
+}
+
+int PublishScheduler::getRSSI() { return iRSSI; }
+
+bool PublishScheduler::isSignalGood() { return iRSSI != 0 && iRSSI >= SCHED_GOOD_RSSI_DBM; }
+
+// CWD-- urgent records go out now if they can, unless older urgent records are still queued from an outage:
+// then they queue up behind those so the cloud sees them in order. Bulk records always go through the queue so
+// the drain can pack them several to an event. Returns false only when the record was lost
+bool PublishScheduler::send(const char *event, const char *data, PublishPriority priority) {
+    TelemetryQueue &queue = priority == PUBLISH_URGENT ? urgentQueue : bulkQueue;
+    bool blnLive = !queue.isReady() || (priority == PUBLISH_URGENT && queue.isEmpty());
+    if (blnLive && canPublish(priority, millis()) && publish(event, data, priority)) {
+        return true;
+    }
+
+    if (queue.push(event, data, priority == PUBLISH_URGENT ? TELEMETRY_FLAG_URGENT : 0, Time.isValid() ? Time.now() : 0)) {
+        Log.trace("Queued %s, %u pending", event, queue.size());
+        return true;
+    }
+    return false;
+}
+
+// CWD-- one event per drain interval. The urgent backlog goes first and doesn't wait for good signal; bulk
+// records only drain once it's empty and the link is good or they've been deferred long enough
+void PublishScheduler::drain(unsigned long time) {
+    if ((time - ulLastDrain) < SCHED_DRAIN_INTERVAL || !Particle.connected()) {
+        return;
+    }
+
+    if (!urgentQueue.isEmpty()) {
+        ulLastDrain = time;
+        drainQueue(urgentQueue, PUBLISH_URGENT);
+    } else if (!bulkQueue.isEmpty() && canPublish(PUBLISH_BULK, time)) {
+        ulLastDrain = time;
+        drainQueue(bulkQueue, PUBLISH_BULK);
+    }
+}
+
+// CWD-- publish the oldest record, packed with as many consecutive records of the same event type as fit
+void PublishScheduler::drainQueue(TelemetryQueue &queue, PublishPriority priority) {
+    static char event[TELEMETRY_EVENT_MAX];
+    static char data[TELEMETRY_DATA_MAX + 1];
+    static char packed[TELEMETRY_DATA_MAX + 1];
+    static char nextEvent[TELEMETRY_EVENT_MAX];
+    static char nextData[TELEMETRY_DATA_MAX + 1];
+    uint8_t flags, nextFlags;
+    uint32_t queued, nextQueued;
+    if (!queue.peek(event, sizeof(event), data, sizeof(data), flags, queued)) {
+        return;
+    }
+
+    packer.begin(packed, min(sizeof(packed), (size_t)Particle.maxEventDataSize()), queued);
+    if (packer.add(data, queued)) {
+        for (size_t i = 1; i < SCHED_PACK_MAX && queue.peekAt(i, nextEvent, sizeof(nextEvent), nextData, sizeof(nextData), nextFlags, nextQueued);
+             i++) {
+            if (strcmp(nextEvent, event) != 0 || !packer.add(nextData, nextQueued)) {
+                break;
+            }
+        }
+    }
+
+    if (packer.getCount() <= 1) {
+        // CWD-- nothing to pack with, publish it exactly as it was queued
+        if (publish(event, data, priority)) {
+            queue.pop();
+        }
+        return;
+    }
+
+    char batchEvent[TELEMETRY_EVENT_MAX + sizeof(SCHED_BATCH_SUFFIX)];
+    snprintf(batchEvent, sizeof(batchEvent), "%s%s", event, SCHED_BATCH_SUFFIX);
+    if (publish(batchEvent, packer.finish(), priority, packer.getCount())) {
+        queue.pop(packer.getCount());
+    }
+}
+
+bool PublishScheduler::canPublish(PublishPriority priority, unsigned long time) {
+    if (!Particle.connected()) {
+        return false;
+    }
+
+    if (priority == PUBLISH_URGENT || isSignalGood()) {
+        return true;
+    }
+
+    if (!blnBulkWaiting) {
+        blnBulkWaiting = true;
+        ulBulkWaitingSince = time;
+        Log.trace("Deferring bulk upload, RSSI %d dBm", iRSSI);
+    }
+    return (time - ulBulkWaitingSince) >= SCHED_MAX_DEFER;
+}
+
+bool PublishScheduler::publish(const char *event, const char *data, PublishPriority priority, size_t records) {
+    size_t bytes = strlen(event) + strlen(data);
+    fEnergy += energyEstimate(bytes);
+
+    if (!Particle.publish(event, data)) {
+        ulFailures++;
+        return false;
+    }
+
+    if (priority == PUBLISH_BULK) {
+        blnBulkWaiting = false;
+    }
+    ulEvents++;
+    ulRecords += records;
+    ulBytes += bytes;
+    return true;
+}
+
+// CWD-- a weak link means higher transmit power and more HARQ retransmissions for the same payload
+float PublishScheduler::energyEstimate(size_t bytes) {
+    float scale = 1.0f;
+    if (iRSSI != 0 && iRSSI < -85) {
+        scale = 1.0f + 3.0f * (-85 - iRSSI) / 28.0f; // 1x at -85 dBm up to 4x at -113 dBm
+    }
+    return SCHED_ENERGY_PER_PUBLISH_MJ + bytes * SCHED_ENERGY_PER_BYTE_MJ * scale;
+}
+
+size_t PublishScheduler::getQueued() { return urgentQueue.size() + bulkQueue.size(); }
+
+float PublishScheduler::getRecordsPerEvent() { return ulEvents ? (float)ulRecords / ulEvents : 0; }
+
+uint32_t PublishScheduler::getRecordsSent() { return ulRecords; }
+
+uint32_t PublishScheduler::getFailures() { return ulFailures; }
+
+float PublishScheduler::getBytesPerRecord() { return ulRecords ? (float)ulBytes / ulRecords : 0; }
+
+float PublishScheduler::getRetriesPerRecord() { return ulRecords ? (float)ulFailures / ulRecords : 0; }
+
+// CWD-- failed attempts still cost energy, so they're charged to the records that did get through
+float PublishScheduler::getEnergyPerRecord() { return ulRecords ? fEnergy / ulRecords : 0; }
+
+String PublishScheduler::describe() {
+    return String::format("rssi=%d,sent=%lu,failed=%lu,perEvent=%.1f,bytes=%.0f,retries=%.2f,mJ=%.0f,queued=%u,lost=%lu", iRSSI,
+                          (unsigned long)ulRecords, (unsigned long)ulFailures, getRecordsPerEvent(), getBytesPerRecord(), getRetriesPerRecord(),
+                          getEnergyPerRecord(), getQueued(), (unsigned long)(urgentQueue.getOverwritten() + bulkQueue.getOverwritten()));
+}
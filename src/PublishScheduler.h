@@ -0,0 +1,71 @@
+#pragma once
+#ifndef __PublishScheduler_h
+#define __PublishScheduler_h
+
+#include "Particle.h"
+#include "RecordPacker.h"
+#include "TelemetryQueue.h"
+
+#define SCHED_SIGNAL_SAMPLE_INTERVAL 30000 // AT+CSQ at most this often (ms)
+#define SCHED_GOOD_RSSI_DBM -95            // bulk uploads wait for a link at least this strong...
+#define SCHED_MAX_DEFER 600000             // ...but never longer than this (ms)
+#define SCHED_ENERGY_PER_PUBLISH_MJ 150.0f // rough radio wake + protocol overhead per publish
+#define SCHED_ENERGY_PER_BYTE_MJ 0.2f      // at a strong signal, scaled up to 4x as RSSI drops to the floor
+#define SCHED_DRAIN_INTERVAL 1000          // the cloud allows about one publish a second sustained (ms)
+#define SCHED_PACK_MAX 64                  // most queued records looked at for one packed event
+#define SCHED_BATCH_SUFFIX "_batch"        // packed events are published as <event>_batch
+#define SCHED_URGENT_SEGMENTS 4            // flash queue segments for urgent records...
+#define SCHED_BULK_SEGMENTS 12             // ...and for bulk ones (TELEMETRY_SEGMENT_SIZE each)
+
+// CWD-- urgent records (geofence and motion events) go out as soon as we're connected. Bulk records (GPS points,
+// track batches, raw CAN) can wait for a good-signal window, where the modem transmits at lower power with fewer retries.
+// Anything that can't go out right away is kept in flash, one queue per priority so an urgent backlog drains
+// ahead of bulk records still waiting for signal. Each queue drains in order
+enum PublishPriority { PUBLISH_URGENT, PUBLISH_BULK };
+
+class PublishScheduler {
+  public:
+    void begin();
+    void update(unsigned long time, bool blnModemBusy = false); // CWD-- busy: another thread owns the modem, don't sample
+
+    bool send(const char *event, const char *data, PublishPriority priority);
+
+    int getRSSI(); // dBm, 0 when unknown
+    bool isSignalGood();
+
+    uint32_t getRecordsSent();
+    uint32_t getFailures();
+    float getBytesPerRecord();
+    float getRetriesPerRecord();
+    float getEnergyPerRecord(); // estimated mJ
+    float getRecordsPerEvent();
+    size_t getQueued();
+    String describe();
+
+  private:
+    bool canPublish(PublishPriority priority, unsigned long time);
+    bool publish(const char *event, const char *data, PublishPriority priority, size_t records = 1);
+    void drain(unsigned long time);
+    void drainQueue(TelemetryQueue &queue, PublishPriority priority);
+    void sampleSignal(unsigned long time);
+    float energyEstimate(size_t bytes);
+
+    TelemetryQueue urgentQueue = TelemetryQueue(TELEMETRY_QUEUE_DIR "/urgent", SCHED_URGENT_SEGMENTS);
+    TelemetryQueue bulkQueue = TelemetryQueue(TELEMETRY_QUEUE_DIR "/bulk", SCHED_BULK_SEGMENTS);
+    RecordPacker packer;
+    unsigned long ulLastDrain = 0;
+
+    int iRSSI = 0;
+    bool blnSampled = false;
+    unsigned long ulLastSample = 0;
+    bool blnBulkWaiting = false;
+    unsigned long ulBulkWaitingSince = 0;
+
+    uint32_t ulEvents = 0;
+    uint32_t ulRecords = 0;
+    uint32_t ulFailures = 0;
+    uint32_t ulBytes = 0;
+    float fEnergy = 0;
+};
+
+#endif // def(__PublishScheduler_h)
@@ -0,0 +1,31 @@
+#include "RecordPacker.h"
+
+void RecordPacker::begin(char *buf, size_t capacity, uint32_t t0) {
+    json = JsonWriter(buf, capacity);
+    json.reserve(PACKER_TRAILER_LEN);
+    json.beginObject().key("t0").number(t0).key("tu").string("s").key("r").beginArray();
+    ulT0 = t0;
+    count = 0;
+}
+
+// CWD-- false when the record doesn't fit; the caller publishes what's packed so far
+bool RecordPacker::add(const char *record, uint32_t time) {
+    JsonWriter before = json;
+    json.beginArray().number((ulT0 && time) ? (int32_t)(time - ulT0) : 0).raw(record).endArray();
+    if (json.isOverflowed()) {
+        json = before;
+        return false;
+    }
+    count++;
+    return true;
+}
+
+const char *RecordPacker::finish() {
+    json.reserve(0);
+    json.endArray().key("n").number(count).endObject();
+    return json.c_str();
+}
+
+size_t RecordPacker::getCount() { return count; }
+
+size_t RecordPacker::getLength() { return json.length(); }
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef __RecordPacker_h
+#define __RecordPacker_h
+
+#include "JsonWriter.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACKER_TRAILER_LEN 12 // room for ",\"n\":NNNNN" behind the records
+
+// CWD-- packs several queued records of one event type into a single cloud event, since the platform
+// rate-limits publishes rather than bytes. Shared header, then each record behind its time offset:
+//   {"t0":<unix s>,"tu":"s","r":[[dt,<record>],[dt,<record>],...],"n":<count>}
+class RecordPacker {
+  public:
+    void begin(char *buf, size_t capacity, uint32_t t0);
+    bool add(const char *record, uint32_t time);
+    const char *finish();
+
+    size_t getCount();
+    size_t getLength();
+
+  private:
+    JsonWriter json = JsonWriter(nullptr, 0);
+    size_t count = 0;
+    uint32_t ulT0 = 0;
+};
+
+#endif // def(__RecordPacker_h)
@@ -0,0 +1,125 @@
+#include "SamplingPolicy.h"
+#include "Geodesy.h"
+#include "Particle.h"
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+
+SamplingPolicy::SamplingPolicy(unsigned long cellRefreshInterval) : ulCellRefreshInterval(cellRefreshInterval) {}
+
+bool SamplingPolicy::shouldPublish(const GeoPoint &location, float course, float speedMps, unsigned long time) {
+    if (!blnPublished) {
+        return true;
+    }
+
+    unsigned long elapsed = time - ulLastTime;
+
+    if (motionState == MOTION_PARKED || motionState == MOTION_IDLING) {
+        return elapsed >= ulParkedInterval;
+    }
+
+    if (elapsed >= ulMaxInterval) {
+        return true;
+    }
+
+    if (elapsed < ulMinInterval) {
+        return false;
+    }
+
+    if (Geodesy::haversine(lastLocation, location) >= ulDistance) {
+        return true;
+    }
+
+    float turn = fabsf(course - fLastCourse);
+    turn = turn > 180.0f ? 360.0f - turn : turn;
+    return speedMps >= POLICY_HEADING_MIN_SPEED && turn >= ulHeading;
+}
+
+void SamplingPolicy::published(const GeoPoint &location, float course, unsigned long time, size_t bytes) {
+    if (blnPublished) {
+        fMeters += Geodesy::haversine(lastLocation, location);
+    }
+
+    blnPublished = true;
+    lastLocation = location;
+    fLastCourse = course;
+    ulLastTime = time;
+    ulPoints++;
+    ulBytes += bytes;
+}
+
+void SamplingPolicy::setMotionState(MotionState state) { motionState = state; }
+
+unsigned long SamplingPolicy::getCellRefreshInterval() {
+    return (motionState == MOTION_PARKED || motionState == MOTION_IDLING) ? ulCellRefreshInterval * POLICY_PARKED_CELL_SCALE : ulCellRefreshInterval;
+}
+
+// CWD-- all or nothing: the keys are parsed into a copy, checked together, and only then applied
+int SamplingPolicy::configure(const char *params) {
+    unsigned long values[] = {ulMinInterval, ulMaxInterval, ulDistance, ulHeading, ulParkedInterval};
+    unsigned long &minInterval = values[0], &maxInterval = values[1], &distance = values[2], &heading = values[3], &parked = values[4];
+    int applied = 0;
+    const char *cur = params;
+
+    while (cur && *cur) {
+        const char *eq = strchr(cur, '=');
+
+        if (!eq || !isdigit((unsigned char)eq[1])) {
+            return POLICY_ERR_SYNTAX;
+        }
+
+        char *end;
+        errno = 0;
+        unsigned long value = strtoul(eq + 1, &end, 10);
+        size_t keyLen = eq - cur;
+        unsigned long *target = NULL;
+
+        if (*end != ',' && *end != '\0') {
+            return POLICY_ERR_SYNTAX;
+        }
+
+        // CWD-- strtoul saturates on overflow rather than failing; anything that big is a typo either way
+        if (errno == ERANGE || value > POLICY_VALUE_MAX) {
+            return POLICY_ERR_RANGE;
+        }
+
+        if (keyLen == 3 && !strncmp(cur, "min", 3)) {
+            target = &minInterval;
+        } else if (keyLen == 3 && !strncmp(cur, "max", 3)) {
+            target = &maxInterval;
+        } else if (keyLen == 4 && !strncmp(cur, "dist", 4)) {
+            target = &distance;
+        } else if (keyLen == 7 && !strncmp(cur, "heading", 7)) {
+            target = &heading;
+        } else if (keyLen == 6 && !strncmp(cur, "parked", 6)) {
+            target = &parked;
+        } else {
+            return POLICY_ERR_SYNTAX;
+        }
+
+        *target = value;
+        applied++;
+        cur = *end ? end + 1 : NULL;
+    }
+
+    if (minInterval == 0 || maxInterval < minInterval || distance == 0 || heading == 0 || heading > 180 || parked == 0) {
+        return POLICY_ERR_RANGE;
+    }
+
+    ulMinInterval = minInterval;
+    ulMaxInterval = maxInterval;
+    ulDistance = distance;
+    ulHeading = heading;
+    ulParkedInterval = parked;
+    return applied;
+}
+
+// CWD-- current parameters plus the achieved spatial resolution and cost
+String SamplingPolicy::describe() {
+    return String::format("min=%lu,max=%lu,dist=%lu,heading=%lu,parked=%lu;m/pt=%.0f,B/km=%.0f", ulMinInterval, ulMaxInterval, ulDistance, ulHeading,
+                          ulParkedInterval, getMetersPerPoint(), getBytesPerKm());
+}
+
+float SamplingPolicy::getMetersPerPoint() { return ulPoints > 1 ? fMeters / (ulPoints - 1) : 0; }
+
+float SamplingPolicy::getBytesPerKm() { return fMeters > 0 ? ulBytes / (fMeters / 1000.0f) : 0; }
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef __SamplingPolicy_h
+#define __SamplingPolicy_h
+
+#include "GeoPoint.h"
+#include "MotionManager.h"
+#include "Particle.h"
+
+#define POLICY_MIN_INTERVAL 1000      // never publish positions faster than this (ms)
+#define POLICY_MAX_INTERVAL 60000     // always publish at least this often while moving (ms)
+#define POLICY_PARKED_INTERVAL 900000 // heartbeat while parked/idling (ms)
+#define POLICY_DISTANCE_M 200         // publish after this much travel...
+#define POLICY_HEADING_DEG 20         // ...or this much turn, whichever fires first
+#define POLICY_HEADING_MIN_SPEED 2.0f // course is noise below this (m/s)
+#define POLICY_PARKED_CELL_SCALE 8    // stretch the cell locate interval this much while stationary
+
+#define POLICY_VALUE_MAX 86400000UL // configure(): largest value taken for any key, a day in ms
+
+#define POLICY_ERR_SYNTAX -1 // configure(): unknown key, missing '=' or a value that isn't a plain number
+#define POLICY_ERR_RANGE -2  // configure(): a value over POLICY_VALUE_MAX, min/dist/heading/parked of 0, heading over 180
+                             // or max below min
+
+// CWD-- decides when a position is worth publishing: a time, distance or heading-change trigger, whichever
+// fires first. Dense points on curves, sparse ones on straight highway, a slow heartbeat when parked
+class SamplingPolicy {
+  public:
+    SamplingPolicy(unsigned long cellRefreshInterval);
+
+    bool shouldPublish(const GeoPoint &location, float course, float speedMps, unsigned long time);
+    void published(const GeoPoint &location, float course, unsigned long time, size_t bytes);
+
+    void setMotionState(MotionState state);
+    unsigned long getCellRefreshInterval();
+
+    // CWD-- runtime tuning, "min=1000,max=60000,dist=200,heading=20,parked=900000". Returns the number of keys
+    // applied, or POLICY_ERR_* with nothing changed
+    int configure(const char *params);
+    String describe();
+
+    float getMetersPerPoint();
+    float getBytesPerKm();
+
+  private:
+    unsigned long ulMinInterval = POLICY_MIN_INTERVAL;
+    unsigned long ulMaxInterval = POLICY_MAX_INTERVAL;
+    unsigned long ulParkedInterval = POLICY_PARKED_INTERVAL;
+    unsigned long ulDistance = POLICY_DISTANCE_M;
+    unsigned long ulHeading = POLICY_HEADING_DEG;
+    unsigned long ulCellRefreshInterval;
+
+    MotionState motionState = MOTION_UNKNOWN;
+    bool blnPublished = false;
+    GeoPoint lastLocation;
+    float fLastCourse = 0;
+    unsigned long ulLastTime = 0;
+
+    uint32_t ulPoints = 0;
+    uint32_t ulBytes = 0;
+    float fMeters = 0;
+};
+
+#endif // def(__SamplingPolicy_h)
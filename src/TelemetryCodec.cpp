@@ -0,0 +1,293 @@
+#include "TelemetryCodec.h"
+
+#include <string.h>
+
+static const char Z85_CHARS[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
+
+size_t TelemetryCodec::encodeGPS(const TelemetryGPSRecord &record, uint8_t *buf, size_t len) {
+    if (len < 1) {
+        return 0;
+    }
+
+    size_t n = 0, used;
+    buf[n++] = header(TELEMETRY_RECORD_GPS);
+    uint64_t fields[] = {record.time, zigzag(record.lat), zigzag(record.lon), zigzag(record.altitude), record.speed, record.satellites,
+                         record.source};
+    for (uint64_t field : fields) {
+        if ((used = putVarint(field, buf + n, len - n)) == 0) {
+            return 0;
+        }
+        n += used;
+    }
+    return n;
+}
+
+// CWD-- header, base time, frame count, then per frame the zigzag ms since the previous frame, id, length
+// and payload. Returns 0 if it doesn't fit or there are no frames
+size_t TelemetryCodec::encodeCANBatch(const TelemetryCANRecord *records, size_t count, uint8_t *buf, size_t len) {
+    if (len < 1 || count == 0 || count > TELEMETRY_CAN_BATCH_MAX) {
+        return 0;
+    }
+
+    size_t n = 0, used;
+    buf[n++] = header(TELEMETRY_RECORD_CAN_BATCH);
+    uint64_t fields[] = {records[0].time, count};
+    for (uint64_t field : fields) {
+        if ((used = putVarint(field, buf + n, len - n)) == 0) {
+            return 0;
+        }
+        n += used;
+    }
+
+    uint64_t previous = records[0].time;
+    for (size_t i = 0; i < count; i++) {
+        const TelemetryCANRecord &record = records[i];
+        if (record.length > TELEMETRY_CAN_DATA_MAX) {
+            return 0;
+        }
+        uint64_t frame[] = {zigzag((int64_t)(record.time - previous)), record.id, record.length};
+        for (uint64_t field : frame) {
+            if ((used = putVarint(field, buf + n, len - n)) == 0) {
+                return 0;
+            }
+            n += used;
+        }
+        if (n + record.length > len) {
+            return 0;
+        }
+        memcpy(buf + n, record.data, record.length);
+        n += record.length;
+        previous = record.time;
+    }
+    return n;
+}
+
+// CWD-- the record type, or -1 for an empty buffer or a version this decoder doesn't know. Version 1 differs
+// only in the text transport and the track stream, which checks the version itself
+int TelemetryCodec::recordType(const uint8_t *buf, size_t len) {
+    int version = recordVersion(buf, len);
+    if (version < TELEMETRY_CODEC_MIN_VERSION || version > TELEMETRY_CODEC_VERSION) {
+        return -1;
+    }
+    return buf[0] & 0x0F;
+}
+
+int TelemetryCodec::recordVersion(const uint8_t *buf, size_t len) { return len < 1 ? -1 : buf[0] >> 4; }
+
+bool TelemetryCodec::decodeGPS(const uint8_t *buf, size_t len, TelemetryGPSRecord &record) {
+    if (recordType(buf, len) != TELEMETRY_RECORD_GPS) {
+        return false;
+    }
+
+    uint64_t fields[7];
+    size_t n = 1, used;
+    for (uint64_t &field : fields) {
+        if ((used = getVarint(buf + n, len - n, field)) == 0) {
+            return false;
+        }
+        n += used;
+    }
+
+    record.time = fields[0];
+    record.lat = (int32_t)unzigzag(fields[1]);
+    record.lon = (int32_t)unzigzag(fields[2]);
+    record.altitude = (int32_t)unzigzag(fields[3]);
+    record.speed = (uint16_t)fields[4];
+    record.satellites = (uint8_t)fields[5];
+    record.source = (uint8_t)fields[6];
+    return true;
+}
+
+// CWD-- a lone frame: time, id, length, payload. Nothing encodes these any more, but records still queued in flash
+// or sitting on the server from older firmware are this type
+bool TelemetryCodec::decodeCAN(const uint8_t *buf, size_t len, TelemetryCANRecord &record) {
+    if (recordType(buf, len) != TELEMETRY_RECORD_CAN) {
+        return false;
+    }
+
+    uint64_t fields[3];
+    size_t n = 1, used;
+    for (uint64_t &field : fields) {
+        if ((used = getVarint(buf + n, len - n, field)) == 0) {
+            return false;
+        }
+        n += used;
+    }
+    if (fields[2] > TELEMETRY_CAN_DATA_MAX || n + fields[2] > len) {
+        return false;
+    }
+
+    record.time = fields[0];
+    record.id = (uint32_t)fields[1];
+    record.length = (uint8_t)fields[2];
+    memcpy(record.data, buf + n, record.length);
+    return true;
+}
+
+// CWD-- frames decoded, 0 for anything malformed or more frames than fit in records
+size_t TelemetryCodec::decodeCANBatch(const uint8_t *buf, size_t len, TelemetryCANRecord *records, size_t maxRecords) {
+    if (recordType(buf, len) != TELEMETRY_RECORD_CAN_BATCH) {
+        return 0;
+    }
+
+    uint64_t fields[2];
+    size_t n = 1, used;
+    for (uint64_t &field : fields) {
+        if ((used = getVarint(buf + n, len - n, field)) == 0) {
+            return 0;
+        }
+        n += used;
+    }
+    uint64_t time = fields[0];
+    uint64_t count = fields[1];
+    if (count == 0 || count > maxRecords) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t frame[3];
+        for (uint64_t &field : frame) {
+            if ((used = getVarint(buf + n, len - n, field)) == 0) {
+                return 0;
+            }
+            n += used;
+        }
+        if (frame[2] > TELEMETRY_CAN_DATA_MAX || n + frame[2] > len) {
+            return 0;
+        }
+
+        time += unzigzag(frame[0]);
+        records[i].time = time;
+        records[i].id = (uint32_t)frame[1];
+        records[i].length = (uint8_t)frame[2];
+        memcpy(records[i].data, buf + n, records[i].length);
+        n += records[i].length;
+    }
+    return n == len ? count : 0;
+}
+
+// CWD-- quoted "z<base85>" with the null. Returns the length without the null, 0 if it doesn't fit
+size_t TelemetryCodec::toText(const uint8_t *buf, size_t len, char *text, size_t textLen) {
+    if (textLen < 4) {
+        return 0;
+    }
+
+    text[0] = '"';
+    text[1] = TELEMETRY_TEXT_PREFIX;
+    size_t n = base85Encode(buf, len, text + 2, textLen - 3);
+    if (n == 0 && len != 0) {
+        return 0;
+    }
+    text[n + 2] = '"';
+    text[n + 3] = 0;
+    return n + 3;
+}
+
+// CWD-- accepts the text with or without its quotes. Returns the decoded length
+size_t TelemetryCodec::fromText(const char *text, uint8_t *buf, size_t len) {
+    size_t textLen = strlen(text);
+    if (textLen >= 2 && text[0] == '"' && text[textLen - 1] == '"') {
+        text++;
+        textLen -= 2;
+    }
+    if (textLen < 1 || text[0] != TELEMETRY_TEXT_PREFIX) {
+        return 0;
+    }
+    return base85Decode(text + 1, textLen - 1, buf, len);
+}
+
+size_t TelemetryCodec::putVarint(uint64_t value, uint8_t *buf, size_t len) {
+    size_t n = 0;
+    do {
+        if (n >= len) {
+            return 0;
+        }
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buf[n++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    return n;
+}
+
+// CWD-- bytes consumed, 0 for a truncated or overlong varint
+size_t TelemetryCodec::getVarint(const uint8_t *buf, size_t len, uint64_t &value) {
+    value = 0;
+    for (size_t n = 0; n < len && n < 10; n++) {
+        value |= (uint64_t)(buf[n] & 0x7F) << (7 * n);
+        if (!(buf[n] & 0x80)) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// CWD-- CRC-16/CCITT-FALSE, bitwise: it only covers a few dozen bytes at a time
+uint16_t TelemetryCodec::crc16(const uint8_t *buf, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)*buf++ << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// CWD-- Z85: four bytes big endian to five characters. A short final group of n bytes is zero padded and cut
+// to n + 1 characters, as Ascii85 does, so lengths survive the round trip. The alphabet has no quotes or
+// backslashes, so the output drops straight into JSON. Returns 0 if it doesn't fit with the null
+size_t TelemetryCodec::base85Encode(const uint8_t *buf, size_t len, char *text, size_t textLen) {
+    size_t chars = len / 4 * 5 + (len % 4 ? len % 4 + 1 : 0);
+    if (chars + 1 > textLen) {
+        return 0;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 4) {
+        uint32_t value = 0;
+        char group[5];
+        for (size_t j = 0; j < 4; j++) {
+            value = (value << 8) | (i + j < len ? buf[i + j] : 0);
+        }
+        for (int j = 4; j >= 0; j--) {
+            group[j] = Z85_CHARS[value % 85];
+            value /= 85;
+        }
+        size_t groupLen = len - i < 4 ? len - i + 1 : 5;
+        memcpy(text + n, group, groupLen);
+        n += groupLen;
+    }
+    text[n] = 0;
+    return n;
+}
+
+size_t TelemetryCodec::base85Decode(const char *text, size_t textLen, uint8_t *buf, size_t len) {
+    size_t bytes = textLen / 5 * 4 + (textLen % 5 ? textLen % 5 - 1 : 0);
+    if (textLen % 5 == 1 || bytes > len) {
+        return 0;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < textLen; i += 5) {
+        uint64_t value = 0; // CWD-- wide enough to catch groups that overflow 32 bits
+        for (size_t j = 0; j < 5; j++) {
+            // CWD-- a short final group is padded with the highest digit, which rounds back to its bytes
+            const char *digit = i + j >= textLen ? &Z85_CHARS[84] : strchr(Z85_CHARS, text[i + j]);
+            if (digit == nullptr || *digit == 0) {
+                return 0;
+            }
+            value = value * 85 + (digit - Z85_CHARS);
+        }
+        if (value > 0xFFFFFFFFULL) {
+            return 0;
+        }
+        for (int j = 3; j >= 0; j--) {
+            if (n + j < bytes) {
+                buf[n + j] = value & 0xFF;
+            }
+            value >>= 8;
+        }
+        n += 4;
+    }
+    return bytes;
+}
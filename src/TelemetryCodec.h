@@ -0,0 +1,68 @@
+#pragma once
+#ifndef __TelemetryCodec_h
+#define __TelemetryCodec_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CWD-- deliberately free of Particle headers so the same file builds into host-side decoders
+
+#define TELEMETRY_CODEC_VERSION 2     // 2: exact-length Z85 final groups; CRC-16 groups and unix time in track streams
+#define TELEMETRY_CODEC_MIN_VERSION 1 // oldest version whose GPS and CAN records still decode
+#define TELEMETRY_RECORD_GPS 0x01
+#define TELEMETRY_RECORD_CAN 0x02       // a lone CAN frame, decode only: about 4x on JSON, short of batching's 5x+
+#define TELEMETRY_RECORD_TRACK 0x03     // TrackCodec delta stream
+#define TELEMETRY_RECORD_CAN_BATCH 0x04 // CAN frames sharing one base time
+#define TELEMETRY_RECORD_MAX 40         // largest encoded record, before the text transport
+#define TELEMETRY_TEXT_PREFIX 'z'       // published text is "z<base85>", quoted so it still packs as a JSON value
+#define TELEMETRY_CAN_DATA_MAX 8
+#define TELEMETRY_CAN_BATCH_MAX 8                                   // frames in one batch record
+#define TELEMETRY_CAN_BATCH_BYTES (12 + TELEMETRY_CAN_BATCH_MAX * 24) // largest encoded batch
+
+struct TelemetryGPSRecord {
+    uint64_t time = 0;     // unix ms
+    int32_t lat = 0;       // 1e-7 degrees
+    int32_t lon = 0;       // 1e-7 degrees
+    int32_t altitude = 0;  // decimeters
+    uint16_t speed = 0;    // cm/s
+    uint8_t satellites = 0;
+    uint8_t source = 0;    // LocationSource
+};
+
+struct TelemetryCANRecord {
+    uint64_t time = 0; // unix ms
+    uint32_t id = 0;
+    uint8_t length = 0;
+    uint8_t data[TELEMETRY_CAN_DATA_MAX];
+};
+
+// CWD-- compact record schema for the text-only publish channel. Each record is a version/type byte followed
+// by LEB128 varints (signed fields zigzag mapped) and raw CAN payload bytes, then Z85 (base85) encoded.
+// A GPS point comes out around 33 characters against ~170 for the JSON. A lone CAN frame was about 26 against
+// ~105, most of it the 6-byte unix ms time, so CAN frames only go out in batches: one base time, then each
+// frame's milliseconds since the one before, ~18 characters a frame
+class TelemetryCodec {
+  public:
+    static uint8_t header(uint8_t type) { return (TELEMETRY_CODEC_VERSION << 4) | type; }
+    static size_t encodeGPS(const TelemetryGPSRecord &record, uint8_t *buf, size_t len);
+    static size_t encodeCANBatch(const TelemetryCANRecord *records, size_t count, uint8_t *buf, size_t len);
+    static int recordType(const uint8_t *buf, size_t len);
+    static int recordVersion(const uint8_t *buf, size_t len);
+    static bool decodeGPS(const uint8_t *buf, size_t len, TelemetryGPSRecord &record);
+    static bool decodeCAN(const uint8_t *buf, size_t len, TelemetryCANRecord &record);
+    static size_t decodeCANBatch(const uint8_t *buf, size_t len, TelemetryCANRecord *records, size_t maxRecords);
+
+    static size_t toText(const uint8_t *buf, size_t len, char *text, size_t textLen);
+    static size_t fromText(const char *text, uint8_t *buf, size_t len);
+
+    static size_t putVarint(uint64_t value, uint8_t *buf, size_t len);
+    static size_t getVarint(const uint8_t *buf, size_t len, uint64_t &value);
+    static uint64_t zigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+    static uint16_t crc16(const uint8_t *buf, size_t len);
+
+    static size_t base85Encode(const uint8_t *buf, size_t len, char *text, size_t textLen);
+    static size_t base85Decode(const char *text, size_t textLen, uint8_t *buf, size_t len);
+};
+
+#endif // def(__TelemetryCodec_h)
@@ -0,0 +1,523 @@
+#include "TelemetryQueue.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define TELEMETRY_MAGIC 0x544c4d31 // "TLM1"
+#define TELEMETRY_ACK_NAME "ack"
+#define TELEMETRY_ACK_TEMP_NAME "ack.tmp"
+#define TELEMETRY_PATH_MAX 128
+
+struct TelemetryAck {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t crc;
+};
+
+// CWD-- header plus payload of the record being written or read. Both queues share it; nothing holds on to it
+// across calls
+static char record[sizeof(TelemetryRecordHeader) + TELEMETRY_EVENT_MAX + TELEMETRY_DATA_MAX];
+static char *const payload = record + sizeof(TelemetryRecordHeader);
+
+TelemetryQueue::TelemetryQueue(const char *directory, size_t segments)
+    : strDirectory(directory), maxSegments(max((size_t)2, min(segments, (size_t)TELEMETRY_SEGMENTS_MAX))) {}
+
+// CWD-- find the segments that survived the last reset, then the tail from the ack and the head from the newest
+// record. Segments the ack says were fully drained are unlinked now
+bool TelemetryQueue::begin() {
+#if HAL_PLATFORM_FILESYSTEM
+    char path[TELEMETRY_PATH_MAX];
+    for (const char *slash = strchr(strDirectory + 1, '/');; slash = strchr(slash + 1, '/')) {
+        snprintf(path, sizeof(path), "%.*s", (int)(slash ? slash - strDirectory : strlen(strDirectory)), strDirectory);
+        if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+            Log.error("Telemetry queue: can't create %s (%d)", path, errno);
+            return false;
+        }
+        if (!slash) {
+            break;
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", strDirectory, TELEMETRY_ACK_NAME);
+    TelemetryAck ack;
+    int ackFd = open(path, O_RDONLY);
+    if (ackFd >= 0) {
+        if (read(ackFd, &ack, sizeof(ack)) == sizeof(ack) && ack.magic == TELEMETRY_MAGIC && ack.crc == crc32(0, &ack, offsetof(TelemetryAck, crc))) {
+            ulAcked = ack.sequence;
+        }
+        close(ackFd);
+    }
+
+    DIR *dir = opendir(strDirectory);
+    if (!dir) {
+        Log.error("Telemetry queue: can't open %s (%d)", strDirectory, errno);
+        return false;
+    }
+
+    // CWD-- segment names are 8 hex digits; keep them sorted oldest first, and only the newest that fit
+    segmentCount = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        char *end;
+        uint32_t number = strtoul(entry->d_name, &end, 16);
+        if (strlen(entry->d_name) != 8 || *end) {
+            continue;
+        }
+
+        if (segmentCount == maxSegments) {
+            uint32_t dropped = min(number, segments[0].number);
+            snprintf(path, sizeof(path), "%s/%08lx", strDirectory, (unsigned long)dropped);
+            unlink(path);
+            if (dropped == number) {
+                continue;
+            }
+            memmove(segments, segments + 1, --segmentCount * sizeof(TelemetrySegment));
+        }
+
+        size_t ii = segmentCount++;
+        for (; ii > 0 && segments[ii - 1].number > number; ii--) {
+            segments[ii] = segments[ii - 1];
+        }
+        segments[ii].number = number;
+    }
+    closedir(dir);
+
+    bool blnTorn = false;
+    bool blnAppendable = false;
+    for (size_t ii = 0; ii < segmentCount;) {
+        if (!scanSegment(segments[ii], blnTorn) || segments[ii].records == 0) {
+            snprintf(path, sizeof(path), "%s/%08lx", strDirectory, (unsigned long)segments[ii].number);
+            unlink(path);
+            memmove(segments + ii, segments + ii + 1, (segmentCount - ii - 1) * sizeof(TelemetrySegment));
+            segmentCount--;
+            continue;
+        }
+        if (blnTorn) {
+            ulCorrupt++;
+        }
+        blnAppendable = !blnTorn;
+        ii++;
+    }
+
+    if (segmentCount) {
+        TelemetrySegment &newest = segments[segmentCount - 1];
+        ulHead = newest.first + newest.records;
+    } else {
+        ulHead = ulAcked + 1;
+    }
+    if (ulAcked >= ulHead) {
+        ulAcked = ulHead - 1; // CWD-- the segments were replaced under an older ack
+    }
+
+    // CWD-- whole segments the ack covers are skipped by their first sequence, the rest record by record
+    tail.segment = 0;
+    tail.offset = 0;
+    tail.sequence = segmentCount ? segments[0].first : ulHead;
+    while (tail.segment + 1 < segmentCount && segments[tail.segment + 1].first <= ulAcked + 1) {
+        tail.segment++;
+        tail.sequence = segments[tail.segment].first;
+    }
+    TelemetryRecordHeader header;
+    while (tail.sequence <= ulAcked) {
+        TelemetryCursor next = tail;
+        if (readNext(next, header) == READ_END) {
+            break;
+        }
+        tail = next;
+    }
+    settleTail();
+
+    // CWD-- keep appending to the newest segment unless its last write was torn
+    if (segmentCount && blnAppendable) {
+        writeFd = openSegment(segments[segmentCount - 1].number, O_WRONLY | O_APPEND);
+    }
+
+    blnReady = true;
+    Log.info("Telemetry queue %s: %u pending in %u segments, %lu corrupt", strDirectory, size(), segmentCount, (unsigned long)ulCorrupt);
+    return true;
+#else
+    Log.warn("Telemetry queue: no flash filesystem on this platform, offline records are dropped");
+    return false;
+#endif
+}
+
+bool TelemetryQueue::isReady() { return blnReady; }
+
+// CWD-- append a record to the newest segment, starting a new one when it's full. Past the segment limit the
+// oldest segment is dropped, undelivered records and all
+bool TelemetryQueue::push(const char *event, const char *data, uint8_t flags, uint32_t time) {
+#if HAL_PLATFORM_FILESYSTEM
+    if (!blnReady) {
+        return false;
+    }
+
+    size_t eventLength = strlen(event);
+    size_t dataLength = strlen(data);
+    if (eventLength >= TELEMETRY_EVENT_MAX || dataLength > TELEMETRY_DATA_MAX) {
+        Log.error("Telemetry queue: %s record too large (%u bytes)", event, (unsigned)dataLength);
+        return false;
+    }
+
+    size_t length = sizeof(TelemetryRecordHeader) + eventLength + dataLength;
+    if ((writeFd < 0 || segments[segmentCount - 1].bytes + length > TELEMETRY_SEGMENT_SIZE) && !startSegment()) {
+        return false;
+    }
+    TelemetrySegment &segment = segments[segmentCount - 1];
+
+    TelemetryRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TELEMETRY_MAGIC;
+    header.sequence = ulHead;
+    header.time = time;
+    header.dataLength = dataLength;
+    header.eventLength = eventLength;
+    header.flags = flags;
+    memcpy(payload, event, eventLength);
+    memcpy(payload + eventLength, data, dataLength);
+    header.crc = recordCrc(header, payload);
+    memcpy(record, &header, sizeof(header));
+
+    // CWD-- don't leave a reader's cached view of the file behind the append
+    if (readFd >= 0 && ulReadSegment == segment.number) {
+        close(readFd);
+        readFd = -1;
+    }
+
+    // CWD-- header and payload in one write so the record is either whole or ends the segment torn
+    if (write(writeFd, record, length) != (ssize_t)length) {
+        Log.error("Telemetry queue: write failed (%d)", errno);
+        close(writeFd);
+        writeFd = -1;
+        return false;
+    }
+    fsync(writeFd);
+
+    if (segment.records == 0) {
+        segment.first = ulHead;
+    }
+    segment.records++;
+    segment.bytes += length;
+    ulHead++;
+    return true;
+#else
+    return false;
+#endif
+}
+
+// CWD-- oldest undelivered record. If only corrupt records are left they're dropped for good
+bool TelemetryQueue::peek(char *event, size_t eventLen, char *data, size_t dataLen, uint8_t &flags, uint32_t &time) {
+    if (peekAt(0, event, eventLen, data, dataLen, flags, time)) {
+        return true;
+    }
+    if (blnScanValid && scanIndex == 0 && ulScanCorrupt) {
+        pop(0);
+    }
+    return false;
+}
+
+// CWD-- the index'th valid record behind the tail, for packing several into one publish. Corrupt records are
+// skipped the same way pop() skips them, so popping index + 1 records removes exactly what was peeked
+bool TelemetryQueue::peekAt(size_t index, char *event, size_t eventLen, char *data, size_t dataLen, uint8_t &flags, uint32_t &time) {
+    if (!blnScanValid || index < scanIndex) {
+        scan = tail;
+        scanIndex = 0;
+        ulScanCorrupt = 0;
+        blnScanValid = true;
+    }
+
+    TelemetryRecordHeader header;
+    for (;;) {
+        TelemetryCursor before = scan;
+        ReadResult result = readNext(scan, header);
+        if (result == READ_END) {
+            return false;
+        }
+        if (result == READ_CORRUPT) {
+            ulScanCorrupt++;
+            continue;
+        }
+        mark = before;
+        ulMarkCorrupt = ulScanCorrupt;
+        if (scanIndex++ == index) {
+            break;
+        }
+    }
+
+    if (header.eventLength >= eventLen || header.dataLength >= dataLen) {
+        return false;
+    }
+    memcpy(event, payload, header.eventLength);
+    event[header.eventLength] = 0;
+    memcpy(data, payload + header.eventLength, header.dataLength);
+    data[header.dataLength] = 0;
+    flags = header.flags;
+    time = header.time;
+    return true;
+}
+
+// CWD-- drop count valid records, and any corrupt ones in front of them. After peekAt(count - 1) the scan
+// cursor is already there, and after peekAt(count) it's one record back (packing stops on the record that
+// didn't fit); otherwise the records are walked again
+void TelemetryQueue::pop(size_t count) {
+    if (blnScanValid && scanIndex == count + 1) {
+        scan = mark;
+        ulScanCorrupt = ulMarkCorrupt;
+        scanIndex = count;
+    }
+    if (!blnScanValid || scanIndex != count) {
+        scan = tail;
+        scanIndex = 0;
+        ulScanCorrupt = 0;
+        TelemetryRecordHeader header;
+        while (scanIndex < count) {
+            ReadResult result = readNext(scan, header);
+            if (result == READ_END) {
+                break;
+            }
+            if (result == READ_CORRUPT) {
+                ulScanCorrupt++;
+            } else {
+                scanIndex++;
+            }
+        }
+    }
+
+    if (scan.sequence == tail.sequence && scan.segment == tail.segment) {
+        return;
+    }
+
+    tail = scan;
+    ulCorrupt += ulScanCorrupt;
+    blnScanValid = false;
+    settleTail();
+
+    if (tail.sequence - 1 - ulAcked >= TELEMETRY_ACK_BATCH || isEmpty()) {
+        saveAck();
+    }
+}
+
+size_t TelemetryQueue::size() { return ulHead - tail.sequence; }
+
+bool TelemetryQueue::isEmpty() { return ulHead == tail.sequence; }
+
+size_t TelemetryQueue::getSegments() { return segmentCount; }
+
+uint32_t TelemetryQueue::getOverwritten() { return ulOverwritten; }
+
+uint32_t TelemetryQueue::getCorrupt() { return ulCorrupt; }
+
+// CWD-- reads the record at the cursor into header and payload and moves the cursor past it, on to the next
+// segment at the end of one
+TelemetryQueue::ReadResult TelemetryQueue::readNext(TelemetryCursor &cursor, TelemetryRecordHeader &header) {
+#if HAL_PLATFORM_FILESYSTEM
+    while (cursor.segment < segmentCount) {
+        TelemetrySegment &segment = segments[cursor.segment];
+        if (cursor.offset >= segment.bytes) {
+            if (cursor.segment + 1 >= segmentCount) {
+                return READ_END;
+            }
+            cursor.segment++;
+            cursor.offset = 0;
+            cursor.sequence = segments[cursor.segment].first;
+            continue;
+        }
+
+        if (readFd < 0 || ulReadSegment != segment.number) {
+            if (readFd >= 0) {
+                close(readFd);
+            }
+            readFd = openSegment(segment.number, O_RDONLY);
+            ulReadSegment = segment.number;
+        }
+
+        size_t length = 0;
+        bool blnFramed = readFd >= 0 && lseek(readFd, cursor.offset, SEEK_SET) >= 0 && read(readFd, &header, sizeof(header)) == sizeof(header) &&
+                         header.magic == TELEMETRY_MAGIC && header.sequence == cursor.sequence && header.eventLength < TELEMETRY_EVENT_MAX &&
+                         header.dataLength <= TELEMETRY_DATA_MAX;
+        if (blnFramed) {
+            length = header.eventLength + header.dataLength;
+            blnFramed = read(readFd, payload, length) == (ssize_t)length;
+        }
+        if (!blnFramed) {
+            // CWD-- the boot scan checked the framing, so the flash changed since; give up on the rest of the segment
+            cursor.offset = segment.bytes;
+            cursor.sequence = segment.first + segment.records;
+            return READ_CORRUPT;
+        }
+
+        cursor.offset += sizeof(header) + length;
+        cursor.sequence++;
+        return header.crc == recordCrc(header, payload) ? READ_OK : READ_CORRUPT;
+    }
+#endif
+    return READ_END;
+}
+
+// CWD-- walk the record headers to find the first sequence and where the well-framed records end. blnTorn is
+// set when there's anything after that, i.e. the last append didn't finish
+bool TelemetryQueue::scanSegment(TelemetrySegment &segment, bool &blnTorn) {
+#if HAL_PLATFORM_FILESYSTEM
+    int fd = openSegment(segment.number, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+
+    segment.first = 0;
+    segment.records = 0;
+    segment.bytes = 0;
+    TelemetryRecordHeader header;
+    while (lseek(fd, segment.bytes, SEEK_SET) >= 0 && read(fd, &header, sizeof(header)) == sizeof(header)) {
+        if (header.magic != TELEMETRY_MAGIC || header.eventLength >= TELEMETRY_EVENT_MAX || header.dataLength > TELEMETRY_DATA_MAX ||
+            (segment.records && header.sequence != segment.first + segment.records)) {
+            break;
+        }
+        off_t end = segment.bytes + sizeof(header) + header.eventLength + header.dataLength;
+        if (end > fileSize) {
+            break;
+        }
+        if (segment.records == 0) {
+            segment.first = header.sequence;
+        }
+        segment.records++;
+        segment.bytes = end;
+    }
+    close(fd);
+
+    blnTorn = segment.bytes != fileSize;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TelemetryQueue::startSegment() {
+#if HAL_PLATFORM_FILESYSTEM
+    if (writeFd >= 0) {
+        close(writeFd);
+        writeFd = -1;
+    }
+    if (segmentCount == maxSegments) {
+        dropSegment();
+    }
+
+    uint32_t number = segmentCount ? segments[segmentCount - 1].number + 1 : 0;
+    writeFd = openSegment(number, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND);
+    if (writeFd < 0) {
+        Log.error("Telemetry queue: can't create segment %lu (%d)", (unsigned long)number, errno);
+        return false;
+    }
+
+    TelemetrySegment &segment = segments[segmentCount++];
+    segment.number = number;
+    segment.first = ulHead;
+    segment.records = 0;
+    segment.bytes = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+// CWD-- unlink the oldest segment. If the tail was still in it, the records it hadn't reached are lost
+void TelemetryQueue::dropSegment() {
+#if HAL_PLATFORM_FILESYSTEM
+    TelemetrySegment &oldest = segments[0];
+    if (tail.segment == 0) {
+        ulOverwritten += oldest.first + oldest.records - tail.sequence;
+        tail.offset = 0;
+        tail.sequence = segmentCount > 1 ? segments[1].first : ulHead;
+    } else {
+        tail.segment--;
+    }
+
+    if (readFd >= 0 && ulReadSegment == oldest.number) {
+        close(readFd);
+        readFd = -1;
+    }
+    char path[TELEMETRY_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%08lx", strDirectory, (unsigned long)oldest.number);
+    unlink(path);
+
+    memmove(segments, segments + 1, (segmentCount - 1) * sizeof(TelemetrySegment));
+    segmentCount--;
+    blnScanValid = false;
+#endif
+}
+
+// CWD-- step the tail over the ends of drained segments, then unlink every segment it has left behind. The
+// newest segment stays, it's still being appended to
+void TelemetryQueue::settleTail() {
+    while (tail.segment + 1 < segmentCount && tail.offset >= segments[tail.segment].bytes) {
+        tail.segment++;
+        tail.offset = 0;
+        tail.sequence = segments[tail.segment].first;
+    }
+    while (tail.segment > 0) {
+        dropSegment();
+    }
+}
+
+void TelemetryQueue::saveAck() {
+#if HAL_PLATFORM_FILESYSTEM
+    TelemetryAck ack;
+    ack.magic = TELEMETRY_MAGIC;
+    ack.sequence = tail.sequence - 1;
+    ack.crc = crc32(0, &ack, offsetof(TelemetryAck, crc));
+
+    // CWD-- written aside and renamed over the old one, so a reset mid-write leaves the previous ack rather than
+    // a truncated file that resends the whole queue
+    char tempPath[TELEMETRY_PATH_MAX];
+    char path[TELEMETRY_PATH_MAX];
+    snprintf(tempPath, sizeof(tempPath), "%s/%s", strDirectory, TELEMETRY_ACK_TEMP_NAME);
+    snprintf(path, sizeof(path), "%s/%s", strDirectory, TELEMETRY_ACK_NAME);
+    int ackFd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (ackFd < 0) {
+        Log.error("Telemetry queue: can't write %s (%d)", tempPath, errno);
+        return;
+    }
+    bool blnWritten = write(ackFd, &ack, sizeof(ack)) == sizeof(ack);
+    if (close(ackFd) < 0) {
+        blnWritten = false;
+    }
+    if (!blnWritten || rename(tempPath, path) < 0) {
+        Log.error("Telemetry queue: can't save ack (%d)", errno);
+        unlink(tempPath);
+        return;
+    }
+    ulAcked = ack.sequence; // CWD-- only once it's on flash; until then the next pop tries again
+#endif
+}
+
+int TelemetryQueue::openSegment(uint32_t number, int flags) {
+#if HAL_PLATFORM_FILESYSTEM
+    char path[TELEMETRY_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%08lx", strDirectory, (unsigned long)number);
+    return open(path, flags, 0644);
+#else
+    return -1;
+#endif
+}
+
+// CWD-- standard CRC-32 (IEEE), bitwise: records are small and this runs a few times a second at most
+uint32_t TelemetryQueue::crc32(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t TelemetryQueue::recordCrc(const TelemetryRecordHeader &header, const char *payload) {
+    uint32_t crc = crc32(0, &header, offsetof(TelemetryRecordHeader, crc));
+    return crc32(crc, payload, header.eventLength + header.dataLength);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#ifndef __TelemetryQueue_h
+#define __TelemetryQueue_h
+
+#include "Particle.h"
+
+#ifndef TELEMETRY_QUEUE_DIR
+#define TELEMETRY_QUEUE_DIR "/usr/telemetry" // one subdirectory of segment files per queue
+#endif
+#define TELEMETRY_SEGMENT_SIZE 8192          // records are appended to a segment until the next one wouldn't fit
+#define TELEMETRY_SEGMENTS_MAX 16            // most segments one queue keeps; past that the oldest is dropped
+#define TELEMETRY_EVENT_MAX 32               // event name, with its null
+#define TELEMETRY_DATA_MAX 1024              // largest cloud event payload on current Device OS
+#define TELEMETRY_ACK_BATCH 8                // persist drain progress every few records rather than every one
+#define TELEMETRY_FLAG_URGENT 0x01
+
+// CWD-- header in front of every record. The CRC covers the header fields before it plus the payload
+struct TelemetryRecordHeader {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t time;       // unix seconds when queued, 0 if the clock wasn't set
+    uint16_t dataLength; // without the null
+    uint8_t eventLength; // without the null
+    uint8_t flags;
+    uint32_t crc;
+};
+
+// CWD-- a run of records appended to one file, named after its number
+struct TelemetrySegment {
+    uint32_t number;
+    uint32_t first;   // sequence of its first record
+    uint32_t records; // well-framed records, including any that fail their CRC
+    uint32_t bytes;   // length of those records; anything past it was torn
+};
+
+// CWD-- position of the next record to read
+struct TelemetryCursor {
+    size_t segment; // index into the segment list, oldest first
+    uint32_t offset;
+    uint32_t sequence;
+};
+
+// CWD-- persistent store-and-forward FIFO for cloud events, kept as a directory of append-only segment files.
+// LittleFS stores a file as a skip-list of blocks, so rewriting in place costs every block to the end of the
+// file; here records are only ever appended, and a segment is unlinked whole once it's drained (or, when the
+// queue is full, dropped with whatever it still held). Head and tail are rebuilt at boot from the segment names
+// and the sequence numbers in the record headers. A torn append ends its segment and the next push starts a new
+// one; a record that fails its CRC is skipped. Drain progress is saved in batches to a small ack file, which
+// LittleFS keeps inline in the directory entry, so a reset can resend a few records: delivery is at-least-once
+class TelemetryQueue {
+  public:
+    TelemetryQueue(const char *directory, size_t segments);
+
+    bool begin();
+
+    bool push(const char *event, const char *data, uint8_t flags, uint32_t time);
+    bool peek(char *event, size_t eventLen, char *data, size_t dataLen, uint8_t &flags, uint32_t &time);
+    bool peekAt(size_t index, char *event, size_t eventLen, char *data, size_t dataLen, uint8_t &flags, uint32_t &time);
+    void pop(size_t count = 1);
+
+    size_t size();
+    bool isEmpty();
+    bool isReady();
+    size_t getSegments();
+    uint32_t getOverwritten();
+    uint32_t getCorrupt();
+
+  private:
+    enum ReadResult { READ_OK, READ_CORRUPT, READ_END };
+
+    ReadResult readNext(TelemetryCursor &cursor, TelemetryRecordHeader &header);
+    bool scanSegment(TelemetrySegment &segment, bool &blnTorn);
+    bool startSegment();
+    void dropSegment();
+    void settleTail();
+    void saveAck();
+    int openSegment(uint32_t number, int flags);
+    static uint32_t crc32(uint32_t crc, const void *data, size_t len);
+    static uint32_t recordCrc(const TelemetryRecordHeader &header, const char *payload);
+
+    const char *strDirectory;
+    size_t maxSegments;
+    TelemetrySegment segments[TELEMETRY_SEGMENTS_MAX];
+    size_t segmentCount = 0;
+    bool blnReady = false;
+    int writeFd = -1; // open on the newest segment while it can take appends
+    int readFd = -1;
+    uint32_t ulReadSegment = 0;
+
+    TelemetryCursor tail = {0, 0, 1};
+    TelemetryCursor scan = {0, 0, 1}; // where the last peekAt() stopped, so packing reads each record once
+    size_t scanIndex = 0;             // valid records between the tail and the scan cursor
+    uint32_t ulScanCorrupt = 0;       // and corrupt ones
+    TelemetryCursor mark = {0, 0, 1}; // the scan just before the last record it read, which pop() can stop at
+    uint32_t ulMarkCorrupt = 0;
+    bool blnScanValid = false;
+
+    uint32_t ulHead = 1; // sequence the next push gets
+    uint32_t ulAcked = 0;
+    uint32_t ulOverwritten = 0;
+    uint32_t ulCorrupt = 0;
+};
+
+#endif // def(__TelemetryQueue_h)
@@ -0,0 +1,127 @@
+#include "TimeBase.h"
+#include "Particle.h"
+
+TimeBase timeBase;
+
+volatile uint32_t TimeBase::ulPPSMicros = 0;
+volatile bool TimeBase::blnPPSSeen = false;
+
+TimeBase::TimeBase() {}
+
+uint64_t TimeBase::now() {
+    uint32_t us = micros();
+
+    if (us < ulLastMicros) { // CWD-- micros() wrapped
+        ulHigh++;
+    }
+
+    ulLastMicros = us;
+    return ((uint64_t)ulHigh << 32) | us;
+}
+
+void TimeBase::attachPPS(int pin) {
+    pinMode(pin, INPUT);
+    attachInterrupt(pin, ppsISR, RISING);
+}
+
+void TimeBase::ppsISR() {
+    ulPPSMicros = micros();
+    blnPPSSeen = true;
+}
+
+// CWD-- called with the UTC time of a freshly parsed NMEA sentence. With a recent PPS edge the second boundary
+// is known to the microsecond; without one the sentence arrival time is used and slewed in gradually
+void TimeBase::discipline(uint32_t unixSeconds, uint8_t centiseconds) {
+    uint64_t mono = now();
+    int64_t utc = (int64_t)unixSeconds * 1000000 + (int64_t)centiseconds * 10000;
+    uint32_t sincePPS = micros() - ulPPSMicros;
+
+    if (blnPPSSeen && sincePPS < TIMEBASE_PPS_MAX_AGE_US) {
+        llOffset = (int64_t)unixSeconds * 1000000 - (int64_t)(mono - sincePPS);
+        blnPPSLocked = true;
+    } else {
+        int64_t measured = utc + TIMEBASE_NMEA_LATENCY_US - (int64_t)mono;
+        int64_t error = measured - llOffset;
+
+        if (!blnDisciplined || error > TIMEBASE_STEP_THRESHOLD_US || error < -TIMEBASE_STEP_THRESHOLD_US) {
+            llOffset = measured;
+        } else {
+            llOffset += error / (1 << TIMEBASE_SLEW_SHIFT);
+        }
+
+        blnPPSLocked = false;
+    }
+
+    blnDisciplined = true;
+
+    // CWD-- keep the system clock honest while offline; cellular sync only happens when connected
+    uint32_t seconds = (uint32_t)(unixMicros() / 1000000);
+
+    if (!Time.isValid() || (int32_t)(Time.now() - seconds) > TIMEBASE_CLOCK_SET_DRIFT || (int32_t)(seconds - Time.now()) > TIMEBASE_CLOCK_SET_DRIFT) {
+        Time.setTime(seconds);
+    }
+}
+
+bool TimeBase::isDisciplined() { return blnDisciplined; }
+
+bool TimeBase::isPPSLocked() { return blnPPSLocked; }
+
+uint64_t TimeBase::toUnixMicros(uint64_t monotonic) { return blnDisciplined ? (uint64_t)((int64_t)monotonic + llOffset) : 0; }
+
+uint64_t TimeBase::unixMicros() { return toUnixMicros(now()); }
+
+// CWD-- wall time of an earlier millis() stamp. Falls back to the cloud-synced clock before the first GPS time,
+// 0 when neither is known
+uint64_t TimeBase::unixMillis(unsigned long uptimeMs) {
+    uint32_t age = millis() - uptimeMs;
+
+    if (blnDisciplined) {
+        return toUnixMicros(now() - (uint64_t)age * 1000) / 1000;
+    }
+
+    return Time.isValid() ? (uint64_t)Time.now() * 1000 - age : 0;
+}
+
+// CWD-- unix milliseconds as a decimal string, without 64-bit printf support
+int TimeBase::formatMillis(uint64_t unixMicros, char *buf, size_t len) {
+    uint64_t ms = unixMicros / 1000;
+    if (ms < 1000)
+        return snprintf(buf, len, "%lu", (unsigned long)ms);
+    return snprintf(buf, len, "%lu%03lu", (unsigned long)(ms / 1000), (unsigned long)(ms % 1000));
+}
+
+// CWD-- days-from-civil (proleptic Gregorian), no timegm() needed
+uint32_t TimeBase::unixTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+    int32_t y = (int32_t)year - (month <= 2);
+    int32_t era = y / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int32_t days = era * 146097 + (int32_t)doe - 719468;
+    return (uint32_t)days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// CWD-- civil-from-days, the inverse of unixTime() for the date part
+void TimeBase::civilDate(uint32_t unixSeconds, uint16_t &year, uint8_t &month, uint8_t &day) {
+    int32_t days = (int32_t)(unixSeconds / 86400) + 719468;
+    int32_t era = days / 146097;
+    uint32_t doe = (uint32_t)(days - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+    year = (uint16_t)((int32_t)yoe + era * 400 + (month <= 2));
+}
+
+int TimeBase::formatDate(uint32_t unixSeconds, char *buf, size_t len) {
+    uint16_t year;
+    uint8_t month, day;
+    civilDate(unixSeconds, year, month, day);
+    return snprintf(buf, len, "%04u/%02u/%02u", year, month, day);
+}
+
+int TimeBase::formatTime(uint32_t unixSeconds, char *buf, size_t len) {
+    uint32_t s = unixSeconds % 86400;
+    return snprintf(buf, len, "%02lu:%02lu:%02lu", (unsigned long)(s / 3600), (unsigned long)(s / 60 % 60), (unsigned long)(s % 60));
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef __TimeBase_h
+#define __TimeBase_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMEBASE_NMEA_LATENCY_US 0         // receiver specific delay from the epoch to the end of its sentence
+#define TIMEBASE_STEP_THRESHOLD_US 1000000 // errors beyond this step the clock, smaller ones are slewed in
+#define TIMEBASE_SLEW_SHIFT 3              // without PPS, take 1/8th of each NMEA error to smooth out jitter
+#define TIMEBASE_PPS_MAX_AGE_US 900000     // a PPS edge older than this can't belong to the current sentence
+#define TIMEBASE_CLOCK_SET_DRIFT 2         // re-set the system clock when it's this many seconds off
+
+// CWD-- monotonic 64-bit microsecond clock shared by CAN frames, GPS fixes and publish records, extended from
+// the 32-bit micros() so it never wraps. GPS UTC (and PPS when wired) disciplines an offset to wall time,
+// so records stay correlated even when the cloud time sync isn't available.
+// now() must be called from the application thread at least once per micros() wrap (~71 minutes)
+class TimeBase {
+  public:
+    TimeBase();
+
+    uint64_t now();
+    void attachPPS(int pin);
+    void discipline(uint32_t unixSeconds, uint8_t centiseconds);
+
+    bool isDisciplined();
+    bool isPPSLocked();
+    uint64_t toUnixMicros(uint64_t monotonic);
+    uint64_t unixMicros();
+    uint64_t unixMillis(unsigned long uptimeMs);
+
+    static int formatMillis(uint64_t unixMicros, char *buf, size_t len);
+    static uint32_t unixTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second);
+    static void civilDate(uint32_t unixSeconds, uint16_t &year, uint8_t &month, uint8_t &day);
+    static int formatDate(uint32_t unixSeconds, char *buf, size_t len); // YYYY/MM/DD
+    static int formatTime(uint32_t unixSeconds, char *buf, size_t len); // HH:MM:SS
+
+  private:
+    static void ppsISR();
+    static volatile uint32_t ulPPSMicros;
+    static volatile bool blnPPSSeen;
+
+    uint32_t ulLastMicros = 0;
+    uint32_t ulHigh = 0;
+    bool blnDisciplined = false;
+    bool blnPPSLocked = false;
+    int64_t llOffset = 0; // unix micros - monotonic micros
+};
+
+extern TimeBase timeBase;
+
+#endif // def(__TimeBase_h)
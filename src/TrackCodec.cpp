@@ -0,0 +1,173 @@
+#include "TrackCodec.h"
+#include "TelemetryCodec.h"
+
+#include <string.h>
+
+void TrackEncoder::begin(uint8_t *buf, size_t capacity) {
+    this->buf = buf;
+    this->capacity = capacity;
+    len = 0;
+    count = 0;
+    groupStart = 0;
+    if (capacity > 0) {
+        buf[len++] = TelemetryCodec::header(TELEMETRY_RECORD_TRACK);
+    }
+}
+
+// CWD-- false when the point doesn't fit; the stream up to the previous point is still complete
+bool TrackEncoder::add(int32_t lat, int32_t lon, uint64_t time) {
+    uint64_t fields[3];
+    bool blnKey = count % TRACK_KEYFRAME_INTERVAL == 0;
+    int64_t timeDelta = (int64_t)(time - ullTime);
+
+    if (blnKey) {
+        fields[0] = (time << 1) | 1;
+        fields[1] = TelemetryCodec::zigzag(lat);
+        fields[2] = TelemetryCodec::zigzag(lon);
+    } else {
+        fields[0] = TelemetryCodec::zigzag(timeDelta - llTimeDelta) << 1;
+        fields[1] = TelemetryCodec::zigzag((int64_t)lat - iLat);
+        fields[2] = TelemetryCodec::zigzag((int64_t)lon - iLon);
+    }
+
+    uint8_t point[TRACK_POINT_MAX];
+    size_t pointLen = 0;
+    for (uint64_t field : fields) {
+        pointLen += TelemetryCodec::putVarint(field, point + pointLen, sizeof(point) - pointLen);
+    }
+
+    // CWD-- a point joining the current group takes the place of its CRC, and a new CRC goes after it
+    size_t n = blnKey ? len : len - TRACK_CRC_SIZE;
+    if (len == 0 || n + pointLen + TRACK_CRC_SIZE > capacity) {
+        return false;
+    }
+    if (blnKey) {
+        groupStart = n;
+    }
+    memcpy(buf + n, point, pointLen);
+    n += pointLen;
+    uint16_t crc = TelemetryCodec::crc16(buf + groupStart, n - groupStart);
+    buf[n++] = crc & 0xFF;
+    buf[n++] = crc >> 8;
+
+    len = n;
+    llTimeDelta = blnKey ? 0 : timeDelta;
+    iLat = lat;
+    iLon = lon;
+    ullTime = time;
+    count++;
+    return true;
+}
+
+size_t TrackEncoder::getLength() { return len; }
+
+size_t TrackEncoder::getCount() { return count; }
+
+bool TrackDecoder::begin(const uint8_t *buf, size_t len) {
+    this->buf = buf;
+    this->len = len;
+    pos = 1;
+    failedAt = 0;
+    ulDropped = 0;
+    groupSize = 0;
+    groupNext = 0;
+    return TelemetryCodec::recordType(buf, len) == TELEMETRY_RECORD_TRACK && TelemetryCodec::recordVersion(buf, len) == TELEMETRY_CODEC_VERSION;
+}
+
+// CWD-- false at the end of the stream. A group that fails its CRC is dropped and decoding carries on after
+// it. If what follows doesn't even parse, the damage moved the framing: the decoder goes back to the first
+// failed group and hunts forward from there for the next group that checks out, so damage costs only the
+// groups it touches
+bool TrackDecoder::next(int32_t &lat, int32_t &lon, uint64_t &time) {
+    while (groupNext >= groupSize) {
+        if (pos >= len) {
+            return false;
+        }
+        size_t start = pos;
+        if (readGroup()) {
+            failedAt = 0;
+        } else if (pos != start) {
+            ulDropped++;
+            failedAt = failedAt ? failedAt : start;
+        } else {
+            ulDropped += failedAt == 0;
+            pos = failedAt ? failedAt : start;
+            failedAt = 0;
+            if (!resync()) {
+                return false;
+            }
+        }
+    }
+
+    lat = groupLat[groupNext];
+    lon = groupLon[groupNext];
+    time = groupTime[groupNext];
+    groupNext++;
+    return true;
+}
+
+uint32_t TrackDecoder::getDroppedGroups() { return ulDropped; }
+
+// CWD-- decode the group at pos into the group arrays and check its CRC, moving pos past it if it parsed at all.
+// The stream always ends in a CRC, so points are only read up to that
+bool TrackDecoder::readGroup() {
+    size_t n = pos, used;
+    int32_t lat = 0, lon = 0;
+    uint64_t time = 0;
+    int64_t timeDelta = 0;
+    groupSize = 0;
+    groupNext = 0;
+
+    while (groupSize < TRACK_KEYFRAME_INTERVAL && n + TRACK_CRC_SIZE < len) {
+        uint64_t fields[3];
+        for (uint64_t &field : fields) {
+            if ((used = TelemetryCodec::getVarint(buf + n, len - TRACK_CRC_SIZE - n, field)) == 0) {
+                groupSize = 0;
+                return false;
+            }
+            n += used;
+        }
+
+        // CWD-- a keyframe leads the group and only there
+        if ((bool)(fields[0] & 1) != (groupSize == 0)) {
+            groupSize = 0;
+            return false;
+        }
+        if (fields[0] & 1) {
+            time = fields[0] >> 1;
+            lat = (int32_t)TelemetryCodec::unzigzag(fields[1]);
+            lon = (int32_t)TelemetryCodec::unzigzag(fields[2]);
+        } else {
+            timeDelta += TelemetryCodec::unzigzag(fields[0] >> 1);
+            time += timeDelta;
+            lat += (int32_t)TelemetryCodec::unzigzag(fields[1]);
+            lon += (int32_t)TelemetryCodec::unzigzag(fields[2]);
+        }
+        groupLat[groupSize] = lat;
+        groupLon[groupSize] = lon;
+        groupTime[groupSize] = time;
+        groupSize++;
+    }
+
+    if (groupSize == 0 || n + TRACK_CRC_SIZE > len) {
+        groupSize = 0;
+        return false;
+    }
+    uint16_t crc = TelemetryCodec::crc16(buf + pos, n - pos);
+    pos = n + TRACK_CRC_SIZE;
+    if (buf[n] != (crc & 0xFF) || buf[n + 1] != (crc >> 8)) {
+        groupSize = 0;
+        return false;
+    }
+    return true;
+}
+
+// CWD-- step to the next byte that could start a keyframe tag. The CRC sorts out the false starts
+bool TrackDecoder::resync() {
+    while (++pos < len) {
+        if (buf[pos] & 1) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef __TrackCodec_h
+#define __TrackCodec_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACK_KEYFRAME_INTERVAL 16 // points per group: a full keyframe, then deltas from it, then the group's CRC
+#define TRACK_POINT_MAX 30         // largest encoded point, three maximal varints
+#define TRACK_CRC_SIZE 2
+
+// CWD-- Gorilla-style delta stream for successive fixes, in TelemetryCodec's varints rather than a bit stream.
+// After the record header the points come in groups of up to TRACK_KEYFRAME_INTERVAL. Each point is a tag
+// varint, (value << 1) | keyframe, then two zigzag varints:
+//   keyframe  tag value = unix time (ms)   then lat, lon (1e-7 degrees)
+//   otherwise tag value = zigzag(delta of the time delta)   then lat and lon deltas from the previous point
+// and each group ends with a CRC-16 of its bytes, little endian, so a damaged group is dropped whole instead of
+// decoding into positions that drift off. Only the last group can be short; its CRC ends the stream.
+// Steady sampling makes the delta-of-delta ~0 and a few meters of movement is a couple of bytes per axis
+class TrackEncoder {
+  public:
+    void begin(uint8_t *buf, size_t capacity);
+    bool add(int32_t lat, int32_t lon, uint64_t time);
+
+    size_t getLength();
+    size_t getCount();
+
+  private:
+    uint8_t *buf = nullptr;
+    size_t capacity = 0;
+    size_t len = 0;
+    size_t count = 0;
+    size_t groupStart = 0; // where the current group's keyframe begins
+
+    int32_t iLat = 0;
+    int32_t iLon = 0;
+    uint64_t ullTime = 0;
+    int64_t llTimeDelta = 0;
+};
+
+class TrackDecoder {
+  public:
+    bool begin(const uint8_t *buf, size_t len);
+    bool next(int32_t &lat, int32_t &lon, uint64_t &time);
+
+    uint32_t getDroppedGroups();
+
+  private:
+    bool readGroup();
+    bool resync();
+
+    const uint8_t *buf = nullptr;
+    size_t len = 0;
+    size_t pos = 0;
+    size_t failedAt = 0; // start of the first group in a run that failed its CRC, 0 when the last one passed
+    uint32_t ulDropped = 0;
+
+    // CWD-- the group being handed out, already checked against its CRC
+    int32_t groupLat[TRACK_KEYFRAME_INTERVAL];
+    int32_t groupLon[TRACK_KEYFRAME_INTERVAL];
+    uint64_t groupTime[TRACK_KEYFRAME_INTERVAL];
+    size_t groupSize = 0;
+    size_t groupNext = 0;
+};
+
+#endif // def(__TrackCodec_h)
@@ -0,0 +1,117 @@
+#include "TrackSimplifier.h"
+#include <math.h>
+#include <string.h>
+
+TrackSimplifier::TrackSimplifier(float tolerance) : fTolerance(tolerance) {}
+
+void TrackSimplifier::add(const GeoPoint &point, unsigned long time) {
+    TrackPoint p;
+    p.point = point;
+    p.time = time;
+    ulPointsIn++;
+
+    if (!blnAnchorSet) {
+        keep(p);
+        return;
+    }
+
+    if (windowSize > 0) {
+        float error = windowError(p);
+
+        if (error > fTolerance || windowSize == TRACK_WINDOW_SIZE) { // the window can't stretch to p, close it at its last point
+            TrackPoint last = window[windowSize - 1];
+            windowSize--;
+            fMaxError = fmaxf(fMaxError, fWindowError);
+            keep(last);
+        } else {
+            fWindowError = error;
+        }
+    }
+
+    window[windowSize++] = p;
+}
+
+// CWD-- make the newest point part of the output, e.g. right before a batched upload
+void TrackSimplifier::flush() {
+    if (windowSize > 0) {
+        TrackPoint last = window[windowSize - 1];
+        windowSize--;
+        fMaxError = fmaxf(fMaxError, fWindowError);
+        keep(last);
+    }
+}
+
+void TrackSimplifier::setTolerance(float tolerance) { fTolerance = tolerance; }
+
+float TrackSimplifier::getTolerance() { return fTolerance; }
+
+const TrackPoint *TrackSimplifier::getTrack() { return track; }
+
+size_t TrackSimplifier::getTrackSize() { return trackSize; }
+
+bool TrackSimplifier::isTrackFull() { return trackSize == TRACK_BUFFER_SIZE; }
+
+// CWD-- drop the oldest count points once they've been uploaded
+void TrackSimplifier::consumeTrack(size_t count) {
+    if (count >= trackSize) {
+        trackSize = 0;
+        return;
+    }
+
+    memmove(track, track + count, (trackSize - count) * sizeof(TrackPoint));
+    trackSize -= count;
+}
+
+uint32_t TrackSimplifier::getPointsIn() { return ulPointsIn; }
+
+uint32_t TrackSimplifier::getPointsOut() { return ulPointsOut; }
+
+float TrackSimplifier::getCompressionRatio() { return ulPointsOut == 0 ? 0 : (float)ulPointsIn / ulPointsOut; }
+
+float TrackSimplifier::getMaxError() { return fMaxError; }
+
+// CWD-- the kept point becomes the new anchor and the window restarts empty. A full buffer drops its oldest
+// point rather than blocking the caller; it's up to the uploader to drain it in time
+void TrackSimplifier::keep(const TrackPoint &point) {
+    if (trackSize == TRACK_BUFFER_SIZE) {
+        memmove(track, track + 1, (TRACK_BUFFER_SIZE - 1) * sizeof(TrackPoint));
+        trackSize--;
+    }
+
+    track[trackSize++] = point;
+    ulPointsOut++;
+    anchor = point;
+    blnAnchorSet = true;
+    projection.setOrigin(point.point);
+    windowSize = 0;
+    fWindowError = 0;
+}
+
+// CWD-- worst cross-track distance of the windowed points from the anchor->end segment
+float TrackSimplifier::windowError(const TrackPoint &end) {
+    float bx, by;
+    projection.toLocal(end.point, bx, by);
+    float worst = 0;
+
+    for (size_t i = 0; i < windowSize; i++) {
+        float px, py;
+        projection.toLocal(window[i].point, px, py);
+        worst = fmaxf(worst, segmentDistance(px, py, bx, by));
+
+        if (worst > fTolerance) {
+            break;
+        }
+    }
+
+    return worst;
+}
+
+// CWD-- distance from p to the segment (0,0)->b, clamped to the segment ends
+float TrackSimplifier::segmentDistance(float px, float py, float bx, float by) {
+    float len2 = bx * bx + by * by;
+    float t = len2 > 0 ? (px * bx + py * by) / len2 : 0;
+    t = fminf(1.0f, fmaxf(0.0f, t));
+    float dx = px - t * bx;
+    float dy = py - t * by;
+    return sqrtf(dx * dx + dy * dy);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef __TrackSimplifier_h
+#define __TrackSimplifier_h
+
+#include "GeoPoint.h"
+#include "Geodesy.h"
+
+#define TRACK_TOLERANCE_M 10.0f // default max cross-track error for a dropped point
+#define TRACK_WINDOW_SIZE 32    // points held since the last kept one before one is forced out
+#define TRACK_BUFFER_SIZE 24    // kept points per batched upload (~35 bytes each as JSON)
+
+struct TrackPoint {
+    GeoPoint point;
+    unsigned long time = 0;
+};
+
+// CWD-- streaming opening-window simplifier. A point is dropped only while every point since the last kept one
+// stays within the tolerance of the straight line to the newest fix; straight highway collapses to its ends
+class TrackSimplifier {
+  public:
+    explicit TrackSimplifier(float tolerance = TRACK_TOLERANCE_M);
+
+    void add(const GeoPoint &point, unsigned long time);
+    void flush();
+
+    void setTolerance(float tolerance);
+    float getTolerance();
+
+    const TrackPoint *getTrack();
+    size_t getTrackSize();
+    bool isTrackFull();
+    void consumeTrack(size_t count);
+
+    // CWD-- stats since boot
+    uint32_t getPointsIn();
+    uint32_t getPointsOut();
+    float getCompressionRatio();
+    float getMaxError();
+
+  private:
+    void keep(const TrackPoint &point);
+    float windowError(const TrackPoint &end);
+    static float segmentDistance(float px, float py, float bx, float by);
+
+    float fTolerance;
+    bool blnAnchorSet = false;
+    TrackPoint anchor;
+    LocalProjection projection;
+
+    TrackPoint window[TRACK_WINDOW_SIZE];
+    size_t windowSize = 0;
+    float fWindowError = 0; // worst error of the points currently represented by the window's last segment
+
+    TrackPoint track[TRACK_BUFFER_SIZE];
+    size_t trackSize = 0;
+
+    uint32_t ulPointsIn = 0;
+    uint32_t ulPointsOut = 0;
+    float fMaxError = 0;
+};
+
+#endif // def(__TrackSimplifier_h)
@@ -0,0 +1,157 @@
+// CWD-- AT+CGED environment parsing fed from captured modem transcripts
+#include "CellularHelper.h"
+#include "TestHarness.h"
+
+#include <new>
+#include <stdlib.h>
+
+HostCellular Cellular;
+
+// CWD-- counts heap allocations so the in-place parser can be held to zero
+static size_t iAllocations = 0;
+
+void *operator new(size_t size) {
+    iAllocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// CWD-- SARA-U201 on a 3G cell, serving cell then neighbors
+static const char *const TRANSCRIPT_UMTS = "+CGED: RAT:\"UMTS\",\r\n"
+                                           "MCC:310, MNC:410, LAC:2b5c, CI:8a5a782, DLF:  4385, ULF:  4160, SC: 81, RSCP LEV: 27, ECN0 LEV: 33, RAC: 0\r\n"
+                                           "MCC:310, MNC:410, LAC:2b5c, CI:8a5a783, DLF:  4385, ULF:  4160, SC: 83, RSCP LEV: 18, ECN0 LEV: 21\r\n"
+                                           "MCC:310, MNC:410, LAC:2b5c, CI:8a61004, DLF:   612, ULF:   387, SC:210, RSCP LEV: 12, ECN0 LEV: 14\r\n"
+                                           "\r\n"
+                                           "OK\r\n";
+
+// CWD-- SARA-G350 on 2G with more neighbors than the caller has room for
+static const char *const TRANSCRIPT_GSM = "+CGED: MCC:310, MNC:260, LAC:a7d3, CI:4c12, BSIC:3f, Arfcn:00128, Arfcn_ded:00128, RxLevSub:41, t_adv:2\r\n"
+                                          "MCC:310, MNC:260, LAC:a7d3, CI:4c13, BSIC:3a, Arfcn:00130, RxLev:2c\r\n"
+                                          "MCC:310, MNC:260, LAC:a7d3, CI:4c21, BSIC:31, Arfcn:00661, RxLev:1e\r\n"
+                                          "MCC:310, MNC:260, LAC:a7d4, CI:5001, BSIC:12, Arfcn:00987, RxLev:19\r\n"
+                                          "MCC:310, MNC:260, LAC:a7d4, CI:5002, BSIC:13, Arfcn:00133, RxLev:10\r\n"
+                                          "MCC:310, MNC:260, LAC:a7d4, CI:5003, BSIC:14, Arfcn:00134, RxLev:0f\r\n"
+                                          "OK\r\n";
+
+// CWD-- noise the parser has to survive: an overlong pair, an unknown key, lines with no pairs, no neighbors
+static const char *const TRANSCRIPT_DAMAGED = "+CGED: RAT:\"GSM\",\r\n"
+                                              "MCC:310, MNC:260, LAC:a7d3, CI:4c12, Operator:0123456789012345678901234567890123, RxLev:22, Extra:1\r\n"
+                                              "garbage without pairs\r\n"
+                                              "MCC\r\n"
+                                              "OK\r\n";
+
+static void testUMTS() {
+    CellularHelperEnvironmentResponseStatic<4> resp;
+    Cellular.expect("AT+CGED=5\r\n", TRANSCRIPT_UMTS);
+    CellularHelper.getEnvironment(5, resp);
+
+    CHECK(resp.resp == RESP_OK);
+    CHECK(resp.service.isUMTS && resp.service.mcc == 310 && resp.service.mnc == 410);
+    CHECK(resp.service.lac == 0x2b5c && resp.service.ci == 0x8a5a782);
+    CHECK(resp.service.dlf == 4385 && resp.service.ulf == 4160 && resp.service.rscpLev == 27);
+    CHECK(resp.service.getRSSI() == -94);
+    CHECK(resp.getNumNeighbors() == 2);
+    CHECK(resp.neighbors[0].ci == 0x8a5a783 && resp.neighbors[1].ci == 0x8a61004);
+    CHECK(resp.neighbors[1].isUMTS && resp.neighbors[1].ulf == 387);
+    printf("umts: %s\n", resp.service.toString().c_str());
+}
+
+static void testGSMBounded() {
+    CellularHelperEnvironmentResponseStatic<3> resp;
+    Cellular.expect("AT+CGED=5\r\n", TRANSCRIPT_GSM);
+    CellularHelper.getEnvironment(5, resp);
+
+    CHECK(resp.resp == RESP_OK);
+    CHECK(!resp.service.isUMTS && resp.service.mcc == 310 && resp.service.mnc == 260);
+    CHECK(resp.service.lac == 0xa7d3 && resp.service.ci == 0x4c12 && resp.service.bsic == 0x3f && resp.service.arfcn == 128);
+    CHECK(resp.getNumNeighbors() == 3); // CWD-- the other two had nowhere to go, and didn't write past the array
+    CHECK(resp.neighbors[0].rxlev == 0x2c && resp.neighbors[2].lac == 0xa7d4 && resp.neighbors[2].arfcn == 987);
+    printf("gsm: %s\n", resp.service.toString().c_str());
+}
+
+static void testDamaged() {
+    CellularHelperEnvironmentResponseStatic<2> resp;
+    Cellular.expect("AT+CGED=5\r\n", TRANSCRIPT_DAMAGED);
+    CellularHelper.getEnvironment(5, resp);
+
+    CHECK(resp.resp == RESP_OK);
+    CHECK(resp.service.mcc == 310 && resp.service.ci == 0x4c12 && resp.service.rxlev == 0x22); // CWD-- pairs after the bad one still land
+    CHECK(resp.getNumNeighbors() == 0);
+
+    CellularHelperEnvironmentResponseStatic<2> failed;
+    Cellular.expect("AT+CGED=5\r\n", "+CME ERROR: operation not allowed\r\nERROR\r\n");
+    CellularHelper.getEnvironment(5, failed);
+    CHECK(failed.resp == RESP_ERROR && failed.getNumNeighbors() == 0);
+}
+
+// CWD-- the callback as the modem delivers a multi-line chunk, parsed without touching the heap
+static void testNoAllocation() {
+    static const char chunk[] = "\r\n+CGED: RAT:\"UMTS\",\r\nMCC:310, MNC:410, LAC:2b5c, CI:8a5a782, DLF:  4385, ULF:  4160, SC: 81, RSCP LEV: 27\r\n"
+                                "MCC:310, MNC:410, LAC:2b5c, CI:8a5a783, DLF:  4385, ULF:  4160, SC: 83, RSCP LEV: 18\r\n";
+    CellularHelperEnvironmentResponseStatic<4> resp;
+    resp.command = "CGED";
+
+    size_t before = iAllocations;
+    for (int i = 0; i < 100; i++) {
+        resp.clear();
+        resp.parse(TYPE_PLUS, chunk, sizeof(chunk) - 1);
+    }
+    CHECK(iAllocations == before);
+    CHECK(resp.service.ci == 0x8a5a782 && resp.getNumNeighbors() == 1);
+
+    double seconds = benchSeconds([&] {
+        for (int i = 0; i < 100000; i++) {
+            resp.clear();
+            resp.parse(TYPE_PLUS, chunk, sizeof(chunk) - 1);
+        }
+    });
+    printf("parse: %.0f ns per 3-line chunk, %u allocations\n", seconds * 1e9 / 100000, (unsigned)(iAllocations - before));
+}
+
+// CWD-- the plain and + string responses, into their fixed buffers
+static void testStringResponses() {
+    Cellular.expect("AT+CSQ\r\n", "+CSQ: 17,99\r\nOK\r\n");
+    CellularHelperRSSIQualResponse rssiQual = CellularHelper.getRSSIQual();
+    CHECK(rssiQual.resp == RESP_OK && rssiQual.rssi == -79 && rssiQual.qual == 99);
+
+    Cellular.expect("AT+UDOPN=9\r\n", "+UDOPN: 9,\"AT&T\"\r\nOK\r\n");
+    CHECK(strcmp(CellularHelper.getOperatorName().c_str(), "AT&T") == 0);
+
+    Cellular.expect("AT+CCID\r\n", "+CCID: 89014103211118510720\r\nOK\r\n");
+    CHECK(strcmp(CellularHelper.getICCID().c_str(), "89014103211118510720") == 0);
+
+    Cellular.expect("AT+CGMI\r\n", "u-blox\r\nOK\r\n");
+    CHECK(strcmp(CellularHelper.getManufacturer().c_str(), "u-blox") == 0);
+
+    // CWD-- more than the buffer holds is cut off, not written past it
+    std::string line(3 * CELLULAR_HELPER_STRING_SIZE, 'x');
+    CellularHelperStringResponse resp;
+    resp.parse(TYPE_UNKNOWN, line.c_str(), line.size());
+    resp.parse(TYPE_UNKNOWN, line.c_str(), line.size());
+    CHECK(strlen(resp.string) == CELLULAR_HELPER_STRING_SIZE - 1);
+
+    // CWD-- a + line for some other command is ignored, and the match doesn't need a null terminator
+    static const char chunk[] = "\r\n+CREG: 2,1\r\n+CSQ: 23,4\r\nXX";
+    CellularHelperRSSIQualResponse parsed;
+    parsed.command = "CSQ";
+    size_t before = iAllocations;
+    parsed.parse(TYPE_PLUS, chunk, sizeof(chunk) - 3);
+    parsed.postProcess();
+    CHECK(iAllocations == before);
+    CHECK(strcmp(parsed.string, "23,4") == 0 && parsed.rssi == -67 && parsed.qual == 4);
+}
+
+int main() {
+    testUMTS();
+    testGSMBounded();
+    testDamaged();
+    testNoAllocation();
+    testStringResponses();
+    return testResult();
+}
@@ -0,0 +1,86 @@
+// CWD-- the fix ring's queries, and the odometer fed from it over a replayed drive
+#include "FixHistory.h"
+#include "Odometer.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+static FixRecord record(const ReplayFix &replayed) {
+    FixRecord fix;
+    fix.point = replayed.point;
+    fix.time = replayed.time;
+    fix.speed = replayed.speed;
+    fix.course = replayed.speed > 2 ? replayed.course : -1.0f;
+    fix.altitude = 12.4f;
+    fix.hdop = replayed.hdop;
+    fix.satellites = 9;
+    return fix;
+}
+
+static void testQueries() {
+    FixHistory history;
+    FixRecord fix;
+    CHECK(history.isEmpty() && !history.latest(fix) && history.nearest(1000) == -1);
+
+    // CWD-- times straddle the millis() wrap
+    uint32_t start = 0xFFFFFFFFUL - 60500;
+    for (int i = 0; i < 100; i++) {
+        fix.point = GeoPoint(377749000 + i * 1000, -1224194000);
+        fix.time = (uint32_t)(start + i * 1000);
+        fix.speed = 13.37f;
+        fix.course = i % 2 ? 271.25f : -1.0f;
+        fix.altitude = -12.4f;
+        fix.hdop = 95;
+        fix.satellites = 11;
+        history.push(fix);
+    }
+    CHECK(history.size() == FIX_HISTORY_SIZE);
+
+    CHECK(history.latest(fix) && fix.point.lat == 377749000 + 99 * 1000 && fix.time == (uint32_t)(start + 99 * 1000));
+    CHECK_NEAR(fix.speed, 13.37f, 0.005f);
+    CHECK_NEAR(fix.course, 271.25f, 0.005f);
+    CHECK(fix.altitude == -12 && fix.hdop == 95 && fix.satellites == 11);
+    CHECK(history.get(1, fix) && fix.course < 0);
+    CHECK(history.get(FIX_HISTORY_SIZE - 1, fix) && fix.time == (uint32_t)(start + (100 - FIX_HISTORY_SIZE) * 1000));
+    CHECK(!history.get(FIX_HISTORY_SIZE, fix));
+
+    CHECK(history.nearest(start + 99 * 1000 + 5000) == 0);
+    CHECK(history.nearest(start + 90 * 1000 + 400) == 9);
+    CHECK(history.nearest(start + 90 * 1000 + 600) == 8);
+    CHECK(history.nearest(start) == FIX_HISTORY_SIZE - 1);
+
+    FixRecord out[8];
+    CHECK(history.range(start + 58 * 1000, start + 65 * 1000 + 10, out, 8) == 8); // CWD-- across the wrap
+    CHECK(out[0].time == (uint32_t)(start + 58 * 1000) && out[7].time == (uint32_t)(start + 65 * 1000));
+    CHECK_NEAR(history.pathLength(start + 90 * 1000, start + 99 * 1000), 9 * 11.12f, 0.1f);
+}
+
+// CWD-- the odometer over a drive, reading each epoch from the history the way GPSManager feeds it
+static void testOdometerFromHistory() {
+    EEPROM.clear();
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    FixHistory history;
+    Odometer odometer;
+    odometer.begin();
+
+    double truth = 0;
+    for (size_t i = 0; i < fixes.size(); i++) {
+        history.push(record(fixes[i]));
+        FixRecord fix;
+        history.latest(fix);
+        odometer.addFix(fix);
+        if (i > 0) {
+            truth += fixes[i - 1].truth.distanceTo(fixes[i].truth);
+        }
+    }
+
+    printf("odometer %.0f m, truth %.0f m, %lu rejected\n", odometer.getTripMeters(), truth, (unsigned long)odometer.getRejectedFixes());
+    CHECK(fabs(odometer.getTripMeters() - truth) < truth * 0.05);
+    CHECK(odometer.getRejectedFixes() > 0); // CWD-- the parked jitter at either end
+}
+
+int main() {
+    testQueries();
+    testOdometerFromHistory();
+    return testResult();
+}
@@ -0,0 +1,165 @@
+// CWD-- the fixed-point pipeline end to end, plus the distance and geofence routines benchmarked in
+// both representations. The double baselines are what GPSManager did before GeoPoint
+#include "GeofenceManager.h"
+#include "Geodesy.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+#include <TinyGPS++.h>
+
+static void feed(TinyGPSPlus &gps, const char *body) {
+    uint8_t sum = 0;
+    for (const char *p = body; *p; p++) {
+        sum ^= (uint8_t)*p;
+    }
+    char sentence[128];
+    snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, sum);
+    for (const char *p = sentence; *p; p++) {
+        gps.encode(*p);
+    }
+}
+
+static void testParseToE7() {
+    TinyGPSPlus gps;
+    feed(gps, "GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    GeoPoint point = GeoPoint::fromRaw(gps.location.rawLat(), gps.location.rawLng());
+    CHECK(point.lat == 481173000);
+    CHECK(point.lon == 115166667);
+
+    feed(gps, "GPGGA,123520,3351.1234567,S,15112.3456789,W,1,08,0.9,545.4,M,46.9,M,,");
+    point = GeoPoint::fromRaw(gps.location.rawLat(), gps.location.rawLng());
+    CHECK(point.lat == -338520576); // 33 + 51.1234567 / 60
+    CHECK(point.lon == -1512057613);
+}
+
+static void testFormatE7() {
+    char buf[GEO_E7_STR_LEN];
+    GeoPoint::formatE7(-1234567, buf, sizeof(buf));
+    CHECK(strcmp(buf, "-0.1234567") == 0);
+    GeoPoint::formatE7(-1800000000, buf, sizeof(buf));
+    CHECK(strcmp(buf, "-180.0000000") == 0);
+    GeoPoint::formatE7(377749000, buf, sizeof(buf));
+    CHECK(strcmp(buf, "37.7749000") == 0);
+}
+
+// CWD-- the old pipeline: doubles throughout and haversine on every pair
+static bool insideCircleDouble(double lat, double lon, double centerLat, double centerLon, double radius) {
+    return Geodesy::haversine(lat, lon, centerLat, centerLon) <= radius;
+}
+
+static bool insidePolygonDouble(double lat, double lon, const double (*poly)[2], size_t count) {
+    bool blnInside = false;
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        if ((poly[i][0] > lat) != (poly[j][0] > lat) && lon < (poly[j][1] - poly[i][1]) * (lat - poly[i][0]) / (poly[j][0] - poly[i][0]) + poly[i][1]) {
+            blnInside = !blnInside;
+        }
+    }
+    return blnInside;
+}
+
+static void benchDistance(const std::vector<ReplayFix> &fixes) {
+    const int passes = 200;
+    size_t hops = (fixes.size() - 1) * passes;
+    std::vector<double> lat(fixes.size()), lon(fixes.size());
+    std::vector<GeoPoint> points(fixes.size());
+    for (size_t i = 0; i < fixes.size(); i++) {
+        lat[i] = fixes[i].point.latitude();
+        lon[i] = fixes[i].point.longitude();
+        points[i] = fixes[i].point;
+    }
+
+    double dblTotal = 0;
+    float fTotal = 0, fFast = 0;
+    double dblSeconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i + 1 < fixes.size(); i++) {
+                dblTotal += Geodesy::haversine(lat[i], lon[i], lat[i + 1], lon[i + 1]);
+            }
+        }
+    });
+    double e7Seconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i + 1 < fixes.size(); i++) {
+                fTotal += Geodesy::haversine(points[i], points[i + 1]);
+            }
+        }
+    });
+    double fastSeconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            fFast += Geodesy::pathLength(points.data(), points.size());
+        }
+    });
+    benchKeep(dblTotal);
+    benchKeep(fTotal);
+    benchKeep(fFast);
+
+    printf("distance: double haversine %.1f ns/hop, E7 haversine %.1f ns/hop, E7 flat-earth batch %.1f ns/hop\n", dblSeconds * 1e9 / hops,
+           e7Seconds * 1e9 / hops, fastSeconds * 1e9 / hops);
+    CHECK_NEAR(fTotal / dblTotal, 1.0, 0.001);
+    CHECK_NEAR(fFast / dblTotal, 1.0, 0.001);
+}
+
+static void benchGeofence(const std::vector<ReplayFix> &fixes) {
+    // CWD-- 200 depot circles and 50 yard squares scattered over ~20km around the drive
+    static GeofenceDef defs[250];
+    static GeoPoint vertices[200];
+    static double circles[200][3];
+    static double squares[50][4][2];
+    TrackReplay rng(7);
+    GeoPoint origin = fixes[0].truth;
+
+    for (int i = 0; i < 200; i++) {
+        GeoPoint center = TrackReplay::toPoint(origin.latitude(), origin.longitude(), rng.noise() * 10000, rng.noise() * 10000 + 8000);
+        uint32_t radius = 100 + (uint32_t)((rng.noise() + 1) * 200);
+        defs[i] = {center, radius, (uint16_t)(i + 1), GEOFENCE_CIRCLE, 0};
+        circles[i][0] = center.latitude();
+        circles[i][1] = center.longitude();
+        circles[i][2] = radius;
+    }
+    for (int i = 0; i < 50; i++) {
+        double north = rng.noise() * 10000, east = rng.noise() * 10000 + 8000;
+        const double corners[4][2] = {{0, 0}, {0, 300}, {300, 300}, {300, 0}};
+        for (int v = 0; v < 4; v++) {
+            vertices[i * 4 + v] = TrackReplay::toPoint(origin.latitude(), origin.longitude(), north + corners[v][0], east + corners[v][1]);
+            squares[i][v][0] = vertices[i * 4 + v].latitude();
+            squares[i][v][1] = vertices[i * 4 + v].longitude();
+        }
+        defs[200 + i] = {GeoPoint(), (uint32_t)(i * 4), (uint16_t)(201 + i), GEOFENCE_POLYGON, 4};
+    }
+
+    static GeofenceManager manager;
+    CHECK(manager.begin(defs, 250, vertices, 200));
+
+    size_t doubleInside = 0;
+    double dblSeconds = benchSeconds([&] {
+        for (const ReplayFix &fix : fixes) {
+            double lat = fix.point.latitude(), lon = fix.point.longitude();
+            for (int i = 0; i < 200; i++) {
+                doubleInside += insideCircleDouble(lat, lon, circles[i][0], circles[i][1], circles[i][2]);
+            }
+            for (int i = 0; i < 50; i++) {
+                doubleInside += insidePolygonDouble(lat, lon, squares[i], 4);
+            }
+        }
+    });
+    double e7Seconds = benchSeconds([&] {
+        for (const ReplayFix &fix : fixes) {
+            manager.update(fix.point, fix.time);
+        }
+    });
+    benchKeep(doubleInside);
+
+    printf("geofence, 250 fences: double brute force %.0f ns/fix, E7 indexed %.0f ns/fix (%.1f candidates/fix)\n",
+           dblSeconds * 1e9 / fixes.size(), e7Seconds * 1e9 / fixes.size(), (double)manager.getCandidatesTested() / fixes.size());
+}
+
+int main() {
+    testParseToE7();
+    testFormatE7();
+
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    benchDistance(fixes);
+    benchGeofence(fixes);
+    return testResult();
+}
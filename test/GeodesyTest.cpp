@@ -0,0 +1,136 @@
+// CWD-- error bounds of the fast kernels against the double haversine, and their throughput
+#include "Geodesy.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+#include <TinyGPS++.h>
+
+// CWD-- random hops of up to maxHop meters from random origins between +/-maxLat. Returns the worst relative error
+template <class F> static double worstError(F kernel, double maxLat, double maxHop, double &worstAbs) {
+    TrackReplay rng(3);
+    double worst = 0;
+    worstAbs = 0;
+    for (int i = 0; i < 20000; i++) {
+        double lat = rng.noise() * maxLat, lon = rng.noise() * 180;
+        double hop = maxHop * (rng.noise() + 1) / 2 + 1, bearing = (rng.noise() + 1) * M_PI;
+        GeoPoint from = GeoPoint::fromDegrees(lat, lon);
+        GeoPoint to = TrackReplay::toPoint(from.latitude(), from.longitude(), hop * cos(bearing), hop * sin(bearing));
+        double exact = Geodesy::haversine(from.latitude(), from.longitude(), to.latitude(), to.longitude());
+        double error = fabs(kernel(from, to) - exact);
+        worst = fmax(worst, error / exact);
+        worstAbs = fmax(worstAbs, error);
+    }
+    return worst;
+}
+
+static void testErrorBounds() {
+    double worstAbs;
+    auto flat = [](const GeoPoint &from, const GeoPoint &to) { return (double)LocalProjection(from).distance(from, to); };
+    auto e7 = [](const GeoPoint &from, const GeoPoint &to) { return (double)Geodesy::haversine(from, to); };
+
+    // CWD-- the documented bound: under 0.1% for hops below GEO_FAST_MAX_HOP_M, away from the poles
+    double worst = worstError(flat, 70, GEO_FAST_MAX_HOP_M, worstAbs);
+    printf("flat-earth, <10km, |lat|<70: worst %.5f%% (%.2f m)\n", worst * 100, worstAbs);
+    CHECK(worst < 0.001);
+
+    worst = worstError(flat, 70, 100, worstAbs);
+    printf("flat-earth, <100m: worst %.5f%% (%.3f m)\n", worst * 100, worstAbs);
+    CHECK(worstAbs < 0.05);
+
+    worst = worstError(e7, 85, GEO_FAST_MAX_HOP_M, worstAbs);
+    printf("E7 float haversine, <10km: worst %.5f%% (%.2f m)\n", worst * 100, worstAbs);
+    CHECK(worst < 0.001);
+}
+
+static void testConsistentRadius() {
+    // CWD-- TinyGPS++ was patched to the same mean radius; the two must agree on a long baseline
+    double ours = Geodesy::haversine(37.7749, -122.4194, 51.5074, -0.1278);
+    double theirs = TinyGPSPlus::distanceBetween(37.7749, -122.4194, 51.5074, -0.1278);
+    CHECK_NEAR(theirs / ours, 1.0, 1e-9);
+    CHECK_NEAR(ours, 8616000, 5000); // SFO-LON great circle on a 6371km sphere
+}
+
+static void testAntimeridian() {
+    CHECK(Geodesy::deltaLonE7(1799000000, -1799000000) == 2000000);
+    CHECK(Geodesy::deltaLonE7(-1799000000, 1799000000) == -2000000);
+    GeoPoint west(0, 1799990000), east(0, -1799990000);
+    CHECK_NEAR(Geodesy::haversine(west, east), 222.39, 0.1);
+    CHECK_NEAR(LocalProjection(west).distance(west, east), 222.39, 0.1);
+}
+
+static void testBatch() {
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    std::vector<GeoPoint> points;
+    for (const ReplayFix &fix : fixes) {
+        points.push_back(fix.truth);
+    }
+    points.push_back(GeoPoint::fromDegrees(38.5, -121.5)); // CWD-- one long hop has to fall back to haversine
+
+    std::vector<float> hops(points.size() - 1);
+    float total = Geodesy::hopDistances(points.data(), points.size(), hops.data());
+    double exact = 0, sum = 0;
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        double hop = Geodesy::haversine(points[i].latitude(), points[i].longitude(), points[i + 1].latitude(), points[i + 1].longitude());
+        CHECK_NEAR(hops[i], hop, fmax(0.05, hop * 0.001));
+        exact += hop;
+        sum += hops[i];
+    }
+    CHECK_NEAR(total, sum, sum * 1e-5);
+    CHECK_NEAR(total / exact, 1.0, 0.001);
+    CHECK(Geodesy::hopDistances(points.data(), 1, nullptr) == 0);
+}
+
+static void benchThroughput() {
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    std::vector<GeoPoint> points;
+    for (const ReplayFix &fix : fixes) {
+        points.push_back(fix.point);
+    }
+    std::vector<float> hops(points.size());
+    LocalProjection projection(points[0]);
+    const int passes = 500;
+    size_t count = (points.size() - 1) * passes;
+    float sink = 0;
+
+    double tinySeconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i + 1 < points.size(); i++) {
+                sink += TinyGPSPlus::distanceBetween(points[i].latitude(), points[i].longitude(), points[i + 1].latitude(), points[i + 1].longitude());
+            }
+        }
+    });
+    double haversineSeconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i + 1 < points.size(); i++) {
+                sink += Geodesy::haversine(points[i], points[i + 1]);
+            }
+        }
+    });
+    double flatSeconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i + 1 < points.size(); i++) {
+                sink += projection.distance(points[i], points[i + 1]);
+            }
+        }
+    });
+    double batchSeconds = benchSeconds([&] {
+        for (int pass = 0; pass < passes; pass++) {
+            sink += Geodesy::hopDistances(points.data(), points.size(), hops.data());
+        }
+    });
+    benchKeep(sink);
+
+    printf("throughput (M distances/s): TinyGPS++ %.1f, E7 haversine %.1f, flat-earth %.1f, batch %.1f\n", count / tinySeconds / 1e6,
+           count / haversineSeconds / 1e6, count / flatSeconds / 1e6, count / batchSeconds / 1e6);
+}
+
+int main() {
+    testErrorBounds();
+    testConsistentRadius();
+    testAntimeridian();
+    testBatch();
+    benchThroughput();
+    return testResult();
+}
@@ -0,0 +1,159 @@
+// CWD-- hysteresis behaviour, and the grid index benchmarked with 10k fences over a replayed drive.
+// This target builds GeofenceManager with GEOFENCE_MAX_FENCES raised to 10k (see CMakeLists.txt)
+#include "GeofenceManager.h"
+#include "Geofences.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+static int iEvents = 0;
+static bool blnLastEntered = false;
+
+static void onEvent(uint16_t id, bool entered, const GeoPoint &point, unsigned long time) {
+    iEvents++;
+    blnLastEntered = entered;
+}
+
+static GeoPoint offset(const GeoPoint &origin, double north, double east) { return TrackReplay::toPoint(origin.latitude(), origin.longitude(), north, east); }
+
+static void testHysteresis() {
+    static GeofenceManager manager;
+    const GeoPoint center(377749000, -1224194000);
+    const GeofenceDef fences[] = {{center, 100, 1, GEOFENCE_CIRCLE, 0}};
+    CHECK(manager.begin(fences, 1, nullptr, 0));
+    manager.withCallback(onEvent);
+    iEvents = 0;
+
+    unsigned long t = 0;
+    manager.update(offset(center, 0, 300), t += 1000);
+    manager.update(offset(center, 0, 50), t += 1000); // CWD-- one fix inside isn't enough
+    CHECK(iEvents == 0);
+    manager.update(offset(center, 0, 300), t += 1000);
+    manager.update(offset(center, 0, 50), t += 1000);
+    CHECK(iEvents == 0);
+    manager.update(offset(center, 0, 60), t += 1000);
+    CHECK(iEvents == 1 && blnLastEntered && manager.isInside(1));
+
+    // CWD-- just outside the radius but inside the exit margin doesn't count as leaving
+    for (int i = 0; i < 5; i++) {
+        manager.update(offset(center, 0, 100 + GEOFENCE_EXIT_MARGIN_M / 2), t += 1000);
+    }
+    CHECK(iEvents == 1);
+    manager.update(offset(center, 0, 200), t += 1000);
+    manager.update(offset(center, 0, 200), t += 1000);
+    CHECK(iEvents == 2 && !blnLastEntered && !manager.isInside(1));
+}
+
+static void testPendingClearedOutOfCandidateSet() {
+    static GeofenceManager manager;
+    const GeoPoint center(377749000, -1224194000);
+    const GeofenceDef fences[] = {{center, 100, 1, GEOFENCE_CIRCLE, 0}};
+    CHECK(manager.begin(fences, 1, nullptr, 0));
+    manager.withCallback(onEvent);
+    iEvents = 0;
+
+    // CWD-- one fix inside, then away in another grid cell for a while, then one fix inside again: that's two
+    // isolated fixes, not two in a row
+    unsigned long t = 0;
+    manager.update(offset(center, 0, 50), t += 1000);
+    for (int i = 0; i < 30; i++) {
+        manager.update(offset(center, 5000, 5000), t += 1000);
+    }
+    manager.update(offset(center, 0, 50), t += 1000);
+    CHECK(iEvents == 0);
+    manager.update(offset(center, 0, 50), t += 1000);
+    CHECK(iEvents == 1);
+}
+
+static void testPolygon() {
+    static GeofenceManager manager;
+    CHECK(manager.begin(GEOFENCES, sizeof(GEOFENCES) / sizeof(GEOFENCES[0]), GEOFENCE_VERTICES, sizeof(GEOFENCE_VERTICES) / sizeof(GEOFENCE_VERTICES[0])));
+    manager.withCallback(onEvent);
+    iEvents = 0;
+
+    GeoPoint yard(377780000, -1223995000);
+    manager.update(yard, 1000);
+    manager.update(yard, 2000);
+    CHECK(manager.isInside(2) && !manager.isInside(1));
+    manager.update(GeoPoint(377800000, -1223995000), 3000); // CWD-- ~110m north of the yard
+    manager.update(GeoPoint(377800000, -1223995000), 4000);
+    CHECK(!manager.isInside(2));
+}
+
+// CWD-- the reference: every fence, every fix
+static size_t bruteForceInside(const GeofenceDef *fences, size_t count, const GeoPoint *vertices, const GeoPoint &point) {
+    size_t inside = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (fences[i].type == GEOFENCE_CIRCLE) {
+            inside += Geodesy::haversine(point, fences[i].center) <= fences[i].radiusOrVertexStart;
+            continue;
+        }
+        const GeoPoint *poly = vertices + fences[i].radiusOrVertexStart;
+        bool blnInside = false;
+        for (size_t a = 0, b = fences[i].vertexCount - 1; a < fences[i].vertexCount; b = a++) {
+            if ((poly[a].lat > point.lat) != (poly[b].lat > point.lat) &&
+                point.lon < (double)(poly[b].lon - poly[a].lon) * (point.lat - poly[a].lat) / (poly[b].lat - poly[a].lat) + poly[a].lon) {
+                blnInside = !blnInside;
+            }
+        }
+        inside += blnInside;
+    }
+    return inside;
+}
+
+static void benchTenThousand() {
+    const size_t fenceCount = 10000, polygonCount = 2000;
+    static GeofenceDef fences[fenceCount];
+    static GeoPoint vertices[polygonCount * 4];
+    TrackReplay replay, rng(11);
+    std::vector<ReplayFix> fixes = replay.drive();
+    GeoPoint origin = fixes[0].truth;
+
+    // CWD-- sites within ~30km of the route, a few hundred of them right along it so fences actually trigger
+    for (size_t i = 0; i < fenceCount; i++) {
+        GeoPoint center = i % 25 == 0 ? offset(fixes[(i * 7919) % fixes.size()].truth, rng.noise() * 150, rng.noise() * 150)
+                                       : offset(origin, rng.noise() * 30000, rng.noise() * 30000 + 15000);
+        if (i < fenceCount - polygonCount) {
+            fences[i] = {center, 60 + (uint32_t)((rng.noise() + 1) * 120), (uint16_t)(i + 1), GEOFENCE_CIRCLE, 0};
+            continue;
+        }
+        size_t v = (i - (fenceCount - polygonCount)) * 4;
+        double size = 80 + (rng.noise() + 1) * 100;
+        vertices[v] = center;
+        vertices[v + 1] = offset(center, 0, size);
+        vertices[v + 2] = offset(center, size, size * 1.3);
+        vertices[v + 3] = offset(center, size, 0);
+        fences[i] = {GeoPoint(), (uint32_t)v, (uint16_t)(i + 1), GEOFENCE_POLYGON, 4};
+    }
+
+    static GeofenceManager manager;
+    CHECK(manager.begin(fences, fenceCount, vertices, polygonCount * 4));
+    manager.withCallback(onEvent);
+    iEvents = 0;
+
+    double indexedSeconds = benchSeconds([&] {
+        for (const ReplayFix &fix : fixes) {
+            manager.update(fix.truth, fix.time);
+        }
+    });
+    size_t insideFixes = 0;
+    double bruteSeconds = benchSeconds([&] {
+        for (const ReplayFix &fix : fixes) {
+            insideFixes += bruteForceInside(fences, fenceCount, vertices, fix.truth);
+        }
+    });
+
+    printf("10k fences over %u fixes: indexed %.2f us/fix (%.1f candidates/fix), brute force %.0f us/fix; %d events, %u inside-fixes\n",
+           (unsigned)fixes.size(), indexedSeconds * 1e6 / fixes.size(), (double)manager.getCandidatesTested() / fixes.size(),
+           bruteSeconds * 1e6 / fixes.size(), iEvents, (unsigned)insideFixes);
+    CHECK(manager.getFenceCount() == fenceCount);
+    CHECK(iEvents > 0);
+    CHECK(manager.getCandidatesTested() < fixes.size() * 100);
+}
+
+int main() {
+    testHysteresis();
+    testPendingClearedOutOfCandidateSet();
+    testPolygon();
+    benchTenThousand();
+    return testResult();
+}
@@ -0,0 +1,214 @@
+// CWD-- the fixed-buffer JSON writer and the RecordPacker built on it. Output is checked byte for byte,
+// overflow always leaves something closable, and the publish paths are benchmarked for bytes/s and allocations
+// against the String-and-sprintf pattern they replaced
+#include "JsonWriter.h"
+#include "RecordPacker.h"
+#include "TestHarness.h"
+
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// CWD-- counts heap allocations so the writer can be held to zero
+static size_t iAllocations = 0;
+
+void *operator new(size_t size) {
+    iAllocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static const uint8_t CAN_DATA[8] = {0x01, 0x7F, 0x80, 0xFF, 0x00, 0x10, 0xA5, 0x5A};
+
+static void testStructure() {
+    char buf[128];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject().key("a").number(1).key("b").beginArray().number(1).number(2).beginObject().key("c").boolean(true);
+    json.endObject().beginArray().endArray().endArray().key("d").string("x").key("e").raw("[0]").endObject();
+    CHECK(!json.isOverflowed());
+    CHECK(strcmp(buf, "{\"a\":1,\"b\":[1,2,{\"c\":true},[]],\"d\":\"x\",\"e\":[0]}") == 0);
+    CHECK(json.length() == strlen(buf));
+
+    // CWD-- too deep, and a closer with nothing open
+    JsonWriter deep(buf, sizeof(buf));
+    for (int i = 0; i < JSON_MAX_DEPTH; i++) {
+        deep.beginArray();
+    }
+    CHECK(deep.isOverflowed());
+    JsonWriter unbalanced(buf, sizeof(buf));
+    unbalanced.endObject();
+    CHECK(unbalanced.isOverflowed());
+
+    JsonWriter empty(nullptr, 0);
+    CHECK(empty.isOverflowed() && empty.number(1).length() == 0);
+}
+
+static void testValues() {
+    char buf[256];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginArray();
+    json.string("q\"b\\s/\n\r\t\x01\x1f\xc3\xa9");
+    json.number(0).number(-1).number(INT64_MAX).number(INT64_MIN);
+    json.fixed(123456789, 7).fixed(-5, 7).fixed(0, 2).fixed(-1050, 2).fixed(100, 0);
+    json.hex(0x0A).hex(0x7FF).hex(0, 0).hex(0xDEADBEEF, 2).hex(0x12, 8);
+    json.boolean(false).endArray();
+    CHECK(!json.isOverflowed());
+    CHECK(strcmp(buf, "[\"q\\\"b\\\\s/\\n\\r\\t\\u0001\\u001f\xc3\xa9\","
+                      "0,-1,9223372036854775807,-9223372036854775808,"
+                      "12.3456789,-0.0000005,0.00,-10.50,100,"
+                      "\"0x0A\",\"0x7FF\",\"0x0\",\"0xDEADBEEF\",\"0x00000012\","
+                      "false]") == 0);
+}
+
+static void testOverflow() {
+    char buf[24];
+
+    // CWD-- a writer copied before an element rolls it back, and the closers always fit after that
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject().key("p").beginArray();
+    int kept = 0;
+    for (int i = 0; i < 20; i++) {
+        JsonWriter before = json;
+        json.number(1000 + i);
+        if (json.isOverflowed()) {
+            json = before;
+            break;
+        }
+        kept++;
+    }
+    json.endArray().endObject();
+    CHECK(!json.isOverflowed() && kept == 3);
+    CHECK(strcmp(buf, "{\"p\":[1000,1001,1002]}") == 0);
+
+    // CWD-- once overflowed nothing more is written, closers included. What got in before stays: roll back instead
+    JsonWriter full(buf, sizeof(buf));
+    full.beginArray().string("far too long for the buffer").number(1).endArray();
+    CHECK(full.isOverflowed() && strcmp(buf, "[\"") == 0);
+
+    // CWD-- reserved bytes are held back from values and handed back for a trailer
+    JsonWriter reserved(buf, sizeof(buf));
+    CHECK(reserved.reserve(10) == 0);
+    reserved.beginArray().string("0123456789");
+    CHECK(reserved.isOverflowed());
+    JsonWriter trailer(buf, sizeof(buf));
+    trailer.reserve(10);
+    trailer.beginArray().string("01234567");
+    CHECK(!trailer.isOverflowed() && trailer.reserve(0) == 10);
+    trailer.string("01234567").endArray();
+    CHECK(!trailer.isOverflowed() && trailer.length() == sizeof(buf) - 1);
+}
+
+static void testRecordPacker() {
+    char buf[128];
+    RecordPacker packer;
+    packer.begin(buf, sizeof(buf), 1760000000);
+    CHECK(packer.add("{\"a\":1}", 1760000005));
+    CHECK(packer.add("{\"b\":2}", 0)); // CWD-- no time: offset 0
+    CHECK(packer.getCount() == 2);
+    CHECK(strcmp(packer.finish(), "{\"t0\":1760000000,\"tu\":\"s\",\"r\":[[5,{\"a\":1}],[0,{\"b\":2}]],\"n\":2}") == 0);
+
+    // CWD-- fills up without splitting a record, and the trailer still fits behind the last one
+    packer.begin(buf, sizeof(buf), 1760000000);
+    size_t count = 0;
+    while (packer.add("{\"geofence\":12}", 1760000000 + count)) {
+        count++;
+    }
+    CHECK(count > 0 && packer.getCount() == count);
+    const char *packed = packer.finish();
+    char trailer[16];
+    snprintf(trailer, sizeof(trailer), "]],\"n\":%u}", (unsigned)count);
+    CHECK(strlen(packed) < sizeof(buf) && strlen(packed) == packer.getLength());
+    CHECK(strcmp(packed + strlen(packed) - strlen(trailer), trailer) == 0);
+}
+
+// CWD-- the CAN JSON as the publish path builds it
+static size_t writeCAN(char *buf, size_t capacity, uint32_t id, int64_t ts) {
+    JsonWriter json(buf, capacity);
+    json.beginObject().key("id").hex(id).key("data").beginArray();
+    for (uint8_t byte : CAN_DATA) {
+        json.hex(byte);
+    }
+    json.endArray().key("ts").number(ts).endObject();
+    return json.length();
+}
+
+// CWD-- what it replaced, with std::string standing in for Wiring's String
+static size_t stringCAN(std::string &str, uint32_t id, int64_t ts) {
+    char strTemp[64];
+    sprintf(strTemp, "\"0x%.2X\"", (unsigned)id);
+    str = "{\"id\":";
+    str += std::string(strTemp) + ", \"data\": [";
+    for (uint8_t byte : CAN_DATA) {
+        sprintf(strTemp, "\"0x%.2X\",", byte);
+        str += strTemp;
+    }
+    str.erase(str.length() - 1);
+    sprintf(strTemp, "%lld", (long long)ts);
+    str += "], \"ts\": " + std::string(strTemp) + "}";
+    return str.length();
+}
+
+static void benchThroughput() {
+    const int iterations = 200000;
+    char buf[160];
+
+    size_t bytes = 0, before = iAllocations;
+    double seconds = benchSeconds([&] {
+        for (int i = 0; i < iterations; i++) {
+            bytes += writeCAN(buf, sizeof(buf), 0x7E8 + (i & 7), 1760000000000LL + i);
+            benchKeep(buf);
+        }
+    });
+    size_t allocations = iAllocations - before;
+    printf("writer: %.0f MB/s, %.0f ns per CAN record, %.2f allocations per record\n", bytes / seconds / 1e6,
+           seconds * 1e9 / iterations, (double)allocations / iterations);
+    CHECK(allocations == 0);
+
+    size_t stringBytes = 0;
+    before = iAllocations;
+    double stringSeconds = benchSeconds([&] {
+        for (int i = 0; i < iterations; i++) {
+            std::string str;
+            stringBytes += stringCAN(str, 0x7E8 + (i & 7), 1760000000000LL + i);
+            benchKeep(str);
+        }
+    });
+    printf("String + sprintf: %.0f MB/s, %.0f ns per CAN record, %.2f allocations per record\n",
+           stringBytes / stringSeconds / 1e6, stringSeconds * 1e9 / iterations, (double)(iAllocations - before) / iterations);
+
+    char packed[1024];
+    RecordPacker packer;
+    size_t packedBytes = 0, records = 0;
+    before = iAllocations;
+    double packSeconds = benchSeconds([&] {
+        for (int i = 0; i < iterations / 20; i++) {
+            packer.begin(packed, sizeof(packed), 1760000000);
+            while (packer.add("{\"id\":\"0x7E8\",\"data\":[\"0x01\",\"0x7F\"]}", 1760000000 + packer.getCount())) {
+            }
+            records += packer.getCount();
+            packedBytes += strlen(packer.finish());
+            benchKeep(packed);
+        }
+    });
+    allocations = iAllocations - before;
+    printf("packer: %.0f MB/s, %.0f ns per record, %u allocations\n", packedBytes / packSeconds / 1e6, packSeconds * 1e9 / records,
+           (unsigned)allocations);
+    CHECK(allocations == 0);
+}
+
+int main() {
+    testStructure();
+    testValues();
+    testOverflow();
+    testRecordPacker();
+    benchThroughput();
+    return testResult();
+}
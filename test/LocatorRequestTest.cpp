@@ -0,0 +1,148 @@
+// CWD-- the locator scan payload: both formats carry full-width cell identities, the binary one decodes back to
+// exactly what was added, and a full request drops entries rather than overflowing
+#include "LocatorRequestBuilder.h"
+#include "TestHarness.h"
+
+#include <string.h>
+#include <vector>
+
+// CWD-- what the webhook side does with a binary request
+struct DecodedRequest {
+    uint8_t version = 0;
+    char type = 0;
+    std::vector<CellKey> towers;
+    std::vector<std::vector<uint8_t>> accessPoints; // CWD-- bssid(6) rssi channel, as sent
+};
+
+static uint32_t readLE(const uint8_t *p, int n) {
+    uint32_t value = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static bool decode(const char *payload, DecodedRequest &request) {
+    static const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    if (*payload++ != 'b') {
+        return false;
+    }
+    std::vector<uint8_t> raw;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (; *payload; payload++) {
+        const char *c = strchr(BASE64_CHARS, *payload);
+        if (!c) {
+            return false;
+        }
+        acc = (acc << 6) | (uint32_t)(c - BASE64_CHARS);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            raw.push_back((uint8_t)(acc >> bits));
+        }
+    }
+    if (raw.size() < 3) {
+        return false;
+    }
+    request.version = raw[0];
+    request.type = (char)raw[1];
+    size_t count = raw[2], entry = request.type == 'c' ? 12 : 8;
+    if (raw.size() != 3 + count * entry) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = &raw[3 + i * entry];
+        if (request.type == 'c') {
+            CellKey key;
+            key.mcc = (uint16_t)readLE(p, 2);
+            key.mnc = (uint16_t)readLE(p + 2, 2);
+            key.lac = readLE(p + 4, 4);
+            key.ci = readLE(p + 8, 4);
+            request.towers.push_back(key);
+        }
+        else {
+            request.accessPoints.push_back(std::vector<uint8_t>(p, p + entry));
+        }
+    }
+    return true;
+}
+
+// CWD-- an LTE serving cell (28-bit ECI, TAC past 16 bits as some networks report it), a 3G one and a GSM one
+static const CellKey TOWERS[] = {
+    {310, 410, 0x12B5C, 0x8A5A782}, {310, 260, 0x2B5C, 0xFFFFFFF}, {234, 15, 0xFFFE, 0x1234}, {1, 1, 0xFFFFFFFF, 0xFFFFFFFF}};
+
+static void testBinaryTowers() {
+    LocatorRequestBuilder builder(256, LocatorRequestBuilder::FORMAT_BINARY);
+    builder.beginCellular("AT&T");
+    for (const CellKey &key : TOWERS) {
+        CHECK(builder.addTower(key.ci, key.lac, key.mcc, key.mnc));
+    }
+    const char *payload = builder.finish();
+    printf("binary, %u towers: %u bytes: %s\n", (unsigned)builder.getNumAdded(), (unsigned)strlen(payload), payload);
+
+    DecodedRequest request;
+    CHECK(decode(payload, request));
+    CHECK(request.version == LocatorRequestBuilder::BINARY_VERSION && request.type == 'c');
+    CHECK(request.towers.size() == sizeof(TOWERS) / sizeof(TOWERS[0]));
+    for (size_t i = 0; i < request.towers.size(); i++) {
+        CHECK(request.towers[i] == TOWERS[i]);
+    }
+    CHECK(builder.getServingCell() == TOWERS[0]);
+}
+
+static void testBinaryAccessPoints() {
+    const uint8_t bssid[6] = {0x00, 0x1A, 0x2B, 0x3C, 0x4D, 0xFE};
+    LocatorRequestBuilder builder(128, LocatorRequestBuilder::FORMAT_BINARY);
+    builder.beginWiFi(true);
+    CHECK(builder.addAccessPoint(bssid, -87, 11));
+    CHECK(builder.addAccessPoint(bssid, -30, 165));
+
+    DecodedRequest request;
+    CHECK(decode(builder.finish(), request));
+    CHECK(request.type == 'w' && request.accessPoints.size() == 2);
+    CHECK(memcmp(request.accessPoints[0].data(), bssid, 6) == 0);
+    CHECK((int8_t)request.accessPoints[0][6] == -87 && request.accessPoints[0][7] == 11);
+    CHECK((int8_t)request.accessPoints[1][6] == -30 && request.accessPoints[1][7] == 165);
+}
+
+// CWD-- the JSON format prints the full values too
+static void testJson() {
+    LocatorRequestBuilder builder(256);
+    builder.beginCellular("O2 \"UK\"");
+    CHECK(builder.addTower(TOWERS[0].ci, TOWERS[0].lac, TOWERS[0].mcc, TOWERS[0].mnc));
+    CHECK(strcmp(builder.finish(), "{\"c\":{\"o\":\"O2 \\\"UK\\\"\",\"a\":[{\"i\":145074050,\"l\":76636,\"c\":310,\"n\":410}]}}") == 0);
+}
+
+// CWD-- a request that fills up keeps whole entries, counts the rest as dropped and still decodes
+static void testFull() {
+    for (int format : {LocatorRequestBuilder::FORMAT_JSON, LocatorRequestBuilder::FORMAT_BINARY}) {
+        LocatorRequestBuilder builder(96, format);
+        builder.beginCellular("carrier");
+        for (int i = 0; i < 20; i++) {
+            builder.addTower(TOWERS[0].ci + i, TOWERS[0].lac, TOWERS[0].mcc, TOWERS[0].mnc);
+        }
+        const char *payload = builder.finish();
+        CHECK(builder.getNumAdded() > 0 && builder.getNumAdded() + builder.getNumDropped() == 20);
+        CHECK(strlen(payload) < 96);
+        if (format == LocatorRequestBuilder::FORMAT_BINARY) {
+            DecodedRequest request;
+            CHECK(decode(payload, request) && request.towers.size() == builder.getNumAdded());
+            CHECK(request.towers.back().ci == TOWERS[0].ci + builder.getNumAdded() - 1);
+        }
+        printf("%s in 96 bytes: %u of 20 towers\n", format == LocatorRequestBuilder::FORMAT_JSON ? "json" : "binary",
+               (unsigned)builder.getNumAdded());
+    }
+
+    LocatorRequestBuilder empty(64, LocatorRequestBuilder::FORMAT_BINARY);
+    empty.beginCellular("carrier");
+    CHECK(strcmp(empty.finish(), "") == 0);
+}
+
+int main() {
+    testBinaryTowers();
+    testBinaryAccessPoints();
+    testJson();
+    testFull();
+    return testResult();
+}
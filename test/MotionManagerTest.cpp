@@ -0,0 +1,118 @@
+// CWD-- the motion classifier over a replayed drive, plus the slow-creep and tow cases
+#include "MotionManager.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+#include <string>
+
+static std::vector<MotionState> transitions;
+
+static void onTransition(MotionState from, MotionState to, unsigned long time) { transitions.push_back(to); }
+
+// CWD-- RPM and ignition the way FleetTracker feeds them: a reply per 5s request while the engine runs, and
+// ignition off once the ECU has been silent for 30s
+class EngineFeed {
+  public:
+    void tick(MotionManager &motion, bool blnRunning, uint16_t rpm, unsigned long time) {
+        if (blnRunning && time - ulLastRequest >= 5000) {
+            ulLastRequest = time;
+            ulLastReply = time;
+            motion.updateEngine(rpm, time);
+            motion.setIgnition(true, time);
+        } else if (ulLastReply != 0 && time - ulLastReply > 30000) {
+            motion.setIgnition(false, time);
+        }
+    }
+
+  private:
+    unsigned long ulLastRequest = 0;
+    unsigned long ulLastReply = 0;
+};
+
+static std::string names(const std::vector<MotionState> &states) {
+    std::string str;
+    for (MotionState state : states) {
+        str += std::string(str.empty() ? "" : ",") + MotionManager::getStateName(state);
+    }
+    return str;
+}
+
+static void testReplayedDrive() {
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    MotionManager motion;
+    EngineFeed engine;
+    transitions.clear();
+    motion.subscribe(onTransition);
+
+    // CWD-- the engine starts 20s before pulling out and stops 20s after the final stop
+    size_t engineOn = 100, engineOff = fixes.size() - 160;
+    for (size_t i = 0; i < fixes.size(); i++) {
+        const ReplayFix &fix = fixes[i];
+        engine.tick(motion, i >= engineOn && i < engineOff, 750, fix.time);
+        motion.update(fmax(0.0, fix.speed + replay.gaussian() * 0.2), fix.point, fix.time);
+    }
+
+    printf("replayed drive: %s\n", names(transitions).c_str());
+    CHECK(names(transitions) == "parked,idling,moving,idling,moving,idling,parked");
+    CHECK(motion.getState() == MOTION_PARKED);
+}
+
+// CWD-- creeping along a queue just under walking-pace-plus, engine running. GPS speed noise pokes over the
+// rolling threshold now and then, so the candidate keeps flipping; the displacement from the stop still adds up
+static void testSlowCreep() {
+    TrackReplay replay(7);
+    MotionManager motion;
+    transitions.clear();
+    motion.subscribe(onTransition);
+
+    double lat = 37.7749, lon = -122.4194, north = 0;
+    unsigned long time = 1000;
+    for (int s = 0; s < 120; s++, time += 1000) {
+        motion.updateEngine(750, time);
+        motion.update(0, TrackReplay::toPoint(lat, lon, replay.gaussian() * 2, replay.gaussian() * 2), time);
+    }
+    CHECK(motion.getState() == MOTION_IDLING);
+
+    for (int s = 0; s < 120; s++, time += 1000) {
+        north += 1.2;
+        motion.updateEngine(750, time);
+        motion.update(fmax(0.0, 1.2 + replay.gaussian() * 0.5), TrackReplay::toPoint(lat, lon, north + replay.gaussian() * 2, replay.gaussian() * 2),
+                      time);
+    }
+    printf("slow creep: %s\n", names(transitions).c_str());
+    CHECK(motion.getState() == MOTION_MOVING);
+}
+
+static void testTow() {
+    MotionManager motion;
+    EngineFeed engine;
+    unsigned long time = 1000;
+    double north = 0;
+
+    // CWD-- drive, park and switch off, wait, then get hauled away
+    for (int s = 0; s < 60; s++, time += 1000) {
+        north += 12;
+        engine.tick(motion, true, 1800, time);
+        motion.update(12, TrackReplay::toPoint(37.7749, -122.4194, north, 0), time);
+    }
+    CHECK(motion.getState() == MOTION_MOVING);
+    for (int s = 0; s < 300; s++, time += 1000) {
+        engine.tick(motion, false, 0, time);
+        motion.update(0, TrackReplay::toPoint(37.7749, -122.4194, north, 0), time);
+    }
+    CHECK(motion.getState() == MOTION_PARKED);
+    for (int s = 0; s < 30; s++, time += 1000) {
+        north += 8;
+        engine.tick(motion, false, 0, time);
+        motion.update(8, TrackReplay::toPoint(37.7749, -122.4194, north, 0), time);
+    }
+    CHECK(motion.getState() == MOTION_TOWING);
+}
+
+int main() {
+    testReplayedDrive();
+    testSlowCreep();
+    testTow();
+    return testResult();
+}
@@ -0,0 +1,173 @@
+// CWD-- TinyGPS++ against a golden corpus, and its throughput over a multi-megabyte generated one.
+// A parser change is only good if both still agree here and the fuzz target (fuzz/NmeaFuzz.cpp) stays clean
+#include "TestHarness.h"
+#include "TrackReplay.h"
+#include <TinyGPS++.h>
+
+#include <stdarg.h>
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// CWD-- data/nmea_golden.nmea: a u-blox style session with boot chatter, GP/GN/GL/GA/GB talkers, PUBX, a UBX
+// binary frame, line noise, '\n'-only endings, lowercase checksums, corrupted and truncated sentences. The
+// counts come from the independent model of the parser's state machine in data/nmea_golden.py, which also
+// regenerates the corpus
+#define GOLDEN_CHARS 43312
+#define GOLDEN_PASSED 679
+#define GOLDEN_FAILED 22
+#define GOLDEN_WITH_FIX 220
+
+static void testGoldenCorpus() {
+    std::ifstream file("data/nmea_golden.nmea", std::ios::binary);
+    std::string corpus((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    CHECK(corpus.size() == GOLDEN_CHARS);
+
+    TinyGPSPlus gps;
+    for (char c : corpus) {
+        gps.encode(c);
+    }
+
+    printf("golden: %u chars, %u passed, %u failed, %u with fix\n", (unsigned)gps.charsProcessed(), (unsigned)gps.passedChecksum(),
+           (unsigned)gps.failedChecksum(), (unsigned)gps.sentencesWithFix());
+    CHECK(gps.charsProcessed() == GOLDEN_CHARS);
+    CHECK(gps.passedChecksum() == GOLDEN_PASSED);
+    CHECK(gps.failedChecksum() == GOLDEN_FAILED);
+    CHECK(gps.sentencesWithFix() == GOLDEN_WITH_FIX);
+
+    // CWD-- the corpus ends on a clean fix: 3746.33417N 12223.65601W at 17:07:06 on 19/10/26
+    CHECK(gps.location.isValid() && gps.date.isValid() && gps.time.isValid());
+    CHECK(gps.location.rawLat().deg == 37 && gps.location.rawLat().billionths == 772236167 && !gps.location.rawLat().negative);
+    CHECK(gps.location.rawLng().deg == 122 && gps.location.rawLng().billionths == 394266833 && gps.location.rawLng().negative);
+    CHECK(gps.date.value() == 191026 && gps.time.value() == 17070600);
+    CHECK(gps.satellites.value() == 11 && gps.hdop.value() == 90);
+}
+
+// CWD-- what the generated corpus should make the parser count, tallied as it's written
+struct CorpusTally {
+    uint32_t passed = 0;
+    uint32_t failed = 0;
+    uint32_t withFix = 0;
+};
+
+class NmeaCorpus {
+  public:
+    explicit NmeaCorpus(uint32_t seed) : rng(seed) {}
+
+    // CWD-- a clean sentence, or with its checksum or body corrupted, or cut off before the '*'
+    enum Damage { CLEAN, BAD_CHECKSUM, BAD_BODY, TRUNCATED };
+
+    void sentence(Damage damage, bool blnFix, const char *fmt, ...) {
+        char body[120];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(body, sizeof(body), fmt, args);
+        va_end(args);
+
+        uint8_t parity = 0;
+        for (const char *p = body; *p; p++) {
+            parity ^= *p;
+        }
+
+        size_t length = strlen(body);
+        if (damage == BAD_BODY) {
+            char *digit = strpbrk(body + 6, "0123456789");
+            *digit = *digit == '7' ? '3' : '7';
+        } else if (damage == BAD_CHECKSUM) {
+            parity ^= 0x5A;
+        } else if (damage == TRUNCATED) {
+            length /= 2;
+        }
+
+        char line[140];
+        int n = damage == TRUNCATED ? snprintf(line, sizeof(line), "$%.*s\r\n", (int)length, body) : snprintf(line, sizeof(line), "$%s*%02X\r\n", body, parity);
+        data.append(line, n);
+
+        if (damage == CLEAN) {
+            tally.passed++;
+            tally.withFix += blnFix;
+        } else if (damage != TRUNCATED) {
+            tally.failed++;
+        }
+    }
+
+    Damage damage() {
+        float r = (rng.noise() + 1) / 2;
+        return r < 0.01f ? BAD_CHECKSUM : r < 0.02f ? BAD_BODY : r < 0.03f ? TRUNCATED : CLEAN;
+    }
+
+    static void ddmm(int32_t e7, bool blnLat, char *buf, size_t len) {
+        double degrees = fabs(e7 / 1e7);
+        int whole = (int)degrees;
+        int n = snprintf(buf, len, blnLat ? "%02d%08.5f,%c" : "%03d%08.5f,%c", whole, (degrees - whole) * 60,
+                         blnLat ? (e7 < 0 ? 'S' : 'N') : (e7 < 0 ? 'W' : 'E'));
+        CHECK(n > 0 && (size_t)n < len); // CWD-- at most "dddmm.mmmmm,H" for any real coordinate
+    }
+
+    // CWD-- one receiver epoch: RMC + GGA from a GPS-only or multi-GNSS talker, VTG, and every few seconds
+    // the GSA/GSV constellation chatter from four systems
+    void epoch(const ReplayFix &fix, uint32_t second) {
+        static const char *const talkers[] = {"GP", "GL", "GA", "GB"};
+        char lat[20], lon[20], hms[12];
+        ddmm(fix.point.lat, true, lat, sizeof(lat));
+        ddmm(fix.point.lon, false, lon, sizeof(lon));
+        snprintf(hms, sizeof(hms), "%02u%02u%02u.00", second / 3600 % 24, second / 60 % 60, second % 60);
+        const char *talker = second % 3 ? "GN" : "GP";
+        float knots = fix.speed / 0.514444f;
+
+        sentence(damage(), true, "%sRMC,%s,A,%s,%s,%.3f,%.2f,191026,,,A", talker, hms, lat, lon, knots, fix.course);
+        sentence(damage(), true, "%sGGA,%s,%s,%s,1,%02d,%.2f,%.1f,M,-29.9,M,,", talker, hms, lat, lon, 9, fix.hdop / 100.0f, 21.5f);
+        sentence(damage(), false, "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A", fix.course, knots, fix.speed * 3.6f);
+        if (second % 4 == 0) {
+            sentence(damage(), false, "GNGSA,A,3,05,13,15,18,20,24,29,,,,,,1.45,0.82,1.20");
+            for (const char *gsv : talkers) {
+                for (int m = 1; m <= 3; m++) {
+                    sentence(damage(), false, "%sGSV,3,%d,12,%02d,%02d,%03d,%02d,%02d,%02d,%03d,%02d,%02d,%02d,%03d,,%02d,%02d,%03d,%02d", gsv, m,
+                             m * 7, 40 + m, 100 + m * 20, 30 + m, m * 7 + 1, 20 + m, 200 + m, 28, m * 7 + 2, 10 + m, 300 + m, m * 7 + 3, 60,
+                             m * 50, 41);
+                }
+            }
+        }
+    }
+
+    std::string data;
+    CorpusTally tally;
+
+  private:
+    TrackReplay rng;
+};
+
+static void benchGeneratedCorpus() {
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    NmeaCorpus corpus(38);
+    uint32_t second = 17 * 3600;
+    while (corpus.data.size() < 4 * 1024 * 1024) {
+        for (const ReplayFix &fix : fixes) {
+            corpus.epoch(fix, second++);
+        }
+    }
+
+    TinyGPSPlus gps;
+    double seconds = benchSeconds([&] {
+        for (char c : corpus.data) {
+            gps.encode(c);
+        }
+    });
+
+    printf("generated: %.1f MB, %u passed, %u failed, %u with fix; %.1f MB/s, %.1f ns/char\n", corpus.data.size() / 1048576.0,
+           (unsigned)gps.passedChecksum(), (unsigned)gps.failedChecksum(), (unsigned)gps.sentencesWithFix(), corpus.data.size() / seconds / 1048576.0,
+           seconds * 1e9 / corpus.data.size());
+    CHECK(gps.charsProcessed() == corpus.data.size());
+    CHECK(gps.passedChecksum() == corpus.tally.passed);
+    CHECK(gps.failedChecksum() == corpus.tally.failed);
+    CHECK(gps.sentencesWithFix() == corpus.tally.withFix);
+}
+
+int main() {
+    testGoldenCorpus();
+    benchGeneratedCorpus();
+    return testResult();
+}
@@ -0,0 +1,113 @@
+// CWD-- the urgent backlog drains ahead of bulk records deferred for signal, and live urgent
+// records wait behind queued ones so the cloud sees them in order
+#include "PublishScheduler.h"
+#include "TestHarness.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+static void wipe(const char *directory) {
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            unlink((std::string(directory) + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+}
+
+static bool startsWith(const std::string &str, const char *prefix) { return str.compare(0, strlen(prefix), prefix) == 0; }
+
+static void testUrgentFirst() {
+    wipe(TELEMETRY_QUEUE_DIR "/urgent");
+    wipe(TELEMETRY_QUEUE_DIR "/bulk");
+    Particle.published.clear();
+    Particle.blnConnected = false;
+    WiFi.iRSSI = -105; // CWD-- too weak for bulk
+    Time.setTime(1760000000);
+    hostSetMillis(0);
+
+    PublishScheduler scheduler;
+    scheduler.begin();
+
+    // CWD-- an outage: bulk track batches first, then urgent events behind them
+    CHECK(scheduler.send("trk", "{\"b\":1}", PUBLISH_BULK));
+    CHECK(scheduler.send("trk", "{\"b\":2}", PUBLISH_BULK));
+    CHECK(scheduler.send("geofence", "{\"u\":1}", PUBLISH_URGENT));
+    CHECK(scheduler.getQueued() == 3);
+    CHECK(Particle.published.empty());
+
+    // CWD-- back online. A new urgent record queues behind the one from the outage instead of overtaking it
+    Particle.blnConnected = true;
+    CHECK(scheduler.send("geofence", "{\"u\":2}", PUBLISH_URGENT));
+    CHECK(Particle.published.empty());
+    CHECK(scheduler.getQueued() == 4);
+
+    unsigned long time = 1000;
+    scheduler.update(time);
+    CHECK(Particle.published.size() == 1);
+    if (Particle.published.size() == 1) {
+        const std::string &event = Particle.published[0];
+        CHECK(startsWith(event, "geofence_batch "));
+        CHECK(event.find("{\"u\":1}") < event.find("{\"u\":2}"));
+    }
+
+    // CWD-- with the urgent queue empty, live urgent records go straight out again
+    CHECK(scheduler.send("geofence", "{\"u\":3}", PUBLISH_URGENT));
+    CHECK(Particle.published.size() == 2 && Particle.published.back() == "geofence {\"u\":3}");
+
+    // CWD-- the bulk records wait for signal, up to the defer limit
+    for (time += SCHED_DRAIN_INTERVAL; time < 1000 + SCHED_MAX_DEFER; time += SCHED_DRAIN_INTERVAL) {
+        scheduler.update(time);
+    }
+    CHECK(Particle.published.size() == 2);
+    scheduler.update(time + SCHED_DRAIN_INTERVAL);
+    CHECK(Particle.published.size() == 3);
+    CHECK(startsWith(Particle.published.back(), "trk_batch "));
+    CHECK(scheduler.getQueued() == 0);
+}
+
+static void testGoodSignal() {
+    wipe(TELEMETRY_QUEUE_DIR "/urgent");
+    wipe(TELEMETRY_QUEUE_DIR "/bulk");
+    Particle.published.clear();
+    Particle.blnConnected = true;
+    WiFi.iRSSI = -70;
+
+    PublishScheduler scheduler;
+    scheduler.begin();
+    for (int i = 0; i < 20; i++) {
+        char data[32];
+        snprintf(data, sizeof(data), "{\"b\":%d}", i);
+        CHECK(scheduler.send("trk", data, PUBLISH_BULK));
+    }
+    scheduler.update(1000);
+    CHECK(Particle.published.size() == 1);
+    CHECK(scheduler.getQueued() == 0);
+    CHECK(scheduler.getRecordsPerEvent() == 20);
+}
+
+// CWD-- no signal sample while the locator's worker owns the modem; it's taken as soon as the scan is done
+static void testModemBusy() {
+    wipe(TELEMETRY_QUEUE_DIR "/urgent");
+    wipe(TELEMETRY_QUEUE_DIR "/bulk");
+    WiFi.iRSSI = -70;
+
+    PublishScheduler scheduler;
+    scheduler.begin();
+    scheduler.update(1000, true);
+    CHECK(scheduler.getRSSI() == 0);
+    scheduler.update(1001, false);
+    CHECK(scheduler.getRSSI() == -70);
+}
+
+int main() {
+    testUrgentFirst();
+    testGoodSignal();
+    testModemBusy();
+    return testResult();
+}
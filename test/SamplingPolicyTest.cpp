@@ -0,0 +1,125 @@
+// CWD-- the sampling policy's time, distance, heading and parked triggers and its min-interval floor, on their own
+// and over the replayed drive, and runtime tuning that rejects bad input and leaves the policy untouched
+#include "SamplingPolicy.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+#include <string.h>
+
+static void testConfigure() {
+    SamplingPolicy policy(15000);
+    String defaults = policy.describe();
+
+    CHECK(policy.configure("") == 0);
+    CHECK(policy.configure("min=2000,max=30000,dist=150,heading=15,parked=600000") == 5);
+    CHECK(strncmp(policy.describe().c_str(), "min=2000,max=30000,dist=150,heading=15,parked=600000;", 52) == 0);
+
+    String tuned = policy.describe();
+    const char *rejected[] = {"min=abc", "min=", "min=-5", "min=10x", "dist", "speed=5", "min=2000,bogus=1", "min=0", "dist=0",
+                              "heading=0", "heading=270", "parked=0", "max=500", "min=40000", "dist=100,min=0",
+                              "max=99999999999999999999999", "parked=4294967296", "max=86400001"};
+    for (const char *params : rejected) {
+        int result = policy.configure(params);
+        if (result >= 0 || policy.describe() != tuned) {
+            printf("accepted \"%s\" (%d)\n", params, result);
+        }
+        CHECK(result < 0);
+        CHECK(policy.describe() == tuned);
+    }
+    CHECK(policy.configure("min=abc") == POLICY_ERR_SYNTAX);
+    CHECK(policy.configure("max=500") == POLICY_ERR_RANGE);
+    CHECK(policy.configure("max=99999999999999999999999") == POLICY_ERR_RANGE); // CWD-- strtoul overflow
+    CHECK(policy.configure("parked=86400000") == 1);
+
+    // CWD-- the max/min check applies to the combined result, so both can move together
+    CHECK(policy.configure("min=70000,max=90000") == 2);
+    CHECK(defaults != policy.describe());
+}
+
+static GeoPoint offset(const GeoPoint &from, double north, double east) {
+    return TrackReplay::toPoint(from.latitude(), from.longitude(), north, east);
+}
+
+static void testTriggers() {
+    SamplingPolicy policy(15000);
+    policy.setMotionState(MOTION_MOVING);
+    GeoPoint origin = GeoPoint::fromDegrees(37.7749, -122.4194);
+
+    CHECK(policy.shouldPublish(origin, 90, 10, 1000)); // CWD-- nothing published yet
+    policy.published(origin, 90, 1000, 32);
+
+    // CWD-- the floor holds back even a big jump
+    CHECK(!policy.shouldPublish(offset(origin, 1000, 0), 180, 10, 1000 + POLICY_MIN_INTERVAL - 1));
+
+    // CWD-- distance
+    unsigned long time = 1000 + POLICY_MIN_INTERVAL;
+    CHECK(!policy.shouldPublish(offset(origin, POLICY_DISTANCE_M - 1, 0), 90, 10, time));
+    CHECK(policy.shouldPublish(offset(origin, POLICY_DISTANCE_M + 1, 0), 90, 10, time));
+
+    // CWD-- heading, only above walking pace, and across north
+    CHECK(!policy.shouldPublish(origin, 90 + POLICY_HEADING_DEG - 1, 10, time));
+    CHECK(policy.shouldPublish(origin, 90 + POLICY_HEADING_DEG + 1, 10, time));
+    CHECK(!policy.shouldPublish(origin, 90 + POLICY_HEADING_DEG + 1, POLICY_HEADING_MIN_SPEED - 0.5f, time));
+    policy.published(origin, 350, time, 32);
+    time += POLICY_MIN_INTERVAL;
+    CHECK(!policy.shouldPublish(origin, 350 + POLICY_HEADING_DEG - 1 - 360, 10, time));
+    CHECK(policy.shouldPublish(origin, 350 + POLICY_HEADING_DEG + 1 - 360, 10, time));
+
+    // CWD-- time, with nothing else changing
+    CHECK(!policy.shouldPublish(origin, 350, 10, time - POLICY_MIN_INTERVAL + POLICY_MAX_INTERVAL - 1));
+    CHECK(policy.shouldPublish(origin, 350, 10, time - POLICY_MIN_INTERVAL + POLICY_MAX_INTERVAL));
+
+    // CWD-- parked or idling only the heartbeat counts, however far the fix wanders
+    time -= POLICY_MIN_INTERVAL;
+    for (MotionState state : {MOTION_PARKED, MOTION_IDLING}) {
+        policy.setMotionState(state);
+        CHECK(!policy.shouldPublish(offset(origin, 1000, 0), 0, 10, time + POLICY_MAX_INTERVAL));
+        CHECK(!policy.shouldPublish(origin, 350, 0, time + POLICY_PARKED_INTERVAL - 1));
+        CHECK(policy.shouldPublish(origin, 350, 0, time + POLICY_PARKED_INTERVAL));
+    }
+}
+
+// CWD-- the whole drive at 1 Hz, parked whenever the vehicle is standing
+static void testReplay() {
+    TrackReplay replay;
+    SamplingPolicy policy(15000);
+    std::vector<ReplayFix> fixes = replay.drive();
+
+    size_t points = 0, parkedPoints = 0;
+    unsigned long lastTime = 0, minGap = ~0UL, maxMovingGap = 0;
+    bool stopped = false; // CWD-- stood still since the last publish, so the gap isn't a moving one
+    for (const ReplayFix &fix : fixes) {
+        MotionState state = fix.speed < 0.5f ? MOTION_PARKED : MOTION_MOVING;
+        policy.setMotionState(state);
+        stopped |= state == MOTION_PARKED;
+        if (!policy.shouldPublish(fix.point, fix.course, fix.speed, fix.time)) {
+            continue;
+        }
+        if (points > 0) {
+            minGap = min(minGap, fix.time - lastTime);
+            if (!stopped) {
+                maxMovingGap = max(maxMovingGap, fix.time - lastTime);
+            }
+        }
+        parkedPoints += state == MOTION_PARKED;
+        policy.published(fix.point, fix.course, fix.time, 32);
+        lastTime = fix.time;
+        stopped = false;
+        points++;
+    }
+
+    printf("replay: %u fixes, %u published (%u parked), %.0f m/point, gaps from %lu ms, at most %lu ms while moving\n", (unsigned)fixes.size(),
+           (unsigned)points, (unsigned)parkedPoints, policy.getMetersPerPoint(), minGap, maxMovingGap);
+    CHECK(minGap >= POLICY_MIN_INTERVAL);
+    CHECK(maxMovingGap <= POLICY_MAX_INTERVAL + 1100); // CWD-- the first fix at or past the limit
+    CHECK(parkedPoints <= 3);                          // CWD-- the first fix, and stops shorter than the heartbeat
+    CHECK(policy.getMetersPerPoint() > 100 && policy.getMetersPerPoint() <= 1.1f * POLICY_DISTANCE_M);
+    CHECK(points < fixes.size() / 5);
+}
+
+int main() {
+    testTriggers();
+    testReplay();
+    testConfigure();
+    return testResult();
+}
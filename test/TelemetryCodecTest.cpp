@@ -0,0 +1,269 @@
+// CWD-- TelemetryCodec records round-trip through the Z85 text transport, malformed input is rejected,
+// and the published bytes beat the JSON records by more than 5x on recorded CAN frames and a replayed drive
+#include "JsonWriter.h"
+#include "TelemetryCodec.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define BENCH_CAN_INTERVAL_MS 5000 // CWD-- FleetTracker's PUBLISHING_INTERVAL
+#define BENCH_UNIX_MS 1760000000000ULL
+
+static uint32_t ulSeed = 7;
+
+static uint8_t randomByte() {
+    ulSeed = ulSeed * 1664525UL + 1013904223UL;
+    return ulSeed >> 24;
+}
+
+static void testBase85() {
+    // CWD-- the reference vector from the Z85 spec
+    const uint8_t hello[] = {0x86, 0x4F, 0xD2, 0x6F, 0xB5, 0x59, 0xF7, 0x5B};
+    char text[64];
+    CHECK(TelemetryCodec::base85Encode(hello, sizeof(hello), text, sizeof(text)) == 10);
+    CHECK(strcmp(text, "HelloWorld") == 0);
+
+    // CWD-- every short final group length, with all-ones bytes where the rounding is tightest
+    uint8_t buf[48], decoded[48];
+    for (size_t len = 0; len <= 40; len++) {
+        for (int fill = 0; fill < 3; fill++) {
+            for (size_t i = 0; i < len; i++) {
+                buf[i] = fill == 0 ? randomByte() : fill == 1 ? 0xFF : 0x00;
+            }
+            size_t chars = TelemetryCodec::base85Encode(buf, len, text, sizeof(text));
+            CHECK(chars == len / 4 * 5 + (len % 4 ? len % 4 + 1 : 0));
+            CHECK(TelemetryCodec::base85Decode(text, chars, decoded, sizeof(decoded)) == len);
+            CHECK(memcmp(buf, decoded, len) == 0);
+        }
+    }
+
+    CHECK(TelemetryCodec::base85Encode(hello, sizeof(hello), text, 10) == 0); // CWD-- no room for the null
+    CHECK(TelemetryCodec::base85Decode("Hello", 5, decoded, 3) == 0);
+    CHECK(TelemetryCodec::base85Decode("Hel\"o", 5, decoded, sizeof(decoded)) == 0);
+    CHECK(TelemetryCodec::base85Decode("%%%%%", 5, decoded, sizeof(decoded)) == 0); // CWD-- over 32 bits
+    CHECK(TelemetryCodec::base85Decode("Hello1", 6, decoded, sizeof(decoded)) == 0);
+}
+
+static void testVarint() {
+    const uint64_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 0xFFFFFFFFULL, 1ULL << 63, ~0ULL};
+    uint8_t buf[16];
+    for (uint64_t value : values) {
+        size_t n = TelemetryCodec::putVarint(value, buf, sizeof(buf));
+        uint64_t decoded;
+        CHECK(n > 0 && n <= 10);
+        CHECK(TelemetryCodec::getVarint(buf, n, decoded) == n && decoded == value);
+        CHECK(TelemetryCodec::getVarint(buf, n - 1, decoded) == 0);
+        CHECK(TelemetryCodec::putVarint(value, buf, n - 1) == 0);
+    }
+
+    memset(buf, 0x80, sizeof(buf));
+    uint64_t decoded;
+    CHECK(TelemetryCodec::getVarint(buf, sizeof(buf), decoded) == 0); // CWD-- overlong
+
+    const int64_t signedValues[] = {0, -1, 1, -64, 64, INT32_MIN, INT32_MAX, INT64_MIN, INT64_MAX};
+    for (int64_t value : signedValues) {
+        CHECK(TelemetryCodec::unzigzag(TelemetryCodec::zigzag(value)) == value);
+    }
+    CHECK(TelemetryCodec::zigzag(-1) == 1 && TelemetryCodec::zigzag(1) == 2);
+}
+
+static void testRecords() {
+    TelemetryGPSRecord gps;
+    gps.time = BENCH_UNIX_MS + 123;
+    gps.lat = -337654321;
+    gps.lon = 1511234567;
+    gps.altitude = -152;
+    gps.speed = 3105;
+    gps.satellites = 11;
+    gps.source = 2;
+
+    uint8_t buf[TELEMETRY_CAN_BATCH_BYTES];
+    size_t len = TelemetryCodec::encodeGPS(gps, buf, sizeof(buf));
+    CHECK(len > 0 && len <= TELEMETRY_RECORD_MAX);
+    CHECK(TelemetryCodec::recordType(buf, len) == TELEMETRY_RECORD_GPS);
+
+    char text[320];
+    CHECK(TelemetryCodec::toText(buf, len, text, sizeof(text)) == strlen(text));
+    CHECK(text[0] == '"' && text[1] == TELEMETRY_TEXT_PREFIX && text[strlen(text) - 1] == '"');
+    CHECK(strpbrk(text + 1, "\"\\") == text + strlen(text) - 1); // CWD-- safe inside a JSON string
+
+    uint8_t decoded[TELEMETRY_CAN_BATCH_BYTES];
+    TelemetryGPSRecord gpsOut;
+    CHECK(TelemetryCodec::fromText(text, decoded, sizeof(decoded)) == len);
+    CHECK(TelemetryCodec::decodeGPS(decoded, len, gpsOut));
+    CHECK(gpsOut.time == gps.time && gpsOut.lat == gps.lat && gpsOut.lon == gps.lon && gpsOut.altitude == gps.altitude);
+    CHECK(gpsOut.speed == gps.speed && gpsOut.satellites == gps.satellites && gpsOut.source == gps.source);
+    std::string unquoted(text + 1, strlen(text) - 2);
+    CHECK(TelemetryCodec::fromText(unquoted.c_str(), decoded, sizeof(decoded)) == len);
+    for (size_t cut = 0; cut < len; cut++) {
+        CHECK(!TelemetryCodec::decodeGPS(decoded, cut, gpsOut));
+    }
+    CHECK(TelemetryCodec::encodeGPS(gps, buf, len - 1) == 0);
+
+    // CWD-- a lone CAN frame as older firmware encoded it: header, varint time, id and length, raw payload
+    const uint8_t single[] = {(1 << 4) | TELEMETRY_RECORD_CAN, 0x80, 0x80, 0xB3, 0xC1, 0x9C, 0x33, 0xE8, 0x0F, 0x08,
+                              0x04, 0x41, 0x0C, 0x1A, 0xF8, 0x00, 0x00, 0x00};
+    TelemetryCANRecord canOut;
+    CHECK(TelemetryCodec::decodeCAN(single, sizeof(single), canOut));
+    CHECK(canOut.time == BENCH_UNIX_MS && canOut.id == 0x7E8 && canOut.length == 8 && memcmp(canOut.data, single + 10, 8) == 0);
+    CHECK(!TelemetryCodec::decodeGPS(single, sizeof(single), gpsOut));
+    for (size_t cut = 0; cut < sizeof(single); cut++) {
+        CHECK(!TelemetryCodec::decodeCAN(single, cut, canOut));
+    }
+
+    // CWD-- a batch, including a frame that arrived out of order and a short one
+    TelemetryCANRecord frames[TELEMETRY_CAN_BATCH_MAX];
+    for (size_t i = 0; i < TELEMETRY_CAN_BATCH_MAX; i++) {
+        frames[i].time = BENCH_UNIX_MS + i * BENCH_CAN_INTERVAL_MS - (i == 3 ? 7000 : 0);
+        frames[i].id = i == 5 ? 0x18DAF110 : 0x100 + i;
+        frames[i].length = i == 2 ? 3 : 8;
+        for (size_t j = 0; j < 8; j++) {
+            frames[i].data[j] = randomByte();
+        }
+    }
+    len = TelemetryCodec::encodeCANBatch(frames, TELEMETRY_CAN_BATCH_MAX, buf, sizeof(buf));
+    CHECK(len > 0 && len <= TELEMETRY_CAN_BATCH_BYTES);
+    CHECK(TelemetryCodec::toText(buf, len, text, sizeof(text)) > 0);
+    CHECK(TelemetryCodec::fromText(text, decoded, sizeof(decoded)) == len);
+
+    TelemetryCANRecord framesOut[TELEMETRY_CAN_BATCH_MAX];
+    CHECK(TelemetryCodec::decodeCANBatch(decoded, len, framesOut, TELEMETRY_CAN_BATCH_MAX) == TELEMETRY_CAN_BATCH_MAX);
+    for (size_t i = 0; i < TELEMETRY_CAN_BATCH_MAX; i++) {
+        CHECK(framesOut[i].time == frames[i].time && framesOut[i].id == frames[i].id && framesOut[i].length == frames[i].length);
+        CHECK(memcmp(framesOut[i].data, frames[i].data, frames[i].length) == 0);
+    }
+    for (size_t cut = 0; cut < len; cut++) {
+        CHECK(TelemetryCodec::decodeCANBatch(decoded, cut, framesOut, TELEMETRY_CAN_BATCH_MAX) == 0);
+    }
+    CHECK(TelemetryCodec::decodeCANBatch(decoded, len, framesOut, TELEMETRY_CAN_BATCH_MAX - 1) == 0);
+    CHECK(TelemetryCodec::encodeCANBatch(frames, 0, buf, sizeof(buf)) == 0);
+    CHECK(TelemetryCodec::encodeCANBatch(frames, TELEMETRY_CAN_BATCH_MAX + 1, buf, sizeof(buf)) == 0);
+    CHECK(TelemetryCodec::encodeCANBatch(frames, TELEMETRY_CAN_BATCH_MAX, buf, len - 1) == 0);
+
+    // CWD-- a record from a newer codec isn't mistaken for one this decoder knows
+    decoded[0] = ((TELEMETRY_CODEC_VERSION + 1) << 4) | TELEMETRY_RECORD_CAN_BATCH;
+    CHECK(TelemetryCodec::recordType(decoded, len) == -1);
+    CHECK(TelemetryCodec::decodeCANBatch(decoded, len, framesOut, TELEMETRY_CAN_BATCH_MAX) == 0);
+}
+
+// CWD-- "0x4CE\t0x0F\t0x00..." per line: the id, then the payload bytes
+static std::vector<TelemetryCANRecord> loadFrames() {
+    std::vector<TelemetryCANRecord> frames;
+    std::ifstream file("../__test__/sienna.csv");
+    std::string line;
+    uint64_t time = BENCH_UNIX_MS;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string field;
+        TelemetryCANRecord frame;
+        if (!(fields >> field)) {
+            continue;
+        }
+        frame.id = strtoul(field.c_str(), nullptr, 16);
+        memset(frame.data, 0, sizeof(frame.data));
+        for (size_t i = 0; i < TELEMETRY_CAN_DATA_MAX && fields >> field; i++) {
+            frame.data[i] = strtoul(field.c_str(), nullptr, 16);
+        }
+        frame.length = TELEMETRY_CAN_DATA_MAX; // CWD-- FleetTracker always sends the whole CAN_DATA_BUFFER_SIZE
+        time += BENCH_CAN_INTERVAL_MS + (randomByte() % 40);
+        frame.time = time;
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// CWD-- the JSON records FleetTracker publishes with PUBLISH_BINARY off, built the same way
+static size_t jsonCAN(const TelemetryCANRecord &frame, char *buf, size_t len) {
+    JsonWriter json(buf, len);
+    json.beginObject().key("id").hex(frame.id).key("data").beginArray();
+    for (size_t i = 0; i < frame.length; i++) {
+        json.hex(frame.data[i]);
+    }
+    json.endArray().key("ts").number(frame.time).endObject();
+    return json.length();
+}
+
+static size_t jsonGPS(const TelemetryGPSRecord &record, char *buf, size_t len) {
+    JsonWriter json(buf, len);
+    json.beginObject().key("longitude").fixed(record.lon, 7).key("latitude").fixed(record.lat, 7);
+    json.key("altitude").fixed(lround(record.altitude / 3.048 * 100), 2).key("speed").fixed(lround(record.speed / 44.704 * 100), 2);
+    json.key("satellites").number(record.satellites).key("date").string("2026/10/19").key("time").string("17:07:06");
+    json.key("source").string("g").key("ts").number(record.time).endObject();
+    return json.length();
+}
+
+static void benchCAN() {
+    std::vector<TelemetryCANRecord> frames = loadFrames();
+    CHECK(frames.size() > 900);
+
+    size_t jsonBytes = 0, batchBytes = 0;
+    char json[256], text[320];
+    uint8_t buf[TELEMETRY_CAN_BATCH_BYTES];
+    for (const TelemetryCANRecord &frame : frames) {
+        jsonBytes += jsonCAN(frame, json, sizeof(json));
+    }
+
+    size_t batches = 0;
+    double seconds = benchSeconds([&] {
+        for (size_t i = 0; i < frames.size(); i += TELEMETRY_CAN_BATCH_MAX) {
+            size_t count = min((size_t)TELEMETRY_CAN_BATCH_MAX, frames.size() - i);
+            size_t len = TelemetryCodec::encodeCANBatch(&frames[i], count, buf, sizeof(buf));
+            batchBytes += TelemetryCodec::toText(buf, len, text, sizeof(text));
+            batches++;
+        }
+    });
+
+    double perFrameJson = (double)jsonBytes / frames.size();
+    printf("CAN: %u frames, JSON %.1f B/frame, batch of %d %.1f B/frame (%.1fx), %.2f us/batch\n", (unsigned)frames.size(),
+           perFrameJson, TELEMETRY_CAN_BATCH_MAX, (double)batchBytes / frames.size(), (double)jsonBytes / batchBytes, seconds * 1e6 / batches);
+    CHECK((double)jsonBytes / batchBytes > 5.0);
+}
+
+static void benchGPS() {
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+
+    size_t jsonBytes = 0, binaryBytes = 0;
+    char json[256], text[64];
+    uint8_t buf[TELEMETRY_RECORD_MAX];
+    double seconds = benchSeconds([&] {
+        for (const ReplayFix &fix : fixes) {
+            TelemetryGPSRecord record;
+            record.time = BENCH_UNIX_MS + fix.time;
+            record.lat = fix.point.lat;
+            record.lon = fix.point.lon;
+            record.altitude = 152;
+            record.speed = lround(fix.speed * 100);
+            record.satellites = 9;
+            record.source = 1;
+            binaryBytes += TelemetryCodec::toText(buf, TelemetryCodec::encodeGPS(record, buf, sizeof(buf)), text, sizeof(text));
+            benchKeep(text);
+        }
+    });
+    for (const ReplayFix &fix : fixes) {
+        TelemetryGPSRecord record;
+        record.time = BENCH_UNIX_MS + fix.time;
+        record.lat = fix.point.lat;
+        record.lon = fix.point.lon;
+        record.altitude = 152;
+        record.speed = lround(fix.speed * 100);
+        record.satellites = 9;
+        jsonBytes += jsonGPS(record, json, sizeof(json));
+    }
+
+    printf("GPS: %u fixes, JSON %.1f B/fix, binary %.1f B/fix (%.1fx), %.2f us/fix\n", (unsigned)fixes.size(), (double)jsonBytes / fixes.size(),
+           (double)binaryBytes / fixes.size(), (double)jsonBytes / binaryBytes, seconds * 1e6 / fixes.size());
+    CHECK((double)jsonBytes / binaryBytes > 5.0);
+}
+
+int main() {
+    testBase85();
+    testVarint();
+    testRecords();
+    benchCAN();
+    benchGPS();
+    return testResult();
+}
@@ -0,0 +1,290 @@
+// CWD-- the flash queue only ever appends, unlinks drained segments, survives resets and torn writes,
+// and skips corrupt records the same way in peek(), peekAt() and pop()
+#include "TelemetryQueue.h"
+#include "TestHarness.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define QUEUE_DIR TELEMETRY_QUEUE_DIR "/queue"
+
+static void wipe() {
+    mkdir(TELEMETRY_QUEUE_DIR, 0755);
+    DIR *dir = opendir(QUEUE_DIR);
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            unlink((std::string(QUEUE_DIR "/") + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+}
+
+static int countSegments() {
+    DIR *dir = opendir(QUEUE_DIR);
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        count += strlen(entry->d_name) == 8;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void segmentPath(uint32_t number, char *path, size_t len) { snprintf(path, len, "%s/%08lx", QUEUE_DIR, (unsigned long)number); }
+
+static void record(int index, char *data, size_t len) { snprintf(data, len, "{\"i\":%d,\"pad\":\"%0150d\"}", index, index); }
+
+// CWD-- the i field of the record at index, -1 if there isn't one
+static int peekIndex(TelemetryQueue &queue, size_t index) {
+    char event[TELEMETRY_EVENT_MAX], data[TELEMETRY_DATA_MAX + 1];
+    uint8_t flags;
+    uint32_t time;
+    if (!queue.peekAt(index, event, sizeof(event), data, sizeof(data), flags, time)) {
+        return -1;
+    }
+    return atoi(data + 5);
+}
+
+static void pushRange(TelemetryQueue &queue, int from, int to) {
+    char data[256];
+    for (int i = from; i < to; i++) {
+        record(i, data, sizeof(data));
+        CHECK(queue.push("trk", data, 0, 1000 + i));
+    }
+}
+
+static void testFifo() {
+    wipe();
+    TelemetryQueue queue(QUEUE_DIR, 16);
+    CHECK(queue.begin());
+    CHECK(queue.isEmpty());
+
+    pushRange(queue, 0, 100);
+    CHECK(queue.size() == 100);
+    CHECK(queue.getSegments() > 2);
+    CHECK(countSegments() == (int)queue.getSegments());
+
+    char event[TELEMETRY_EVENT_MAX], data[TELEMETRY_DATA_MAX + 1];
+    uint8_t flags;
+    uint32_t time;
+    CHECK(queue.peek(event, sizeof(event), data, sizeof(data), flags, time));
+    CHECK(strcmp(event, "trk") == 0 && time == 1000 && atoi(data + 5) == 0);
+    CHECK(peekIndex(queue, 1) == 1);
+    CHECK(peekIndex(queue, 99) == 99);
+    CHECK(peekIndex(queue, 100) == -1);
+
+    // CWD-- batches straddling segment boundaries; each drained segment is unlinked, the newest one stays
+    for (int next = 0; next < 100; next += 7) {
+        CHECK(peekIndex(queue, 0) == next);
+        for (int i = 1; i < 7 && next + i < 100; i++) {
+            CHECK(peekIndex(queue, i) == next + i);
+        }
+        queue.pop(min(7, 100 - next));
+    }
+    CHECK(queue.isEmpty());
+    CHECK(queue.getSegments() == 1);
+    CHECK(countSegments() == 1);
+
+    // CWD-- packing stops on the record that didn't fit, one past what gets popped
+    pushRange(queue, 100, 110);
+    CHECK(peekIndex(queue, 0) == 100 && peekIndex(queue, 1) == 101 && peekIndex(queue, 2) == 102 && peekIndex(queue, 3) == 103);
+    queue.pop(3);
+    CHECK(peekIndex(queue, 0) == 103);
+    CHECK(queue.size() == 7);
+}
+
+static void testOverflow() {
+    wipe();
+    TelemetryQueue queue(QUEUE_DIR, 4);
+    CHECK(queue.begin());
+
+    pushRange(queue, 0, 400);
+    CHECK(queue.getSegments() == 4);
+    CHECK(countSegments() == 4);
+    CHECK(queue.getOverwritten() > 0);
+    CHECK(queue.size() + queue.getOverwritten() == 400);
+    CHECK(peekIndex(queue, 0) == (int)queue.getOverwritten());
+    CHECK(peekIndex(queue, queue.size() - 1) == 399);
+}
+
+static void testReset() {
+    wipe();
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        pushRange(queue, 0, 120);
+        queue.pop(60);
+        queue.pop(3); // CWD-- short of an ack batch, so these are sent again after the reset
+    }
+
+    TelemetryQueue queue(QUEUE_DIR, 16);
+    CHECK(queue.begin());
+    CHECK(queue.size() == 60);
+    CHECK(peekIndex(queue, 0) == 60);
+    CHECK(countSegments() == (int)queue.getSegments());
+
+    pushRange(queue, 120, 125);
+    CHECK(queue.size() == 65);
+    CHECK(peekIndex(queue, 64) == 124);
+}
+
+// CWD-- the ack is replaced whole: a failed save keeps the previous one, and a temp file left by a reset mid-save
+// is ignored and then overwritten
+static void testAck() {
+    char tempPath[256];
+    snprintf(tempPath, sizeof(tempPath), "%s/ack.tmp", QUEUE_DIR);
+    wipe();
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        pushRange(queue, 0, 60);
+        queue.pop(TELEMETRY_ACK_BATCH * 2);
+        CHECK(mkdir(tempPath, 0755) == 0); // CWD-- the temp file can't be created, so these saves fail
+        queue.pop(TELEMETRY_ACK_BATCH * 2);
+        CHECK(rmdir(tempPath) == 0);
+    }
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        CHECK(queue.size() == 60 - TELEMETRY_ACK_BATCH * 2);
+        CHECK(peekIndex(queue, 0) == TELEMETRY_ACK_BATCH * 2);
+    }
+
+    FILE *file = fopen(tempPath, "wb");
+    fputs("torn", file);
+    fclose(file);
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        CHECK(queue.size() == 60 - TELEMETRY_ACK_BATCH * 2);
+        queue.pop(TELEMETRY_ACK_BATCH);
+        CHECK(access(tempPath, F_OK) != 0);
+    }
+    TelemetryQueue queue(QUEUE_DIR, 16);
+    CHECK(queue.begin());
+    CHECK(queue.size() == 60 - TELEMETRY_ACK_BATCH * 3);
+}
+
+static void testTornWrite() {
+    wipe();
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        pushRange(queue, 0, 10);
+    }
+    char path[256];
+    segmentPath(0, path, sizeof(path));
+    struct stat info;
+    stat(path, &info);
+    CHECK(truncate(path, info.st_size - 5) == 0);
+
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        CHECK(queue.size() == 9);
+        CHECK(queue.getCorrupt() == 1);
+        pushRange(queue, 10, 12); // CWD-- goes into a new segment, not after the torn bytes
+        CHECK(queue.getSegments() == 2);
+    }
+
+    TelemetryQueue queue(QUEUE_DIR, 16);
+    CHECK(queue.begin());
+    CHECK(queue.size() == 11);
+    int expected[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 11};
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        CHECK(peekIndex(queue, i) == expected[i]);
+    }
+}
+
+static void testCorruptRecord() {
+    wipe();
+    {
+        TelemetryQueue queue(QUEUE_DIR, 16);
+        CHECK(queue.begin());
+        pushRange(queue, 0, 6);
+    }
+
+    // CWD-- flip a payload byte of record 2; the records are all the same length
+    char path[256];
+    segmentPath(0, path, sizeof(path));
+    struct stat info;
+    stat(path, &info);
+    long recordLength = info.st_size / 6;
+    int fd = open(path, O_RDWR);
+    char byte;
+    pread(fd, &byte, 1, 2 * recordLength + sizeof(TelemetryRecordHeader) + 10);
+    byte ^= 0x20;
+    pwrite(fd, &byte, 1, 2 * recordLength + sizeof(TelemetryRecordHeader) + 10);
+    close(fd);
+
+    TelemetryQueue queue(QUEUE_DIR, 16);
+    CHECK(queue.begin());
+    CHECK(peekIndex(queue, 0) == 0);
+    CHECK(peekIndex(queue, 1) == 1);
+    CHECK(peekIndex(queue, 2) == 3);
+    CHECK(peekIndex(queue, 4) == 5);
+    queue.pop(3);
+    CHECK(queue.getCorrupt() == 1);
+    CHECK(peekIndex(queue, 0) == 4);
+    CHECK(queue.size() == 2);
+
+    // CWD-- the same through pop() without peeking first: a corrupt record 0 goes along with records 1 and 2
+    wipe();
+    {
+        TelemetryQueue writer(QUEUE_DIR, 16);
+        CHECK(writer.begin());
+        pushRange(writer, 0, 6);
+    }
+    fd = open(path, O_RDWR);
+    pwrite(fd, &byte, 1, sizeof(TelemetryRecordHeader) + 10);
+    close(fd);
+    TelemetryQueue reader(QUEUE_DIR, 16);
+    CHECK(reader.begin());
+    reader.pop(2);
+    CHECK(reader.getCorrupt() == 1);
+    CHECK(peekIndex(reader, 0) == 3);
+}
+
+static void benchQueue() {
+    wipe();
+    TelemetryQueue queue(QUEUE_DIR, 16);
+    queue.begin();
+
+    const int records = 500;
+    char data[256];
+    double pushSeconds = benchSeconds([&] {
+        for (int i = 0; i < records; i++) {
+            record(i, data, sizeof(data));
+            queue.push("trk", data, 0, i);
+        }
+    });
+    double drainSeconds = benchSeconds([&] {
+        while (!queue.isEmpty()) {
+            for (size_t i = 0; i < 4; i++) {
+                benchKeep(peekIndex(queue, i));
+            }
+            queue.pop(4);
+        }
+    });
+    printf("queue: push %.1f us/record (fsync each), drain %.1f us/record, %d segments left\n", pushSeconds * 1e6 / records,
+           drainSeconds * 1e6 / records, countSegments());
+    CHECK(countSegments() == 1);
+}
+
+int main() {
+    testFifo();
+    testOverflow();
+    testReset();
+    testAck();
+    testTornWrite();
+    testCorruptRecord();
+    benchQueue();
+    wipe();
+    return testResult();
+}
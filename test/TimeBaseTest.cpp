@@ -0,0 +1,152 @@
+// CWD-- the 64-bit monotonic clock across micros() wraps, its discipline to GPS time (stepped, slewed and PPS
+// locked), the wall time it hands out before and after the first fix, and the packed unix epoch GPSManager
+// keeps for the fix's date and time
+#include "TestHarness.h"
+#include "TimeBase.h"
+
+#include "Particle.h"
+
+#define TEST_UNIX 1760000000UL
+#define TEST_PPS_PIN 2
+
+static void testWrap() {
+    hostSetMicros(0xFFFFF000ULL);
+    TimeBase clock;
+    CHECK(clock.now() == 0xFFFFF000ULL);
+    hostAdvanceMicros(0x2000);
+    CHECK(clock.now() == 0x100001000ULL);
+
+    // CWD-- called every half hour it keeps counting through several more wraps
+    uint64_t expected = 0x100001000ULL, last = 0;
+    bool blnMonotonic = true;
+    for (int i = 0; i < 8; i++) {
+        hostAdvanceMicros(1800000000ULL);
+        expected += 1800000000ULL;
+        uint64_t now = clock.now();
+        blnMonotonic = blnMonotonic && now > last && now == expected;
+        last = now;
+    }
+    CHECK(blnMonotonic && last > 4 * 0x100000000ULL);
+}
+
+static void testBeforeFix() {
+    hostSetMicros(10000000ULL);
+    TimeBase clock;
+    Time.setTime(0);
+    CHECK(!clock.isDisciplined());
+    CHECK(clock.toUnixMicros(clock.now()) == 0 && clock.unixMillis(millis()) == 0);
+
+    // CWD-- the cloud-synced clock stands in until GPS time arrives
+    Time.setTime(TEST_UNIX);
+    CHECK(clock.unixMillis(millis() - 500) == TEST_UNIX * 1000ULL - 500);
+    CHECK(clock.toUnixMicros(clock.now()) == 0);
+}
+
+static void testDiscipline() {
+    hostSetMicros(0xFFFF0000ULL); // CWD-- a wrap is coming up on the way
+    TimeBase clock;
+    Time.setTime(0);
+
+    // CWD-- the first fix steps the clock straight onto GPS time and sets the system clock
+    clock.discipline(TEST_UNIX, 50);
+    uint64_t wall = TEST_UNIX * 1000000ULL + 500000;
+    CHECK(clock.isDisciplined() && !clock.isPPSLocked());
+    CHECK(clock.toUnixMicros(clock.now()) == wall);
+    CHECK(Time.now() == (time_t)TEST_UNIX);
+    CHECK(clock.unixMillis(millis() - 250) == wall / 1000 - 250ULL);
+
+    // CWD-- a small error is slewed in an eighth at a time
+    hostAdvanceMicros(1000000);
+    wall += 1000000;
+    clock.discipline(TEST_UNIX + 1, 58);
+    CHECK(clock.toUnixMicros(clock.now()) == wall + 80000 / (1 << TIMEBASE_SLEW_SHIFT));
+    for (int i = 0; i < 60; i++) {
+        hostAdvanceMicros(1000000);
+        wall += 1000000;
+        clock.discipline((uint32_t)((wall + 80000) / 1000000), (uint8_t)((wall + 80000) / 10000 % 100));
+    }
+    CHECK_NEAR((double)(int64_t)(clock.toUnixMicros(clock.now()) - wall), 80000, 100);
+
+    // CWD-- one beyond the step threshold is taken whole
+    hostAdvanceMicros(1000000);
+    wall += 1000000 + 80000;
+    clock.discipline((uint32_t)(wall / 1000000) + 5, (uint8_t)(wall / 10000 % 100));
+    CHECK(clock.toUnixMicros(clock.now()) == wall + 5000000);
+
+    // CWD-- an earlier stamp converts by its own age, not the current time
+    uint64_t stamp = clock.now();
+    hostAdvanceMicros(3000000);
+    CHECK(clock.toUnixMicros(stamp) == wall + 5000000);
+}
+
+static void testPPS() {
+    hostSetMicros(20000123ULL);
+    TimeBase clock;
+    clock.attachPPS(TEST_PPS_PIN);
+
+    // CWD-- the edge marks the second; the sentence naming it arrives some 200ms later and jitter in that doesn't matter
+    hostFireInterrupt(TEST_PPS_PIN);
+    uint64_t edge = clock.now();
+    hostAdvanceMicros(213457);
+    clock.discipline(TEST_UNIX, 0);
+    CHECK(clock.isPPSLocked());
+    CHECK(clock.toUnixMicros(edge) == TEST_UNIX * 1000000ULL);
+
+    // CWD-- with the PPS line gone quiet it falls back to the sentence time
+    hostAdvanceMicros(2000000);
+    clock.discipline(TEST_UNIX + 2, 20);
+    CHECK(!clock.isPPSLocked() && clock.isDisciplined());
+}
+
+// CWD-- GPS date and time to the packed epoch and back to the strings GPSManager reports
+static void testEpoch() {
+    struct {
+        uint16_t year;
+        uint8_t month, day, hour, minute, second;
+        uint32_t unixSeconds;
+    } cases[] = {
+        {1970, 1, 1, 0, 0, 0, 0},
+        {2000, 2, 29, 12, 0, 0, 951825600},   // CWD-- leap day of a 400 year
+        {2000, 3, 1, 0, 0, 0, 951868800},
+        {2024, 2, 29, 23, 59, 59, 1709251199}, // CWD-- last second of a leap day...
+        {2024, 3, 1, 0, 0, 0, 1709251200},     // CWD-- ...and the next day
+        {2025, 12, 31, 23, 59, 59, 1767225599},
+        {2026, 1, 1, 0, 0, 0, 1767225600},
+        {2038, 1, 19, 3, 14, 8, 2147483648U}, // CWD-- past the signed 32-bit limit
+        {2100, 2, 28, 23, 59, 59, 4107542399U}, // CWD-- 2100 isn't a leap year
+        {2100, 3, 1, 0, 0, 0, 4107542400U},
+    };
+
+    for (const auto &c : cases) {
+        uint32_t unixSeconds = TimeBase::unixTime(c.year, c.month, c.day, c.hour, c.minute, c.second);
+        CHECK(unixSeconds == c.unixSeconds);
+
+        char date[16], time[16], expectedDate[16], expectedTime[16];
+        snprintf(expectedDate, sizeof(expectedDate), "%04u/%02u/%02u", c.year, c.month, c.day);
+        snprintf(expectedTime, sizeof(expectedTime), "%02u:%02u:%02u", c.hour, c.minute, c.second);
+        CHECK(TimeBase::formatDate(unixSeconds, date, sizeof(date)) == 10 && strcmp(date, expectedDate) == 0);
+        CHECK(TimeBase::formatTime(unixSeconds, time, sizeof(time)) == 8 && strcmp(time, expectedTime) == 0);
+        if (strcmp(date, expectedDate) != 0 || strcmp(time, expectedTime) != 0) {
+            printf("%u: %s %s, expected %s %s\n", (unsigned)unixSeconds, date, time, expectedDate, expectedTime);
+        }
+    }
+
+    // CWD-- every day boundary for four years round-trips through the civil date
+    bool blnRoundTrip = true;
+    for (uint32_t day = 19723; day < 19723 + 4 * 366; day++) { // CWD-- from 2024/01/01
+        uint16_t year;
+        uint8_t month, dayOfMonth;
+        TimeBase::civilDate(day * 86400 + 86399, year, month, dayOfMonth);
+        blnRoundTrip = blnRoundTrip && TimeBase::unixTime(year, month, dayOfMonth, 0, 0, 0) == day * 86400;
+    }
+    CHECK(blnRoundTrip);
+}
+
+int main() {
+    testWrap();
+    testBeforeFix();
+    testDiscipline();
+    testPPS();
+    testEpoch();
+    return testResult();
+}
@@ -0,0 +1,194 @@
+// CWD-- the track delta stream round-trips exactly with unix time keyframes, drops a damaged group
+// whole instead of decoding drifted positions, and its compression against the JSON track is measured on the
+// replayed drive, both raw at 1 Hz and through the simplifier the way publishTrack sends it
+#include "JsonWriter.h"
+#include "TelemetryCodec.h"
+#include "TestHarness.h"
+#include "TrackCodec.h"
+#include "TrackReplay.h"
+#include "TrackSimplifier.h"
+
+#define BENCH_UNIX_MS 1760000000000ULL
+#define BENCH_EVENT_MAX 1024 // CWD-- Particle.maxEventDataSize() on current Device OS
+
+struct Point {
+    int32_t lat;
+    int32_t lon;
+    uint64_t time;
+};
+
+static std::vector<Point> replayPoints() {
+    TrackReplay replay;
+    std::vector<Point> points;
+    for (const ReplayFix &fix : replay.drive()) {
+        points.push_back({fix.point.lat, fix.point.lon, BENCH_UNIX_MS + fix.time});
+    }
+    return points;
+}
+
+static size_t encode(const std::vector<Point> &points, size_t from, size_t count, uint8_t *buf, size_t capacity, size_t &sent) {
+    TrackEncoder encoder;
+    encoder.begin(buf, capacity);
+    for (sent = 0; sent < count && encoder.add(points[from + sent].lat, points[from + sent].lon, points[from + sent].time); sent++) {
+    }
+    return encoder.getLength();
+}
+
+static std::vector<Point> decode(const uint8_t *buf, size_t len, uint32_t *dropped = nullptr) {
+    std::vector<Point> points;
+    TrackDecoder decoder;
+    if (!decoder.begin(buf, len)) {
+        return points;
+    }
+    Point point;
+    while (decoder.next(point.lat, point.lon, point.time)) {
+        points.push_back(point);
+    }
+    if (dropped) {
+        *dropped = decoder.getDroppedGroups();
+    }
+    return points;
+}
+
+static bool samePoint(const Point &a, const Point &b) { return a.lat == b.lat && a.lon == b.lon && a.time == b.time; }
+
+static void testRoundTrip() {
+    std::vector<Point> points = replayPoints();
+    static uint8_t buf[65536];
+    size_t sent;
+    size_t len = encode(points, 0, points.size(), buf, sizeof(buf), sent);
+    CHECK(sent == points.size());
+
+    uint32_t dropped = 1;
+    std::vector<Point> decoded = decode(buf, len, &dropped);
+    CHECK(decoded.size() == points.size() && dropped == 0);
+    for (size_t i = 0; i < decoded.size() && i < points.size(); i++) {
+        CHECK(samePoint(decoded[i], points[i]));
+    }
+
+    // CWD-- keyframes carry unix time, not uptime
+    CHECK(decoded.size() > 0 && decoded[0].time > BENCH_UNIX_MS);
+
+    // CWD-- a full buffer still leaves a complete stream
+    len = encode(points, 0, points.size(), buf, 100, sent);
+    CHECK(len <= 100 && sent > 0 && sent < points.size());
+    decoded = decode(buf, len);
+    CHECK(decoded.size() == sent && samePoint(decoded.back(), points[sent - 1]));
+
+    // CWD-- version 1 streams had uptime keyframes and no CRCs
+    buf[0] = (1 << 4) | TELEMETRY_RECORD_TRACK;
+    TrackDecoder decoder;
+    CHECK(!decoder.begin(buf, len));
+}
+
+static void testDamage() {
+    std::vector<Point> points = replayPoints();
+    static uint8_t buf[4096];
+    size_t sent;
+    size_t len = encode(points, 200, 80, buf, sizeof(buf), sent);
+    CHECK(sent == 80);
+
+    // CWD-- flip each byte in turn. Whatever does come out must be an original point, in order
+    size_t wrong = 0, minDecoded = sent;
+    for (size_t i = 1; i < len; i++) {
+        for (uint8_t flip : {0x01, 0x40, 0x80}) {
+            buf[i] ^= flip;
+            std::vector<Point> decoded = decode(buf, len);
+            buf[i] ^= flip;
+
+            size_t next = 0;
+            for (const Point &point : decoded) {
+                while (next < sent && !samePoint(point, points[200 + next])) {
+                    next++;
+                }
+                wrong += next == sent;
+                next++;
+            }
+            minDecoded = min(minDecoded, decoded.size());
+        }
+    }
+    printf("damage: %u byte flips, %u bogus points, at least %u of %u points recovered\n", (unsigned)(len - 1) * 3, (unsigned)wrong,
+           (unsigned)minDecoded, (unsigned)sent);
+    CHECK(wrong == 0);
+    CHECK(minDecoded >= sent - 2 * TRACK_KEYFRAME_INTERVAL); // CWD-- at most the group hit and a neighbour it ran into
+
+    // CWD-- truncation anywhere only loses the tail
+    for (size_t cut = 1; cut < len; cut++) {
+        std::vector<Point> decoded = decode(buf, cut);
+        bool blnPrefix = decoded.size() <= sent;
+        for (size_t i = 0; blnPrefix && i < decoded.size(); i++) {
+            blnPrefix = samePoint(decoded[i], points[200 + i]);
+        }
+        CHECK(blnPrefix);
+    }
+}
+
+// CWD-- the JSON track publishTrack sends with PUBLISH_BINARY off
+static size_t jsonTrack(const std::vector<Point> &points, size_t from, size_t count, char *buf, size_t capacity, size_t &sent) {
+    JsonWriter json(buf, capacity);
+    json.beginObject().key("t0").number(points[from].time).key("p").beginArray();
+    for (sent = 0; sent < count; sent++) {
+        JsonWriter before = json;
+        const Point &point = points[from + sent];
+        json.beginArray().fixed(point.lat, 7).fixed(point.lon, 7).number(point.time - points[from].time).endArray();
+        if (json.isOverflowed()) {
+            json = before;
+            break;
+        }
+    }
+    json.endArray().endObject();
+    return json.length();
+}
+
+// CWD-- publishTrack's batching: as many points as fit one event, as quoted "z<base85>"
+static void compare(const char *name, const std::vector<Point> &points, size_t batch) {
+    static uint8_t encoded[BENCH_EVENT_MAX];
+    static char text[BENCH_EVENT_MAX];
+    size_t binaryBytes = 0, binaryEvents = 0, jsonBytes = 0, jsonEvents = 0;
+
+    double seconds = benchSeconds([&] {
+        for (size_t from = 0; from < points.size();) {
+            size_t sent;
+            size_t len = encode(points, from, min(batch, points.size() - from), encoded, (BENCH_EVENT_MAX - 4) * 4 / 5, sent);
+            binaryBytes += TelemetryCodec::toText(encoded, len, text, sizeof(text));
+            binaryEvents++;
+            from += sent;
+        }
+    });
+    for (size_t from = 0; from < points.size();) {
+        size_t sent;
+        jsonBytes += jsonTrack(points, from, min(batch, points.size() - from), text, sizeof(text), sent);
+        jsonEvents++;
+        from += sent;
+    }
+
+    printf("%s: %u points, JSON %.1f B/point in %u events, binary %.1f B/point in %u events (%.1fx), %.3f us/point\n", name,
+           (unsigned)points.size(), (double)jsonBytes / points.size(), (unsigned)jsonEvents, (double)binaryBytes / points.size(),
+           (unsigned)binaryEvents, (double)jsonBytes / binaryBytes, seconds * 1e6 / points.size());
+    CHECK((double)jsonBytes / binaryBytes > 3.0);
+}
+
+static void benchCompression() {
+    std::vector<Point> points = replayPoints();
+    compare("raw 1 Hz", points, points.size());
+
+    TrackReplay replay;
+    TrackSimplifier simplifier;
+    std::vector<Point> kept;
+    for (const ReplayFix &fix : replay.drive()) {
+        simplifier.add(fix.point, fix.time);
+        for (size_t i = 0; i < simplifier.getTrackSize(); i++) {
+            const TrackPoint &point = simplifier.getTrack()[i];
+            kept.push_back({point.point.lat, point.point.lon, BENCH_UNIX_MS + point.time});
+        }
+        simplifier.consumeTrack(simplifier.getTrackSize());
+    }
+    compare("simplified", kept, TRACK_BUFFER_SIZE);
+}
+
+int main() {
+    testRoundTrip();
+    testDamage();
+    benchCompression();
+    return testResult();
+}
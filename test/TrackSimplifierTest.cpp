@@ -0,0 +1,84 @@
+// CWD-- the opening-window simplifier over the replayed drive: every dropped fix stays within the tolerance of the
+// polyline that goes out, the output is a time-ordered subset of the input with both ends kept, and the
+// compression and worst error are reported at a few tolerances
+#include "Geodesy.h"
+#include "TestHarness.h"
+#include "TrackReplay.h"
+#include "TrackSimplifier.h"
+
+// CWD-- distance from p to the segment a->b in meters, in double on a projection around a
+static double segmentError(const GeoPoint &a, const GeoPoint &b, const GeoPoint &p) {
+    LocalProjection projection(a);
+    float bx, by, px, py;
+    projection.toLocal(b, bx, by);
+    projection.toLocal(p, px, py);
+    double len2 = (double)bx * bx + (double)by * by;
+    double t = len2 > 0 ? ((double)px * bx + (double)py * by) / len2 : 0;
+    t = fmin(1.0, fmax(0.0, t));
+    double dx = px - t * bx, dy = py - t * by;
+    return sqrt(dx * dx + dy * dy);
+}
+
+// CWD-- run the whole drive through, draining the output buffer the way publishTrack does
+static std::vector<TrackPoint> simplify(TrackSimplifier &simplifier, const std::vector<ReplayFix> &fixes) {
+    std::vector<TrackPoint> kept;
+    auto drain = [&] {
+        for (size_t i = 0; i < simplifier.getTrackSize(); i++) {
+            kept.push_back(simplifier.getTrack()[i]);
+        }
+        simplifier.consumeTrack(simplifier.getTrackSize());
+    };
+    for (const ReplayFix &fix : fixes) {
+        simplifier.add(fix.point, fix.time);
+        if (simplifier.isTrackFull()) {
+            drain();
+        }
+    }
+    simplifier.flush();
+    drain();
+    return kept;
+}
+
+static float testTolerance(float tolerance) {
+    TrackReplay replay;
+    std::vector<ReplayFix> fixes = replay.drive();
+    TrackSimplifier simplifier(tolerance);
+    std::vector<TrackPoint> kept = simplify(simplifier, fixes);
+
+    CHECK(simplifier.getPointsIn() == fixes.size() && simplifier.getPointsOut() == kept.size());
+    CHECK(kept.size() >= 2 && kept.front().time == fixes.front().time && kept.back().time == fixes.back().time);
+
+    // CWD-- walk the input against the output: a kept fix must be an input fix, a dropped one lies between two
+    // kept ones and within the tolerance of the segment joining them
+    size_t next = 0, dropped = 0, outside = 0;
+    double worst = 0;
+    for (const ReplayFix &fix : fixes) {
+        if (next < kept.size() && kept[next].time == fix.time) {
+            CHECK(kept[next].point.lat == fix.point.lat && kept[next].point.lon == fix.point.lon);
+            next++;
+            continue;
+        }
+        dropped++;
+        if (next == 0 || next == kept.size()) {
+            outside++;
+            continue;
+        }
+        double error = segmentError(kept[next - 1].point, kept[next].point, fix.point);
+        worst = fmax(worst, error);
+    }
+    CHECK(next == kept.size() && outside == 0);
+    CHECK(worst <= tolerance + 0.01); // CWD-- float rounding in the simplifier's own projection
+    CHECK(simplifier.getMaxError() <= tolerance);
+
+    printf("tolerance %.0f m: %u points in, %u out (%.1fx), %u dropped, max error %.2f m (simplifier reports %.2f m)\n",
+           tolerance, (unsigned)fixes.size(), (unsigned)kept.size(), simplifier.getCompressionRatio(), (unsigned)dropped, worst,
+           simplifier.getMaxError());
+    return simplifier.getCompressionRatio();
+}
+
+int main() {
+    testTolerance(5.0f);
+    CHECK(testTolerance(TRACK_TOLERANCE_M) > 5.0f); // CWD-- the highway stretch should collapse to a handful of points
+    testTolerance(25.0f);
+    return testResult();
+}
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# Regenerates data/nmea_golden.nmea and prints the counters NmeaTest.cpp checks (GOLDEN_*). The counts come
+# from a model of TinyGPS++'s encode() state machine written independently of the C++ code. Run from test/.
+import os, random, math
+random.seed(38)
+
+def cs(body):
+    p = 0
+    for ch in body.encode(): p ^= ch
+    return p
+
+def sentence(body, lower=False, eol="\r\n"):
+    c = "%02x" % cs(body) if lower else "%02X" % cs(body)
+    return ("$" + body + "*" + c + eol).encode()
+
+def ddmm(v, lat):
+    a = abs(v); d = int(a); m = (a - d) * 60
+    s = ("%02d%08.5f" if lat else "%03d%08.5f") % (d, m)
+    return s, ("N" if v >= 0 else "S") if lat else ("E" if v >= 0 else "W")
+
+out = bytearray()
+lat, lon = 37.7749, -122.4194
+t = 17 * 3600 + 5 * 60
+def hms(t): return "%02d%02d%02d.00" % (t // 3600 % 24, t // 60 % 60, t % 60)
+
+def gsv(talker):
+    res = []
+    n = random.randint(5, 12); msgs = (n + 3) // 4
+    for m in range(msgs):
+        fields = [talker + "GSV", str(msgs), str(m + 1), "%02d" % n]
+        for s in range(m * 4, min(n, m * 4 + 4)):
+            fields += ["%02d" % random.randint(1, 96), "%02d" % random.randint(5, 89), "%03d" % random.randint(0, 359), ("%02d" % random.randint(15, 48)) if random.random() > 0.2 else ""]
+        res.append(sentence(",".join(fields)))
+    return res
+
+# boot: receiver text, no fix yet
+out += sentence("GPTXT,01,01,02,u-blox ag - www.u-blox.com")
+out += sentence("GPTXT,01,01,02,HW UBX-M8030 00080000")
+for i in range(6):
+    out += sentence("GNRMC,%s,V,,,,,,,191026,,,N" % hms(t))
+    out += sentence("GNVTG,,,,,,,,,N")
+    out += sentence("GNGGA,%s,,,,,0,00,99.99,,,,,," % hms(t))
+    out += sentence("GNGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99")
+    for s in gsv("GP"): out += s
+    out += sentence("GNGLL,,,,,%s,V,N" % hms(t))
+    t += 1
+# UBX binary frame between sentences (NAV-PVT header and some payload)
+out += bytes([0xB5, 0x62, 0x01, 0x07, 0x5C, 0x00]) + bytes(random.randrange(256) for _ in range(92)) + bytes([0x3A, 0x9F])
+
+speed = 0.0; course = 90.0
+for i in range(120):
+    speed = min(25.0, speed + 0.4); course = (course + random.uniform(-2, 2)) % 360
+    lat += speed * math.cos(math.radians(course)) / 111195
+    lon += speed * math.sin(math.radians(course)) / (111195 * math.cos(math.radians(lat)))
+    la, ns = ddmm(lat, True); lo, ew = ddmm(lon, False)
+    talker = "GN" if i % 3 else "GP"
+    eol = "\n" if i % 7 == 0 else "\r\n"
+    rmc = "%sRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,191026,,,A" % (talker, hms(t), la, ns, lo, ew, speed / 0.514444, course)
+    gga = "%sGGA,%s,%s,%s,%s,%s,1,%02d,%.2f,%.1f,M,-29.9,M,," % (talker, hms(t), la, ns, lo, ew, random.randint(7, 14), random.uniform(0.7, 1.6), 12.0 + i * 0.1)
+    kind = random.random()
+    if i % 17 == 5:   # corrupted checksum
+        s = sentence(rmc, eol=eol); s = s[:-len(eol) - 2] + (b"00" if s[-len(eol) - 2:-len(eol)] != b"00" else b"11") + eol.encode()
+        out += s
+    elif i % 19 == 7: # corrupted body: a digit of the latitude flipped in transit
+        s = bytearray(sentence(gga, eol=eol)); k = s.index(b",", 8) + 3; s[k] = ord("7") if s[k] != ord("7") else ord("3"); out += s
+    elif i % 23 == 11: # truncated before the checksum, the receiver's buffer overran
+        s = sentence(rmc, eol=eol); out += s[: len(s) // 2] + b"\r\n"
+    elif i % 29 == 13: # truncated inside the checksum
+        s = sentence(gga, eol=eol); out += s[: s.index(b"*") + 2] + b"\r\n"
+    else:
+        out += sentence(rmc, lower=(i % 11 == 0), eol=eol)
+    out += sentence(gga, eol=eol)
+    out += sentence("GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A" % (course, speed / 0.514444, speed * 3.6))
+    if i % 5 == 0:
+        out += sentence("GNGSA,A,3,05,13,15,18,20,24,29,,,,,,1.45,0.82,1.20")
+        for tk in ("GP", "GL", "GA", "GB"):
+            for s in gsv(tk): out += s
+    if i % 13 == 0:
+        out += sentence("PUBX,00,%s,%s,%s,%s,%s,12.3,G3,2.1,2.0,%.3f,%.2f,0.000,,0.92,1.20,0.81,14,0,0" % (hms(t), la, ns, lo, ew, speed * 3.6, course))
+        out += sentence("GLRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,191026,,,A" % (hms(t), la, ns, lo, ew, speed / 0.514444, course))  # talker TinyGPS++ ignores
+    if i % 31 == 3: # line noise
+        out += bytes(random.choice(b"0123456789ABCDEF,.$*\r\n\x00\xff") for _ in range(40))
+    if i % 37 == 20: # overlong field
+        out += sentence("GNTXT,01,01,02,ANTSTATUS=OKANTSTATUS=OKANTSTATUS=OK,extra")
+    t += 1
+# a clean final fix so the golden location is exact
+la, ns = ddmm(lat, True); lo, ew = ddmm(lon, False)
+out += sentence("GNRMC,%s,A,%s,%s,%s,%s,%.3f,%.2f,191026,,,A" % (hms(t), la, ns, lo, ew, 10.0, 45.0))
+out += sentence("GNGGA,%s,%s,%s,%s,%s,1,11,0.90,24.5,M,-29.9,M,," % (hms(t), la, ns, lo, ew))
+path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "nmea_golden.nmea")
+open(path, "wb").write(out)
+print("final fix", la, ns, lo, ew, hms(t))
+
+# model of TinyGPS++ encode(): the term buffer keeps stale bytes past the terminator, and a checksum with one hex
+# digit reads one of them, so the buffer is modelled byte for byte
+data = bytes(out)
+def sc(b): return b - 256 if b > 127 else b
+term = bytearray(15); off = 0; tn = 0; parity = 0; isck = False; typ = 0; hasfix = False
+passed = failed = withfix = 0
+def fromhex(b):
+    a = sc(b)
+    if ord('A') <= a <= ord('F'): return a - ord('A') + 10
+    if ord('a') <= a <= ord('f'): return a - ord('a') + 10
+    return a - ord('0')
+def termstr():
+    return bytes(term[:term.index(0)] if 0 in term[:15] else term)
+def end_of_term():
+    global passed, failed, withfix, typ, hasfix
+    if isck:
+        c = (16 * fromhex(term[0]) + fromhex(term[1])) & 0xFF
+        if c == parity:
+            passed += 1
+            if hasfix: withfix += 1
+        else:
+            failed += 1
+        return
+    if tn == 0:
+        s = termstr()
+        typ = 1 if s in (b"GPRMC", b"GNRMC") else 2 if s in (b"GPGGA", b"GNGGA") else 0
+        return
+    if typ and term[0]:
+        if typ == 1 and tn == 2: hasfix = term[0] == ord('A')
+        if typ == 2 and tn == 6: hasfix = sc(term[0]) > ord('0')
+for b in data:
+    if b == ord(','):
+        parity ^= b
+    if b in b",\r\n*":
+        term[off] = 0
+        end_of_term()
+        tn += 1; off = 0; isck = b == ord('*')
+    elif b == ord('$'):
+        tn = off = 0; parity = 0; typ = 0; isck = False; hasfix = False
+    else:
+        if off < 14:
+            term[off] = b; off += 1
+        if not isck: parity ^= b
+print("GOLDEN_CHARS", len(data), "GOLDEN_PASSED", passed, "GOLDEN_FAILED", failed, "GOLDEN_WITH_FIX", withfix)
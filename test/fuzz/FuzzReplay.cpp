@@ -0,0 +1,72 @@
+// CWD-- runs a libFuzzer entry point without libFuzzer: over the files given on the command line, or by default
+// over the golden corpus, each of its lines, and deterministic mutations of them. Lets the target build and run
+// under gcc (with ASan/UBSan) in the normal ctest pass; real fuzzing needs the clang build, see CMakeLists.txt
+#include <stdint.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define FUZZ_REPLAY_MUTATIONS 20000
+
+static std::string readFile(const char *path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void run(const std::string &input) { LLVMFuzzerTestOneInput((const uint8_t *)input.data(), input.size()); }
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            run(readFile(argv[i]));
+        }
+        printf("replayed %d input(s)\n", argc - 1);
+        return 0;
+    }
+
+    std::string corpus = readFile("data/nmea_golden.nmea");
+    if (corpus.empty()) {
+        printf("data/nmea_golden.nmea not found\n");
+        return 1;
+    }
+    run(corpus);
+
+    std::vector<std::string> lines;
+    for (size_t start = 0, end; start < corpus.size(); start = end + 1) {
+        end = corpus.find('\n', start);
+        end = end == std::string::npos ? corpus.size() - 1 : end;
+        lines.push_back(corpus.substr(start, end - start + 1));
+        run(lines.back());
+    }
+
+    // CWD-- byte flips, special characters dropped in, and splices of two lines at random points
+    uint32_t seed = 38;
+    auto next = [&seed](uint32_t bound) {
+        seed = seed * 1664525UL + 1013904223UL;
+        return (seed >> 8) % bound;
+    };
+    const char specials[] = "$*,\r\n.-0A";
+    for (int i = 0; i < FUZZ_REPLAY_MUTATIONS; i++) {
+        std::string input = lines[next(lines.size())];
+        switch (next(3)) {
+        case 0:
+            input[next(input.size())] ^= (char)(1 << next(8));
+            break;
+        case 1:
+            input.insert(next(input.size() + 1), 1, specials[next(sizeof(specials) - 1)]);
+            break;
+        default:
+            const std::string &other = lines[next(lines.size())];
+            input = input.substr(0, next(input.size() + 1)) + other.substr(next(other.size() + 1));
+        }
+        run(input);
+    }
+
+    printf("replayed the golden corpus, %u lines and %d mutations\n", (unsigned)lines.size(), FUZZ_REPLAY_MUTATIONS);
+    return 0;
+}
@@ -0,0 +1,27 @@
+// CWD-- libFuzzer target for TinyGPSPlus::encode(). Every input is fed byte by byte to a fresh parser; the
+// sanitizers catch memory errors, the checks below catch the counters drifting from what was fed in
+#include <TinyGPS++.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    TinyGPSPlus gps;
+    size_t checksumTerms = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        checksumTerms += data[i] == '*';
+        gps.encode((char)data[i]);
+    }
+
+    // CWD-- every checksum verdict needs a '*', and a fix is only counted on a sentence that passed
+    if (gps.charsProcessed() != size || gps.passedChecksum() + gps.failedChecksum() > checksumTerms || gps.sentencesWithFix() > gps.passedChecksum()) {
+        abort();
+    }
+
+    // CWD-- the accessors run the numeric conversions on whatever was committed
+    volatile double sink = gps.location.lat() + gps.location.lng() + gps.speed.mph() + gps.course.deg() + gps.altitude.feet() + gps.hdop.hdop();
+    sink = sink + gps.date.year() + gps.time.hour() + gps.satellites.value();
+    (void)sink;
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef __HostArduino_h
+#define __HostArduino_h
+
+// CWD-- just enough of the Wiring API for the firmware modules and TinyGPS++ to build natively
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+typedef uint8_t byte;
+
+#ifndef TWO_PI
+#define TWO_PI (2.0 * M_PI)
+#endif
+#define radians(deg) ((deg) * M_PI / 180.0)
+#define degrees(rad) ((rad) * 180.0 / M_PI)
+#define sq(x) ((x) * (x))
+
+using std::max;
+using std::min;
+
+#define INPUT 0
+#define RISING 1
+#define HOST_PIN_COUNT 24
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void pinMode(int pin, int mode);
+void attachInterrupt(int pin, void (*handler)(), int mode);
+
+// CWD-- the host clock only moves when a test moves it, and interrupts only fire when a test fires them
+void hostSetMillis(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+void hostSetMicros(uint64_t us);
+void hostAdvanceMicros(uint64_t us);
+void hostFireInterrupt(int pin);
+
+#endif // def(__HostArduino_h)
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef __HostCellular_h
+#define __HostCellular_h
+
+// CWD-- the slice of the Device OS cellular API CellularHelper compiles against, with Cellular.command() played
+// back from a captured AT transcript. Only pulled in by Particle.h when Wiring_Cellular is set
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#define SYSTEM_VERSION 0
+
+enum {
+    TYPE_UNKNOWN = 0x000000,
+    TYPE_OK = 0x110000,
+    TYPE_ERROR = 0x120000,
+    TYPE_RING = 0x210000,
+    TYPE_CONNECT = 0x220000,
+    TYPE_NOCARRIER = 0x230000,
+    TYPE_NODIALTONE = 0x240000,
+    TYPE_BUSY = 0x250000,
+    TYPE_NOANSWER = 0x260000,
+    TYPE_PROMPT = 0x300000,
+    TYPE_PLUS = 0x400000,
+    TYPE_TEXT = 0x500000,
+    TYPE_ABORTED = 0x600000
+};
+enum { NOT_FOUND = 0, WAIT = -1, RESP_OK = -2, RESP_ERROR = -3, RESP_PROMPT = -4, RESP_ABORTED = -5 };
+
+typedef enum {
+    NET_ACCESS_TECHNOLOGY_UNKNOWN = 0,
+    NET_ACCESS_TECHNOLOGY_WIFI = 1,
+    NET_ACCESS_TECHNOLOGY_GSM = 2,
+    NET_ACCESS_TECHNOLOGY_EDGE = 3,
+    NET_ACCESS_TECHNOLOGY_UMTS = 4,
+    NET_ACCESS_TECHNOLOGY_LTE = 7,
+    NET_ACCESS_TECHNOLOGY_LTE_CAT_M1 = 8,
+    NET_ACCESS_TECHNOLOGY_LTE_CAT_NB1 = 9
+} hal_net_access_tech_t;
+
+class CellularSignal {
+  public:
+    hal_net_access_tech_t getAccessTechnology() const { return NET_ACCESS_TECHNOLOGY_UNKNOWN; }
+};
+
+#define CGI_VERSION_LATEST 1
+#define SYSTEM_ERROR_NONE 0
+typedef int cellular_result_t;
+
+struct CellularGlobalIdentity {
+    uint16_t size;
+    uint16_t version;
+    uint16_t mobile_country_code;
+    uint16_t mobile_network_code;
+    uint16_t location_area_code;
+    uint32_t cell_id;
+};
+static inline cellular_result_t cellular_global_identity(CellularGlobalIdentity *cgi, void *reserved) { return -1; }
+
+enum { DEV_UNKNOWN, DEV_SARA_G350, DEV_SARA_U260, DEV_SARA_U270, DEV_SARA_U201, DEV_SARA_R410 };
+struct CellularDevice {
+    uint16_t size;
+    int dev;
+};
+static inline int cellular_device_info(CellularDevice *info, void *reserved) { return -1; }
+
+// CWD-- replays a transcript the way Device OS's modem parser delivers it: one callback per line, wrapped in
+// CR LF, typed by how the line starts. The final OK/ERROR is the command's result
+class HostCellular {
+  public:
+    void expect(const char *command, const char *transcript) {
+        strCommand = command;
+        strTranscript = transcript;
+    }
+
+    const std::string &getLastCommand() { return strLastCommand; }
+
+    template <class T> int command(int (*callback)(int, const char *, int, T *), T *param, system_tick_t timeout, const char *fmt, ...) {
+        char buf[128];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        strLastCommand = buf;
+        if (strLastCommand != strCommand) {
+            return RESP_ERROR;
+        }
+
+        for (size_t start = 0; start < strTranscript.size();) {
+            size_t end = strTranscript.find('\n', start);
+            end = end == std::string::npos ? strTranscript.size() : end;
+            std::string line = strTranscript.substr(start, end - start);
+            start = end + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            if (line == "OK") {
+                return RESP_OK;
+            }
+            if (line == "ERROR") {
+                return RESP_ERROR;
+            }
+            std::string chunk = "\r\n" + line + "\r\n";
+            callback(line[0] == '+' ? TYPE_PLUS : TYPE_UNKNOWN, chunk.c_str(), (int)chunk.size(), param);
+        }
+        return RESP_ABORTED;
+    }
+
+    int command(system_tick_t timeout, const char *fmt, ...) { return RESP_OK; }
+    int command(const char *fmt, ...) { return RESP_OK; }
+    CellularSignal RSSI() { return CellularSignal(); }
+
+  private:
+    std::string strCommand;
+    std::string strTranscript;
+    std::string strLastCommand;
+};
+extern HostCellular Cellular;
+
+#endif // def(__HostCellular_h)
@@ -0,0 +1,39 @@
+#include "Particle.h"
+
+HostLogger Log;
+HostEEPROM EEPROM;
+HostTime Time;
+HostCloud Particle;
+HostWiFi WiFi;
+
+// CWD-- one microsecond clock behind both: millis() counts on from it and micros() wraps at 32 bits like the device's
+static uint64_t ullHostMicros = 0;
+static void (*hostInterrupts[HOST_PIN_COUNT])() = {};
+
+unsigned long millis() { return (unsigned long)(ullHostMicros / 1000); }
+
+unsigned long micros() { return (uint32_t)ullHostMicros; }
+
+void delay(unsigned long ms) { ullHostMicros += (uint64_t)ms * 1000; }
+
+void pinMode(int pin, int mode) {}
+
+void attachInterrupt(int pin, void (*handler)(), int mode) {
+    if (pin >= 0 && pin < HOST_PIN_COUNT) {
+        hostInterrupts[pin] = handler;
+    }
+}
+
+void hostSetMillis(unsigned long ms) { ullHostMicros = (uint64_t)ms * 1000; }
+
+void hostAdvanceMillis(unsigned long ms) { ullHostMicros += (uint64_t)ms * 1000; }
+
+void hostSetMicros(uint64_t us) { ullHostMicros = us; }
+
+void hostAdvanceMicros(uint64_t us) { ullHostMicros += us; }
+
+void hostFireInterrupt(int pin) {
+    if (pin >= 0 && pin < HOST_PIN_COUNT && hostInterrupts[pin]) {
+        hostInterrupts[pin]();
+    }
+}
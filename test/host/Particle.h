@@ -0,0 +1,115 @@
+#pragma once
+#ifndef __HostParticle_h
+#define __HostParticle_h
+
+#include "Arduino.h"
+
+#include <stdarg.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+typedef uint32_t system_tick_t;
+
+class String {
+  public:
+    String() {}
+    String(const char *str) : s(str ? str : "") {}
+    explicit String(int value) : s(std::to_string(value)) {}
+    const char *c_str() const { return s.c_str(); }
+    unsigned length() const { return s.size(); }
+    operator const char *() const { return s.c_str(); }
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator!=(const String &other) const { return s != other.s; }
+    String &operator+=(const char *str) { s += str; return *this; }
+    friend String operator+(const char *left, const String &right) { return String((left + right.s).c_str()); }
+    bool concat(char c) { s += c; return true; }
+    bool concat(const char *str) { s += str; return true; }
+    bool reserve(unsigned size) { s.reserve(size); return true; }
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    char charAt(unsigned index) const { return index < s.size() ? s[index] : 0; }
+
+    static String format(const char *fmt, ...) {
+        char buf[256];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        return String(buf);
+    }
+
+  private:
+    std::string s;
+};
+
+class HostLogger {
+  public:
+    void trace(const char *fmt, ...) {}
+    void info(const char *fmt, ...) {}
+    void warn(const char *fmt, ...) {}
+    void error(const char *fmt, ...) {}
+};
+extern HostLogger Log;
+
+// CWD-- EEPROM backed by a RAM image the tests can inspect or corrupt
+class HostEEPROM {
+  public:
+    template <class T> T &get(int address, T &value) {
+        memcpy(&value, image + address, sizeof(T));
+        return value;
+    }
+    template <class T> const T &put(int address, const T &value) {
+        memcpy(image + address, &value, sizeof(T));
+        writes++;
+        return value;
+    }
+    size_t length() { return sizeof(image); }
+    void clear() { memset(image, 0xFF, sizeof(image)); }
+
+    uint8_t image[4096];
+    uint32_t writes = 0;
+};
+extern HostEEPROM EEPROM;
+
+class HostTime {
+  public:
+    time_t now() { return unixTime; }
+    bool isValid() { return unixTime != 0; }
+    void setTime(time_t time) { unixTime = time; }
+
+    time_t unixTime = 0;
+};
+extern HostTime Time;
+
+// CWD-- the cloud connection. Tests flip it up and down and read back what got published
+class HostCloud {
+  public:
+    bool connected() { return blnConnected; }
+    bool publish(const char *event, const char *data) {
+        if (!blnConnected) {
+            return false;
+        }
+        published.push_back(std::string(event) + " " + data);
+        return true;
+    }
+    int maxEventDataSize() { return 1024; }
+
+    bool blnConnected = false;
+    std::vector<std::string> published;
+};
+extern HostCloud Particle;
+
+class HostWiFi {
+  public:
+    int RSSI() { return iRSSI; }
+
+    int iRSSI = 0;
+};
+extern HostWiFi WiFi;
+
+#if Wiring_Cellular
+#include "HostCellular.h"
+#endif
+
+#endif // def(__HostParticle_h)
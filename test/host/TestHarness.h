@@ -0,0 +1,50 @@
+#pragma once
+#ifndef __TestHarness_h
+#define __TestHarness_h
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+// CWD-- no framework, just checks that count failures. A test's main() returns testResult() for ctest
+static int iTestFailures = 0;
+
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                                            \
+            iTestFailures++;                                                                                           \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                                        \
+    do {                                                                                                               \
+        double dblActual = (actual), dblExpected = (expected);                                                         \
+        if (!(fabs(dblActual - dblExpected) <= (tolerance))) {                                                         \
+            printf("%s:%d: %s = %.9g, expected %.9g +/- %g\n", __FILE__, __LINE__, #actual, dblActual, dblExpected,   \
+                   (double)(tolerance));                                                                               \
+            iTestFailures++;                                                                                           \
+        }                                                                                                              \
+    } while (0)
+
+static inline int testResult() {
+    if (iTestFailures) {
+        printf("%d check(s) failed\n", iTestFailures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
+
+// CWD-- wall time of fn() in seconds, for the benchmarks
+template <class F> static double benchSeconds(F fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// CWD-- keeps the optimizer from deleting benchmark loops whose results are otherwise unused
+template <class T> static inline void benchKeep(const T &value) { asm volatile("" : : "g"(&value) : "memory"); }
+
+#endif // def(__TestHarness_h)
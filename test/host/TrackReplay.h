@@ -0,0 +1,80 @@
+#pragma once
+#ifndef __TrackReplay_h
+#define __TrackReplay_h
+
+#include "GeoPoint.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#define TRACK_REPLAY_UERE_M 3.0f // per-axis receiver noise at HDOP 1
+
+// CWD-- deterministic synthetic drive standing in for a recorded one: parked with GPS jitter, pull out,
+// city blocks with turns and a stop, then a long gently curving highway stretch, then parked again.
+// One fix a second with a little timing jitter, like the receiver delivers them
+struct ReplayFix {
+    GeoPoint truth; // where the vehicle really was
+    GeoPoint point; // what the receiver reported
+    unsigned long time = 0;
+    float speed = 0;  // m/s, true
+    float course = 0; // degrees
+    uint16_t hdop = 100;
+};
+
+class TrackReplay {
+  public:
+    explicit TrackReplay(uint32_t seed = 1) : ulSeed(seed) {}
+
+    // CWD-- uniform in [-1, 1]
+    float noise() {
+        ulSeed = ulSeed * 1664525UL + 1013904223UL;
+        return (float)((ulSeed >> 8) & 0xFFFF) / 32767.5f - 1.0f;
+    }
+
+    // CWD-- roughly normal with unit sigma (sum of three uniforms)
+    float gaussian() { return (noise() + noise() + noise()); }
+
+    std::vector<ReplayFix> drive(double lat = 37.7749, double lon = -122.4194, unsigned long start = 1000) {
+        std::vector<ReplayFix> fixes;
+        double north = 0, east = 0, course = 90, speed = 0;
+        unsigned long time = start;
+
+        // CWD-- (seconds, target speed m/s, turn rate deg/s)
+        const float segments[][3] = {{120, 0, 0},  {20, 10, 0}, {40, 12, 0},  {10, 5, 9},   {40, 12, 0},  {15, 0, 0},
+                                     {30, 0, 0},   {20, 12, 0}, {10, 5, -9},  {60, 14, 0},  {30, 25, 0},  {600, 30, 0.05f},
+                                     {300, 30, -0.08f}, {30, 10, 0}, {10, 4, 9}, {20, 0, 0}, {180, 0, 0}};
+
+        for (const auto &segment : segments) {
+            for (int s = 0; s < (int)segment[0]; s++) {
+                speed += fmax(-3.0, fmin(2.5, segment[1] - speed));
+                course = fmod(course + (speed > 1 ? segment[2] : 0) + 360.0, 360.0);
+                north += speed * cos(course * M_PI / 180.0);
+                east += speed * sin(course * M_PI / 180.0);
+                time += 1000 + (int)(noise() * 40);
+
+                ReplayFix fix;
+                fix.truth = toPoint(lat, lon, north, east);
+                fix.hdop = 90 + (uint16_t)((noise() + 1) * 40);
+                float sigma = TRACK_REPLAY_UERE_M * fix.hdop / 100.0f;
+                fix.point = toPoint(lat, lon, north + gaussian() * sigma, east + gaussian() * sigma);
+                fix.time = time;
+                fix.speed = (float)speed;
+                fix.course = (float)course;
+                fixes.push_back(fix);
+            }
+        }
+        return fixes;
+    }
+
+    static GeoPoint toPoint(double lat, double lon, double north, double east) {
+        double latitude = lat + north / 111194.93;
+        double longitude = lon + east / (111194.93 * cos(latitude * M_PI / 180.0));
+        return GeoPoint::fromDegrees(latitude, longitude);
+    }
+
+  private:
+    uint32_t ulSeed;
+};
+
+#endif // def(__TrackReplay_h)